@@ -0,0 +1,384 @@
+//
+//  MidiClipLoader.cpp
+//  Midiot
+//
+//  Created by Sean Bratnober on 3/6/18.
+//
+//
+
+#include "MidiClipLoader.hpp"
+#include "MidiClipModel.hpp"
+
+namespace
+{
+    const int num_note_slots = 16 * num_midi_notes_;
+    
+    // false if the number runs off the end of the data
+    bool readVariableLength(const uint8* data, size_t size, size_t& pos, uint32& value)
+    {
+        value = 0;
+        
+        for (int i=0; i<4; i++)
+        {
+            if (pos >= size)
+            {
+                return false;
+            }
+            
+            const uint8 byte = data[pos++];
+            value = (value << 7) | (byte & 0x7f);
+            
+            if ((byte & 0x80) == 0)
+            {
+                return true;
+            }
+        }
+        
+        return false;
+    }
+}
+
+MidiClipLoader::MidiClipLoader(MidiClipModel& clip_model, Listener* listener)
+: Thread("MidiClipLoader"),
+clip_model_(clip_model),
+listener_(listener),
+loading_(false),
+published_time_format_(0),
+load_finished_(false),
+load_succeeded_(false),
+num_published_notes_(0)
+{
+}
+
+MidiClipLoader::~MidiClipLoader()
+{
+    stopThread(MIDI_CLIP_LOAD_STOP_TIMEOUT_MS);
+    cancelPendingUpdate();
+}
+
+void MidiClipLoader::cancelLoad()
+{
+    stopThread(MIDI_CLIP_LOAD_STOP_TIMEOUT_MS);
+    cancelPendingUpdate();
+    
+    {
+        const ScopedLock sl(publish_lock_);
+        
+        published_notes_.clearQuick();
+        published_time_format_ = 0;
+        load_finished_ = false;
+    }
+    
+    loading_ = false;
+}
+
+void MidiClipLoader::loadFile(const File& midi_file)
+{
+    cancelLoad();
+    
+    clip_model_.clear();
+    
+    midi_file_ = midi_file;
+    parsed_notes_.clearQuick();
+    num_published_notes_ = 0;
+    loading_ = true;
+    
+    startThread();
+}
+
+void MidiClipLoader::run()
+{
+    bool succeeded = false;
+    
+    MemoryMappedFile mapped_file(midi_file_, MemoryMappedFile::readOnly);
+    
+    if (mapped_file.getData() != nullptr)
+    {
+        succeeded = parseFile((const uint8*)mapped_file.getData(), mapped_file.getSize());
+    }
+    else
+    {
+        // some filesystems can't be mapped
+        MemoryBlock file_data;
+        
+        if (midi_file_.loadFileAsData(file_data))
+        {
+            succeeded = parseFile((const uint8*)file_data.getData(), file_data.getSize());
+        }
+    }
+    
+    // cancelLoad() throws away whatever was parsed
+    if (threadShouldExit())
+    {
+        return;
+    }
+    
+    publishNotes(true, succeeded);
+}
+
+bool MidiClipLoader::parseFile(const uint8* data, size_t size)
+{
+    if (size < 14 || memcmp(data, "MThd", 4) != 0)
+    {
+        return false;
+    }
+    
+    const uint32 header_size = ByteOrder::bigEndianInt(data + 4);
+    
+    if (header_size < 6 || header_size > size - 8)
+    {
+        return false;
+    }
+    
+    {
+        const ScopedLock sl(publish_lock_);
+        published_time_format_ = (short)ByteOrder::bigEndianShort(data + 12);
+    }
+    
+    size_t pos = 8 + header_size;
+    int num_tracks = 0;
+    
+    while (pos + 8 <= size)
+    {
+        const uint8* chunk = data + pos;
+        // a truncated last chunk is read as far as it goes
+        const size_t chunk_size = jmin((size_t)ByteOrder::bigEndianInt(chunk + 4), size - pos - 8);
+        
+        if (memcmp(chunk, "MTrk", 4) == 0)
+        {
+            if (!parseTrack(chunk + 8, chunk_size))
+            {
+                return false;
+            }
+            
+            num_tracks++;
+        }
+        
+        pos += 8 + chunk_size;
+    }
+    
+    return num_tracks > 0;
+}
+
+bool MidiClipLoader::parseTrack(const uint8* data, size_t size)
+{
+    // note on time and velocity for each channel and note, -1 when off
+    int open_note_times[num_note_slots];
+    uint8 open_note_velocities[num_note_slots];
+    
+    for (int i=0; i<num_note_slots; i++)
+    {
+        open_note_times[i] = -1;
+    }
+    
+    size_t pos = 0;
+    int64 time = 0;
+    uint8 running_status = 0;
+    int num_events = 0;
+    
+    while (pos < size)
+    {
+        if ((++num_events & 0xfff) == 0 && threadShouldExit())
+        {
+            return false;
+        }
+        
+        uint32 delta_time;
+        
+        if (!readVariableLength(data, size, pos, delta_time) || pos >= size)
+        {
+            break;
+        }
+        
+        time = jmin(time + delta_time, (int64)std::numeric_limits<int>::max());
+        
+        uint8 status = data[pos];
+        
+        if (status & 0x80)
+        {
+            pos++;
+        }
+        else if (running_status != 0)
+        {
+            status = running_status;
+        }
+        else
+        {
+            return false;
+        }
+        
+        if (status == 0xff)
+        {
+            // meta event
+            uint32 length;
+            
+            if (pos >= size)
+            {
+                break;
+            }
+            
+            const uint8 meta_type = data[pos++];
+            
+            if (!readVariableLength(data, size, pos, length) || meta_type == 0x2f)
+            {
+                break;
+            }
+            
+            pos += length;
+            continue;
+        }
+        
+        if (status == 0xf0 || status == 0xf7)
+        {
+            uint32 length;
+            
+            if (!readVariableLength(data, size, pos, length))
+            {
+                break;
+            }
+            
+            pos += length;
+            running_status = 0;
+            continue;
+        }
+        
+        if (status > 0xf0)
+        {
+            // not allowed in a file
+            return false;
+        }
+        
+        running_status = status;
+        
+        // program change and channel pressure have one data byte
+        const size_t num_data_bytes = ((status & 0xe0) == 0xc0) ? 1 : 2;
+        
+        if (pos + num_data_bytes > size)
+        {
+            break;
+        }
+        
+        const int message_type = status & 0xf0;
+        const int channel = status & 0x0f;
+        
+        if (message_type == 0x80 || message_type == 0x90)
+        {
+            const int note_num = data[pos] & 0x7f;
+            const uint8 velocity = data[pos + 1] & 0x7f;
+            const int slot = channel * num_midi_notes_ + note_num;
+            
+            // a repeated note on ends the one before it
+            if (open_note_times[slot] >= 0)
+            {
+                addParsedNote(MIDINote(note_num,
+                                       open_note_velocities[slot],
+                                       open_note_times[slot],
+                                       (int)time,
+                                       channel + 1));
+                open_note_times[slot] = -1;
+            }
+            
+            if (message_type == 0x90 && velocity > 0)
+            {
+                open_note_times[slot] = (int)time;
+                open_note_velocities[slot] = velocity;
+            }
+        }
+        
+        pos += num_data_bytes;
+    }
+    
+    // notes still sounding end with the track
+    for (int slot=0; slot<num_note_slots; slot++)
+    {
+        if (open_note_times[slot] >= 0)
+        {
+            addParsedNote(MIDINote(slot % num_midi_notes_,
+                                   open_note_velocities[slot],
+                                   open_note_times[slot],
+                                   (int)time,
+                                   slot / num_midi_notes_ + 1));
+        }
+    }
+    
+    // each track shows up as soon as it's read
+    publishNotes(false, false);
+    
+    return true;
+}
+
+void MidiClipLoader::addParsedNote(const MIDINote& note)
+{
+    parsed_notes_.add(note);
+    
+    // growing batches keep the clip's merges linear overall
+    if (parsed_notes_.size() >= jmax(MIDI_CLIP_LOAD_MIN_BATCH_NOTES, num_published_notes_ / 2))
+    {
+        publishNotes(false, false);
+    }
+}
+
+void MidiClipLoader::publishNotes(bool load_finished, bool load_succeeded)
+{
+    {
+        const ScopedLock sl(publish_lock_);
+        
+        published_notes_.addArray(parsed_notes_);
+        
+        if (load_finished)
+        {
+            load_finished_ = true;
+            load_succeeded_ = load_succeeded;
+        }
+    }
+    
+    num_published_notes_ += parsed_notes_.size();
+    parsed_notes_.clearQuick();
+    
+    triggerAsyncUpdate();
+}
+
+void MidiClipLoader::handleAsyncUpdate()
+{
+    Array<MIDINote> notes;
+    short time_format;
+    bool load_finished;
+    bool load_succeeded;
+    
+    {
+        const ScopedLock sl(publish_lock_);
+        
+        notes.swapWith(published_notes_);
+        time_format = published_time_format_;
+        load_finished = load_finished_;
+        load_succeeded = load_succeeded_;
+        load_finished_ = false;
+    }
+    
+    if (time_format != 0)
+    {
+        clip_model_.setTimeFormat(time_format);
+    }
+    
+    if (notes.size() > 0)
+    {
+        clip_model_.beginTransaction();
+        
+        for (int i=0; i<notes.size(); i++)
+        {
+            clip_model_.addNote(notes.getReference(i));
+        }
+        
+        clip_model_.endTransaction();
+    }
+    
+    if (load_finished)
+    {
+        loading_ = false;
+        
+        if (listener_)
+        {
+            listener_->clipLoadFinished(midi_file_, load_succeeded);
+        }
+    }
+}
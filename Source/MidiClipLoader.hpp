@@ -0,0 +1,79 @@
+//
+//  MidiClipLoader.hpp
+//  Midiot
+//
+//  Created by Sean Bratnober on 3/6/18.
+//
+//
+
+#ifndef MidiClipLoader_hpp
+#define MidiClipLoader_hpp
+
+#include <stdio.h>
+#include "../JuceLibraryCode/JuceHeader.h"
+
+#include "NoteGridProperties.hpp"
+
+class MidiClipModel;
+
+// a batch is at least this many notes, or half of what's already loaded
+const int MIDI_CLIP_LOAD_MIN_BATCH_NOTES = 4096;
+const int MIDI_CLIP_LOAD_STOP_TIMEOUT_MS = 2000;
+
+// Reads a standard MIDI file into a MidiClipModel on a background thread.
+// Every track is parsed in a single pass over the memory-mapped file, with
+// note ons paired to their note offs as they are read. Notes reach the
+// clip in growing batches on the message thread while the parse goes on,
+// so a big file fills in progressively and the UI never waits on the
+// disk. The notes of all tracks go into the one clip, keeping their
+// channels, timed in the file's ticks.
+class MidiClipLoader : private Thread,
+                       private AsyncUpdater
+{
+public:
+    class Listener
+    {
+    public:
+        virtual ~Listener() {}
+        
+        virtual void clipLoadFinished(const File& midi_file, bool succeeded) = 0;
+    };
+    
+    MidiClipLoader(MidiClipModel& clip_model, Listener* listener = NULL);
+    ~MidiClipLoader();
+    
+    // Message thread. Clears the clip, dropping a load still in progress.
+    void loadFile(const File& midi_file);
+    void cancelLoad();
+    bool isLoading() const { return loading_; }
+    
+private:
+    void run() override;
+    bool parseFile(const uint8* data, size_t size);
+    bool parseTrack(const uint8* data, size_t size);
+    void addParsedNote(const MIDINote& note);
+    // hands the parsed notes to the message thread
+    void publishNotes(bool load_finished, bool load_succeeded);
+    void handleAsyncUpdate() override;
+    
+    MidiClipModel& clip_model_;
+    Listener* listener_;
+    
+    // only changed while the thread is stopped
+    File midi_file_;
+    bool loading_;
+    
+    CriticalSection publish_lock_;
+    Array<MIDINote> published_notes_;
+    short published_time_format_;
+    bool load_finished_;
+    bool load_succeeded_;
+    
+    // loader thread
+    Array<MIDINote> parsed_notes_;
+    int num_published_notes_;
+    
+    JUCE_DECLARE_NON_COPYABLE(MidiClipLoader)
+};
+
+#endif /* MidiClipLoader_hpp */
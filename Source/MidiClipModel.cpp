@@ -0,0 +1,447 @@
+//
+//  MidiClipModel.cpp
+//  Midiot
+//
+//  Created by Sean Bratnober on 3/4/18.
+//
+//
+
+#include "MidiClipModel.hpp"
+#include "MidiotFileUtils.hpp"
+
+int MidiClipModel::PendingNoteSorter::compareElements(const PendingNote& note_a, const PendingNote& note_b)
+{
+    return compareNoteKeys(note_a.note.note_on_time_, note_a.note.note_num_, note_a.note_id,
+                           note_b.note.note_on_time_, note_b.note.note_num_, note_b.note_id);
+}
+
+int MidiClipModel::compareNoteKeys(int note_on_time_a, int note_num_a, int note_id_a,
+                                   int note_on_time_b, int note_num_b, int note_id_b)
+{
+    if (note_on_time_a != note_on_time_b)
+    {
+        return (note_on_time_a < note_on_time_b) ? -1 : 1;
+    }
+    
+    if (note_num_a != note_num_b)
+    {
+        return (note_num_a < note_num_b) ? -1 : 1;
+    }
+    
+    if (note_id_a != note_id_b)
+    {
+        return (note_id_a < note_id_b) ? -1 : 1;
+    }
+    
+    return 0;
+}
+
+MidiClipModel::MidiClipModel()
+: transaction_depth_(0),
+next_note_id_(0),
+note_id_epoch_(0),
+time_format_(MIDI_CLIP_DEFAULT_TIME_FORMAT)
+{
+}
+
+MidiClipModel::~MidiClipModel()
+{
+}
+
+MIDINote MidiClipModel::getNote(int note_index) const
+{
+    return MIDINote(note_nums_.getUnchecked(note_index),
+                    velocities_.getUnchecked(note_index),
+                    note_on_times_.getUnchecked(note_index),
+                    note_off_times_.getUnchecked(note_index),
+                    channels_.getUnchecked(note_index));
+}
+
+int MidiClipModel::indexOfNoteId(int note_id) const
+{
+    if (!isPositiveAndBelow(note_id, note_indices_.size()))
+    {
+        return -1;
+    }
+    
+    return note_indices_.getUnchecked(note_id);
+}
+
+void MidiClipModel::beginTransaction()
+{
+    transaction_depth_++;
+}
+
+void MidiClipModel::endTransaction()
+{
+    jassert(transaction_depth_ > 0);
+    
+    if (transaction_depth_ > 0 && --transaction_depth_ == 0 && applyPendingEdits())
+    {
+        listeners_.call(&Listener::clipNotesChanged, this);
+    }
+}
+
+void MidiClipModel::addPendingNote(int note_id, const MIDINote& note)
+{
+    PendingNote pending_note;
+    pending_note.note_id = note_id;
+    pending_note.note = note;
+    pending_note.removed = false;
+    
+    pending_note_indices_.set(note_id, pending_notes_.size());
+    pending_notes_.add(pending_note);
+}
+
+int MidiClipModel::addNote(const MIDINote& note)
+{
+    const int note_id = next_note_id_++;
+    
+    note_indices_.add(-1);
+    pending_note_indices_.add(-1);
+    
+    beginTransaction();
+    addPendingNote(note_id, note);
+    endTransaction();
+    
+    return note_id;
+}
+
+void MidiClipModel::moveNote(int note_id, const MIDINote& note)
+{
+    if (!isPositiveAndBelow(note_id, next_note_id_))
+    {
+        return;
+    }
+    
+    beginTransaction();
+    
+    const int pending_index = pending_note_indices_.getUnchecked(note_id);
+    
+    if (pending_index >= 0)
+    {
+        PendingNote& pending_note = pending_notes_.getReference(pending_index);
+        
+        if (!pending_note.removed)
+        {
+            pending_note.note = note;
+        }
+    }
+    else if (indexOfNoteId(note_id) >= 0)
+    {
+        pending_removals_.add(note_id);
+        addPendingNote(note_id, note);
+    }
+    
+    endTransaction();
+}
+
+void MidiClipModel::removeNote(int note_id)
+{
+    if (!isPositiveAndBelow(note_id, next_note_id_))
+    {
+        return;
+    }
+    
+    beginTransaction();
+    
+    if (pending_note_indices_.getUnchecked(note_id) < 0 && indexOfNoteId(note_id) >= 0)
+    {
+        // a placeholder, so later edits in the transaction see it's gone
+        pending_removals_.add(note_id);
+        addPendingNote(note_id, MIDINote());
+    }
+    
+    const int pending_index = pending_note_indices_.getUnchecked(note_id);
+    
+    if (pending_index >= 0)
+    {
+        pending_notes_.getReference(pending_index).removed = true;
+    }
+    
+    endTransaction();
+}
+
+void MidiClipModel::clear()
+{
+    beginTransaction();
+    
+    for (int i=0; i<pending_notes_.size(); i++)
+    {
+        pending_notes_.getReference(i).removed = true;
+    }
+    
+    for (int i=0; i<note_ids_.size(); i++)
+    {
+        removeNote(note_ids_.getUnchecked(i));
+    }
+    
+    endTransaction();
+}
+
+bool MidiClipModel::applyPendingEdits()
+{
+    if (pending_notes_.size() == 0 && pending_removals_.size() == 0)
+    {
+        return false;
+    }
+    
+    Array<PendingNote> added_notes;
+    added_notes.ensureStorageAllocated(pending_notes_.size());
+    
+    for (int i=0; i<pending_notes_.size(); i++)
+    {
+        const PendingNote& pending_note = pending_notes_.getReference(i);
+        
+        pending_note_indices_.set(pending_note.note_id, -1);
+        
+        if (!pending_note.removed)
+        {
+            added_notes.add(pending_note);
+        }
+    }
+    
+    PendingNoteSorter note_sorter;
+    added_notes.sort(note_sorter);
+    
+    int first_changed_index = 0;
+    
+    // a few edits shift the arrays in place; a big one (a clear, a
+    // loaded file, a drag of many notes) is one merge into new arrays
+    if (pending_removals_.size() + added_notes.size() <= MIDI_CLIP_MAX_IN_PLACE_EDITS)
+    {
+        applyEditsInPlace(added_notes, first_changed_index);
+    }
+    else
+    {
+        mergeEdits(added_notes);
+    }
+    
+    // moved notes get their new index back below
+    for (int i=0; i<pending_removals_.size(); i++)
+    {
+        note_indices_.set(pending_removals_.getUnchecked(i), -1);
+    }
+    
+    for (int i=first_changed_index; i<note_ids_.size(); i++)
+    {
+        note_indices_.set(note_ids_.getUnchecked(i), i);
+    }
+    
+    pending_notes_.clearQuick();
+    pending_removals_.clearQuick();
+    
+    if (note_ids_.size() == 0)
+    {
+        // no note is left to hold an old id, so start again rather than
+        // let note_indices_ grow with every clear and reload
+        note_indices_.clearQuick();
+        pending_note_indices_.clearQuick();
+        next_note_id_ = 0;
+        note_id_epoch_++;
+    }
+    
+    return true;
+}
+
+void MidiClipModel::applyEditsInPlace(const Array<PendingNote>& added_notes, int& first_changed_index)
+{
+    first_changed_index = note_ids_.size();
+    
+    Array<int> removed_indices;
+    
+    for (int i=0; i<pending_removals_.size(); i++)
+    {
+        const int note_index = indexOfNoteId(pending_removals_.getUnchecked(i));
+        
+        if (note_index >= 0)
+        {
+            removed_indices.add(note_index);
+        }
+    }
+    
+    // from the back, so the indices still to go stay put
+    removed_indices.sort();
+    
+    for (int i=removed_indices.size()-1; i>=0; i--)
+    {
+        const int note_index = removed_indices.getUnchecked(i);
+        
+        note_ids_.remove(note_index);
+        note_nums_.remove(note_index);
+        velocities_.remove(note_index);
+        note_on_times_.remove(note_index);
+        note_off_times_.remove(note_index);
+        channels_.remove(note_index);
+        
+        first_changed_index = jmin(first_changed_index, note_index);
+    }
+    
+    for (int i=0; i<added_notes.size(); i++)
+    {
+        const PendingNote& added_note = added_notes.getReference(i);
+        const int note_index = findNoteInsertIndex(added_note);
+        
+        note_ids_.insert(note_index, added_note.note_id);
+        note_nums_.insert(note_index, added_note.note.note_num_);
+        velocities_.insert(note_index, added_note.note.velocity_);
+        note_on_times_.insert(note_index, added_note.note.note_on_time_);
+        note_off_times_.insert(note_index, added_note.note.note_off_time_);
+        channels_.insert(note_index, added_note.note.channel_);
+        
+        first_changed_index = jmin(first_changed_index, note_index);
+    }
+}
+
+int MidiClipModel::findNoteInsertIndex(const PendingNote& added_note) const
+{
+    int start = 0;
+    int end = note_ids_.size();
+    
+    while (start < end)
+    {
+        const int middle = (start + end) / 2;
+        
+        if (compareNoteKeys(note_on_times_.getUnchecked(middle),
+                            note_nums_.getUnchecked(middle),
+                            note_ids_.getUnchecked(middle),
+                            added_note.note.note_on_time_,
+                            added_note.note.note_num_,
+                            added_note.note_id) < 0)
+        {
+            start = middle + 1;
+        }
+        else
+        {
+            end = middle;
+        }
+    }
+    
+    return start;
+}
+
+void MidiClipModel::mergeEdits(const Array<PendingNote>& added_notes)
+{
+    const int num_notes = note_ids_.size();
+    HeapBlock<bool> removed((size_t)jmax(1, num_notes), true);
+    
+    for (int i=0; i<pending_removals_.size(); i++)
+    {
+        const int note_index = indexOfNoteId(pending_removals_.getUnchecked(i));
+        
+        if (note_index >= 0)
+        {
+            removed[note_index] = true;
+        }
+    }
+    
+    Array<int> note_ids;
+    Array<int> note_nums;
+    Array<int> velocities;
+    Array<int> note_on_times;
+    Array<int> note_off_times;
+    Array<int> channels;
+    
+    const int max_notes = num_notes + added_notes.size();
+    
+    note_ids.ensureStorageAllocated(max_notes);
+    note_nums.ensureStorageAllocated(max_notes);
+    velocities.ensureStorageAllocated(max_notes);
+    note_on_times.ensureStorageAllocated(max_notes);
+    note_off_times.ensureStorageAllocated(max_notes);
+    channels.ensureStorageAllocated(max_notes);
+    
+    // one merge of the sorted, surviving notes with the sorted new ones
+    int note_index = 0;
+    int added_index = 0;
+    
+    while (note_index < num_notes || added_index < added_notes.size())
+    {
+        if (note_index < num_notes && removed[note_index])
+        {
+            note_index++;
+            continue;
+        }
+        
+        bool take_stored_note = (added_index >= added_notes.size());
+        
+        if (!take_stored_note && note_index < num_notes)
+        {
+            const MIDINote& added_note = added_notes.getReference(added_index).note;
+            
+            take_stored_note = compareNoteKeys(note_on_times_.getUnchecked(note_index),
+                                               note_nums_.getUnchecked(note_index),
+                                               note_ids_.getUnchecked(note_index),
+                                               added_note.note_on_time_,
+                                               added_note.note_num_,
+                                               added_notes.getReference(added_index).note_id) < 0;
+        }
+        
+        if (take_stored_note)
+        {
+            note_ids.add(note_ids_.getUnchecked(note_index));
+            note_nums.add(note_nums_.getUnchecked(note_index));
+            velocities.add(velocities_.getUnchecked(note_index));
+            note_on_times.add(note_on_times_.getUnchecked(note_index));
+            note_off_times.add(note_off_times_.getUnchecked(note_index));
+            channels.add(channels_.getUnchecked(note_index));
+            note_index++;
+        }
+        else
+        {
+            const PendingNote& added_note = added_notes.getReference(added_index);
+            
+            note_ids.add(added_note.note_id);
+            note_nums.add(added_note.note.note_num_);
+            velocities.add(added_note.note.velocity_);
+            note_on_times.add(added_note.note.note_on_time_);
+            note_off_times.add(added_note.note.note_off_time_);
+            channels.add(added_note.note.channel_);
+            added_index++;
+        }
+    }
+    
+    note_ids_.swapWith(note_ids);
+    note_nums_.swapWith(note_nums);
+    velocities_.swapWith(velocities);
+    note_on_times_.swapWith(note_on_times);
+    note_off_times_.swapWith(note_off_times);
+    channels_.swapWith(channels);
+}
+
+void MidiClipModel::writeToSequence(MidiMessageSequence& sequence) const
+{
+    for (int i=0; i<note_ids_.size(); i++)
+    {
+        const int channel = jlimit(1, 16, channels_.getUnchecked(i));
+        const int note_num = note_nums_.getUnchecked(i);
+        
+        sequence.addEvent(MidiMessage::noteOn(channel, note_num, (uint8)jlimit(1, 127, velocities_.getUnchecked(i))),
+                          note_on_times_.getUnchecked(i));
+        sequence.addEvent(MidiMessage::noteOff(channel, note_num),
+                          note_off_times_.getUnchecked(i));
+    }
+    
+    sequence.updateMatchedPairs();
+}
+
+bool MidiClipModel::writeMidiFile(const File& midi_file) const
+{
+    MidiMessageSequence sequence;
+    writeToSequence(sequence);
+    
+    MidiFile clip_file;
+    clip_file.setTicksPerQuarterNote(time_format_);
+    clip_file.addTrack(sequence);
+    
+    MemoryOutputStream clip_stream;
+    
+    if (!clip_file.writeTo(clip_stream))
+    {
+        return false;
+    }
+    
+    return MidiotFileUtils::replaceFileAtomically(midi_file,
+                                                  clip_stream.getData(),
+                                                  clip_stream.getDataSize());
+}
@@ -0,0 +1,134 @@
+//
+//  MidiClipModel.hpp
+//  Midiot
+//
+//  Created by Sean Bratnober on 3/4/18.
+//
+//
+
+#ifndef MidiClipModel_hpp
+#define MidiClipModel_hpp
+
+#include <stdio.h>
+#include "../JuceLibraryCode/JuceHeader.h"
+
+#include "NoteGridProperties.hpp"
+
+const short MIDI_CLIP_DEFAULT_TIME_FORMAT = 96;
+// transactions up to this many adds, moves and removes are applied in
+// place; bigger ones are merged into fresh arrays
+const int MIDI_CLIP_MAX_IN_PLACE_EDITS = 16;
+
+// The notes of a clip, independent of any view of them. Each note field
+// lives in its own array, all kept sorted by note on time, note number
+// and then id, so an edit finds its place with a binary search and
+// writing the clip out is one pass. Notes keep their id for as long as
+// they exist, while their index changes with every edit. Once the clip
+// is empty, ids start again from 0.
+//
+// Edits collect in a transaction and are applied together when it ends;
+// listeners hear about each transaction once. An edit made outside a
+// transaction is applied straight away. Ids used inside a transaction
+// refer to the notes as they were when it began. Message thread only.
+class MidiClipModel
+{
+public:
+    class Listener
+    {
+    public:
+        virtual ~Listener() {}
+        
+        // note indices from before the change are stale, ids are not
+        virtual void clipNotesChanged(MidiClipModel* clip_model) = 0;
+    };
+    
+    MidiClipModel();
+    ~MidiClipModel();
+    
+    void addListener(Listener* listener) { listeners_.add(listener); }
+    void removeListener(Listener* listener) { listeners_.remove(listener); }
+    
+    int getNumNotes() const { return note_ids_.size(); }
+    int getNoteId(int note_index) const { return note_ids_.getUnchecked(note_index); }
+    int getNoteNumber(int note_index) const { return note_nums_.getUnchecked(note_index); }
+    int getVelocity(int note_index) const { return velocities_.getUnchecked(note_index); }
+    int getNoteOnTime(int note_index) const { return note_on_times_.getUnchecked(note_index); }
+    int getNoteOffTime(int note_index) const { return note_off_times_.getUnchecked(note_index); }
+    int getChannel(int note_index) const { return channels_.getUnchecked(note_index); }
+    MIDINote getNote(int note_index) const;
+    
+    // -1 if no such note
+    int indexOfNoteId(int note_id) const;
+    // changes each time ids start again from 0; an id kept from an
+    // earlier epoch may now name a different note
+    int getNoteIdEpoch() const { return note_id_epoch_; }
+    
+    // transactions nest; the outermost end applies the edits
+    void beginTransaction();
+    void endTransaction();
+    
+    // returns the new note's id
+    int addNote(const MIDINote& note);
+    void moveNote(int note_id, const MIDINote& note);
+    void removeNote(int note_id);
+    void clear();
+    
+    // ticks per quarter note, as MidiFile::getTimeFormat()
+    short getTimeFormat() const { return time_format_; }
+    void setTimeFormat(short time_format) { time_format_ = time_format; }
+    
+    void writeToSequence(MidiMessageSequence& sequence) const;
+    bool writeMidiFile(const File& midi_file) const;
+    
+private:
+    struct PendingNote
+    {
+        int note_id;
+        MIDINote note;
+        // removed again in the same transaction
+        bool removed;
+    };
+    
+    class PendingNoteSorter
+    {
+    public:
+        static int compareElements(const PendingNote& note_a, const PendingNote& note_b);
+    };
+    
+    static int compareNoteKeys(int note_on_time_a, int note_num_a, int note_id_a,
+                               int note_on_time_b, int note_num_b, int note_id_b);
+    
+    void addPendingNote(int note_id, const MIDINote& note);
+    // applies the transaction to the note arrays; false if it was empty
+    bool applyPendingEdits();
+    // added_notes sorted; both leave note_indices_ to the caller
+    void applyEditsInPlace(const Array<PendingNote>& added_notes, int& first_changed_index);
+    void mergeEdits(const Array<PendingNote>& added_notes);
+    int findNoteInsertIndex(const PendingNote& added_note) const;
+    
+    Array<int> note_ids_;
+    Array<int> note_nums_;
+    Array<int> velocities_;
+    Array<int> note_on_times_;
+    Array<int> note_off_times_;
+    Array<int> channels_;
+    // by note id: its index in the arrays above, or -1 once removed
+    Array<int> note_indices_;
+    
+    Array<PendingNote> pending_notes_;
+    // by note id: its index in pending_notes_, or -1
+    Array<int> pending_note_indices_;
+    // ids of stored notes that the transaction moves or removes
+    Array<int> pending_removals_;
+    
+    int transaction_depth_;
+    int next_note_id_;
+    int note_id_epoch_;
+    short time_format_;
+    
+    ListenerList<Listener> listeners_;
+    
+    JUCE_DECLARE_NON_COPYABLE(MidiClipModel)
+};
+
+#endif /* MidiClipModel_hpp */
@@ -38,29 +38,35 @@ MidiControl::SysexControl* createSysexControl(short param_table,
 
 void MidiControl::handleMidiControlEvent(const MidiMessage& message)
 {
-    value_ = message.getControllerValue();
+    control_store_->set_value(control_id_, message.getControllerValue());
+    control_store_->set_hardware_value(control_id_, message.getControllerValue());
 
-    const MessageManagerLock mm_lock;
-    
-    if (midi_control_slider_)
-    {
-        midi_control_slider_->setValue(value_, dontSendNotification);
-//        midi_control_slider_-
-    }
+    postValueToSlider();
 }
 
 void MidiControl::send_value_to_midi()
 {
-    if (cc_control_)
+    short cc = cc_number();
+    bool queued;
+    
+    if (cc >= 0)
     {
-        midi_instrument_->sendControllerEvent(midi_instrument_->channel()+1,
-                                              cc_control_->number(),
-                                              value_);
+        queued = midi_instrument_->sendControllerEvent(midi_instrument_->channel()+1,
+                                                       cc,
+                                                       value());
     }
-    else if (sysex_control_)
+    else if (sysex_address() >= 0)
     {
-        
+        queued = midi_instrument_->sendSysexParameterChange(control_id_);
     }
+    else
+    {
+        return;
+    }
+    
+    // a queued message replaces any older one for this control, so the
+    // hardware ends up with this value; a dropped one leaves it unknown
+    control_store_->set_hardware_value(control_id_, queued ? value() : MIDI_CONTROL_VALUE_UNKNOWN);
 }
 
 void MidiControl::setMidiInstrument(MidiInstrument* midi_instrument)
@@ -73,39 +79,61 @@ void MidiControl::setMidiControlSlider(MidiControlSlider* control_slider)
     midi_control_slider_ = control_slider;
 }
 
+void MidiControl::setControllerComponent(MidiInstrumentControllerComponent* controller_component)
+{
+    controller_component_ = controller_component;
+}
+
+void MidiControl::postValueToSlider()
+{
+    if (controller_component_)
+    {
+        controller_component_->postMidiControlValue(control_id_, value());
+    }
+}
+
 
 void MidiControl::sliderValueChanged (Slider *slider)
 {
     //printf("MidiControl::sliderValueChanged() with value: %f\n", slider->getValue());
     
-    value_ = slider->getValue();
+    const int old_value = control_store_->value(control_id_);
+    
+    control_store_->set_value(control_id_, (int)slider->getValue());
     
-    if (cc_control_)
+    send_value_to_midi();
+    
+    if (midi_instrument_)
+    {
+        midi_instrument_->recordControlEdit(control_id_, old_value, value());
+    }
+}
+
+void MidiControl::sliderDragStarted (Slider *slider)
+{
+    // each drag is its own undo step
+    if (midi_instrument_)
     {
-        midi_instrument_->sendControllerEvent(midi_instrument_->channel()+1,
-                                              cc_control_->number(),
-                                              value_);
+        midi_instrument_->sealControlEdit();
     }
-    else if (sysex_control_)
+}
+
+void MidiControl::sliderDragEnded (Slider *slider)
+{
+    if (midi_instrument_)
     {
-        
+        midi_instrument_->sealControlEdit();
     }
 }
 
 void MidiControl::set_value(const int value, bool update_slider)
 {
-    printf("MidiControl::set_value(%d) for control %s\n", value, name_.toRawUTF8());
-    value_ = value;
+    printf("MidiControl::set_value(%d) for control %s\n", value, name().toRawUTF8());
+    control_store_->set_value(control_id_, value);
     
     if (update_slider)
     {
-        const MessageManagerLock mm_lock;
-        
-        if (midi_control_slider_)
-        {
-            midi_control_slider_->setValue(value_, dontSendNotification);
-            //        midi_control_slider_-
-        }
+        postValueToSlider();
     }
 }
 
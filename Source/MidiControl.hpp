@@ -12,6 +12,7 @@
 #include <stdio.h>
 
 #include "../JuceLibraryCode/JuceHeader.h"
+#include "MidiControlStore.hpp"
 
 
 class MidiInputPort;
@@ -75,6 +76,25 @@ public:
         
         ~SysexControl() {};
         
+        // (param_table, address_high/mid/low) packed into one int, used as
+        // the key for MidiInstrumentModel's sysex address index
+        static int packAddress(short param_table,
+                               short address_high,
+                               short address_mid,
+                               short address_low)
+        {
+            return ((param_table & 0xFF) << 24)
+                 | ((address_high & 0xFF) << 16)
+                 | ((address_mid & 0xFF) << 8)
+                 | (address_low & 0xFF);
+        }
+        
+        const int packed_address()
+        {
+            return packAddress(param_table_, address_high_, address_mid_, address_low_);
+        }
+        
+        const short param_table() { return param_table_; }
         const short address_high() { return address_high_; }
         const short address_mid() { return address_mid_; }
         const short address_low() { return address_low_; }
@@ -94,86 +114,57 @@ public:
     };
     
 public:
-    MidiControl(String name,
-                int control_id,
-                int initial_value,
-                ContinuousControl* cc_control = NULL,
-                SysexControl* sysex_control = NULL)
-    : name_(name),
+    // A MidiControl is a view onto one control id in its model's
+    // MidiControlStore; the store owns the name, value, range and MIDI
+    // mapping, the view only adds the UI/instrument wiring.
+    MidiControl(MidiControlStore* control_store,
+                int control_id)
+    : control_store_(control_store),
     control_id_(control_id),
-    value_(initial_value),
-    midi_control_slider_(NULL)
+    midi_instrument_(NULL),
+    midi_control_slider_(NULL),
+    controller_component_(NULL)
     {
-        if (cc_control)
-        {
-            cc_control_ = cc_control;
-        }
-        
-        if (sysex_control)
-        {
-            sysex_control_ = sysex_control;
-        }
     }
     
     ~MidiControl() {};
     
-    int getRangeMinimum()
-    {
-        int range_min = 0;
-        
-        if (cc_control_)
-        {
-            range_min = cc_control_->range_min();
-        }
-        
-        if (sysex_control_)
-        {
-            range_min = sysex_control_->range_min();
-        }
-        
-        return range_min;
-    }
-    
-    int getRangeMaximum()
-    {
-        int range_max = 0;
-        
-        if (cc_control_)
-        {
-            range_max = cc_control_->range_max();
-        }
-        
-        if (sysex_control_)
-        {
-            range_max = sysex_control_->range_max();
-        }
-        
-        return range_max;
-    }
+    int getRangeMinimum() { return control_store_->range_min(control_id_); }
+    int getRangeMaximum() { return control_store_->range_max(control_id_); }
     
     void set_value(const int value, bool update_slider = false);
-    const int value() { return value_; }
+    const int value() { return control_store_->value(control_id_); }
     void send_value_to_midi();
     
     void sliderValueChanged (Slider *slider) override;
+    void sliderDragStarted (Slider *slider) override;
+    void sliderDragEnded (Slider *slider) override;
     void handleMidiControlEvent(const MidiMessage& message);
     
-    String name() { return name_; }
+    String name() { return control_store_->name(control_id_); }
+    const int control_id() { return control_id_; }
+    
+    // -1 if the control has no CC / sysex mapping
+    const short cc_number() { return control_store_->cc_number(control_id_); }
+    const int sysex_address() { return control_store_->sysex_address(control_id_); }
+    const short sysex_size_bytes() { return control_store_->sysex_size_bytes(control_id_); }
     
     void setMidiInstrument(MidiInstrument* midi_instrument);
     void setMidiControlSlider(MidiControlSlider* control_slider);
+    void setControllerComponent(MidiInstrumentControllerComponent* controller_component);
     
 private:
-    ScopedPointer<ContinuousControl> cc_control_;
-    ScopedPointer<SysexControl> sysex_control_;
+    // hands the current value to the controller component, which moves the
+    // slider on the message thread; safe to call from the MIDI thread
+    void postValueToSlider();
     
-    String name_;
+    MidiControlStore* control_store_;
     int control_id_;
-    int value_;
     
     MidiInstrument* midi_instrument_;
     
     MidiControlSlider* midi_control_slider_;
+    MidiInstrumentControllerComponent* controller_component_;
 };
 
 
@@ -0,0 +1,118 @@
+//
+//  MidiControlCapture.cpp
+//  Midiot
+//
+//  Created by Sean Bratnober on 2/28/18.
+//
+//
+
+#include "MidiControlCapture.hpp"
+#include "MidiotFileUtils.hpp"
+
+MidiControlCapture::MidiControlCapture(int max_events)
+: max_events_(jmax(1, max_events)),
+events_((size_t)jmax(1, max_events)),
+num_events_(0),
+num_dropped_(0),
+capturing_(0),
+start_time_ms_(0.0)
+{
+}
+
+MidiControlCapture::~MidiControlCapture()
+{
+}
+
+void MidiControlCapture::startCapture()
+{
+    capturing_.set(0);
+    
+    num_events_.set(0);
+    num_dropped_.set(0);
+    start_time_ms_ = Time::getMillisecondCounterHiRes();
+    
+    capturing_.set(1);
+}
+
+void MidiControlCapture::stopCapture()
+{
+    capturing_.set(0);
+}
+
+void MidiControlCapture::addMessage(const MidiMessage& message)
+{
+    if (capturing_.get() == 0)
+    {
+        return;
+    }
+    
+    const int num_bytes = message.getRawDataSize();
+    
+    // bulk dumps and other long sysex aren't parameter changes
+    if (num_bytes > MIDI_CAPTURE_MAX_EVENT_BYTES)
+    {
+        return;
+    }
+    
+    const int event_index = num_events_.get();
+    
+    if (event_index >= max_events_)
+    {
+        ++num_dropped_;
+        return;
+    }
+    
+    // incoming messages are stamped on the getMillisecondCounterHiRes() clock
+    const double time_ms = (message.getTimeStamp() > 0.0)
+                            ? message.getTimeStamp() * 1000.0
+                            : Time::getMillisecondCounterHiRes();
+    
+    CaptureEvent& event = events_[event_index];
+    event.time_ms = jmax(0.0, time_ms - start_time_ms_);
+    event.num_bytes = num_bytes;
+    memcpy(event.data, message.getRawData(), (size_t)num_bytes);
+    
+    // publish only if startCapture() didn't reset the count meanwhile
+    num_events_.compareAndSetBool(event_index + 1, event_index);
+}
+
+void MidiControlCapture::createMidiBuffer(MidiBuffer& buffer) const
+{
+    buffer.clear();
+    
+    const int num_events = num_events_.get();
+    
+    for (int i=0; i<num_events; i++)
+    {
+        const CaptureEvent& event = events_[i];
+        buffer.addEvent(event.data, event.num_bytes, roundToInt(event.time_ms));
+    }
+}
+
+bool MidiControlCapture::writeMidiFile(const File& midi_file) const
+{
+    MidiMessageSequence sequence;
+    const int num_events = num_events_.get();
+    
+    for (int i=0; i<num_events; i++)
+    {
+        const CaptureEvent& event = events_[i];
+        sequence.addEvent(MidiMessage(event.data, event.num_bytes, event.time_ms));
+    }
+    
+    MidiFile capture_file;
+    // 25 frames of 40 ticks: one tick per millisecond
+    capture_file.setSmpteTimeFormat(25, 40);
+    capture_file.addTrack(sequence);
+    
+    MemoryOutputStream capture_stream;
+    
+    if (!capture_file.writeTo(capture_stream))
+    {
+        return false;
+    }
+    
+    return MidiotFileUtils::replaceFileAtomically(midi_file,
+                                                  capture_stream.getData(),
+                                                  capture_stream.getDataSize());
+}
@@ -0,0 +1,68 @@
+//
+//  MidiControlCapture.hpp
+//  Midiot
+//
+//  Created by Sean Bratnober on 2/28/18.
+//
+//
+
+#ifndef MidiControlCapture_hpp
+#define MidiControlCapture_hpp
+
+#include <stdio.h>
+#include "../JuceLibraryCode/JuceHeader.h"
+
+const int MIDI_CAPTURE_MAX_EVENTS = 65536;
+// big enough for a single-parameter sysex change; bulk dumps aren't edits
+const int MIDI_CAPTURE_MAX_EVENT_BYTES = 16;
+const double MIDI_CAPTURE_REPLAY_LEAD_MS = 20.0;
+
+// Records parameter changes coming from the instrument (controllers and
+// short sysex parameter messages) with millisecond timestamps, into a
+// buffer allocated up front. The MIDI thread adds events without locking
+// or allocating; sysex too long to be a parameter change is skipped, and
+// when the buffer is full further events are counted as dropped. The recording can be turned into a MidiBuffer for replay or
+// written out as a MIDI file.
+class MidiControlCapture
+{
+public:
+    MidiControlCapture(int max_events = MIDI_CAPTURE_MAX_EVENTS);
+    ~MidiControlCapture();
+    
+    // message thread; starting clears the last recording
+    void startCapture();
+    void stopCapture();
+    bool isCapturing() const { return capturing_.get() != 0; }
+    
+    // MIDI thread; ignored unless capturing
+    void addMessage(const MidiMessage& message);
+    
+    int getNumEvents() const { return num_events_.get(); }
+    int getNumDroppedEvents() const { return num_dropped_.get(); }
+    
+    // Sample positions are milliseconds from the start of the capture,
+    // for MidiOutputPort::sendBlockOfMessages() at 1000 samples a second.
+    void createMidiBuffer(MidiBuffer& buffer) const;
+    // one track, timed in milliseconds (SMPTE 25 fps, 40 ticks a frame)
+    bool writeMidiFile(const File& midi_file) const;
+    
+private:
+    struct CaptureEvent
+    {
+        double time_ms;
+        int num_bytes;
+        uint8 data[MIDI_CAPTURE_MAX_EVENT_BYTES];
+    };
+    
+    const int max_events_;
+    HeapBlock<CaptureEvent> events_;
+    // events below this are complete and safe to read
+    Atomic<int> num_events_;
+    Atomic<int> num_dropped_;
+    Atomic<int> capturing_;
+    double start_time_ms_;
+    
+    JUCE_DECLARE_NON_COPYABLE(MidiControlCapture)
+};
+
+#endif /* MidiControlCapture_hpp */
@@ -0,0 +1,114 @@
+//
+//  MidiControlEditHistory.cpp
+//  Midiot
+//
+//  Created by Sean Bratnober on 2/26/18.
+//
+//
+
+#include "MidiControlEditHistory.hpp"
+
+MidiControlEditHistory::MidiControlEditHistory(int capacity)
+: capacity_(jmax(1, capacity)),
+records_((size_t)jmax(1, capacity)),
+first_record_(0),
+num_records_(0),
+position_(0),
+last_edit_open_(false)
+{
+}
+
+MidiControlEditHistory::~MidiControlEditHistory()
+{
+}
+
+void MidiControlEditHistory::recordEdit(int control_id, int old_value, int new_value)
+{
+    if (old_value == new_value)
+    {
+        return;
+    }
+    
+    const uint32 now = Time::getMillisecondCounter();
+    
+    // a new edit makes the undone ones unreachable
+    if (position_ < num_records_)
+    {
+        num_records_ = position_;
+        last_edit_open_ = false;
+    }
+    
+    if (last_edit_open_ && num_records_ > 0)
+    {
+        EditRecord& last_record = getRecord(num_records_ - 1);
+        
+        if (last_record.control_id == control_id &&
+            now - last_record.time_ms < MIDI_EDIT_MERGE_MS)
+        {
+            last_record.new_value = new_value;
+            last_record.time_ms = now;
+            
+            // dragged back to where it started
+            if (last_record.new_value == last_record.old_value)
+            {
+                num_records_--;
+                position_ = num_records_;
+                last_edit_open_ = false;
+            }
+            
+            return;
+        }
+    }
+    
+    if (num_records_ == capacity_)
+    {
+        first_record_ = (first_record_ + 1) % capacity_;
+        num_records_--;
+    }
+    
+    EditRecord& record = getRecord(num_records_);
+    record.control_id = control_id;
+    record.old_value = old_value;
+    record.new_value = new_value;
+    record.time_ms = now;
+    
+    num_records_++;
+    position_ = num_records_;
+    last_edit_open_ = true;
+}
+
+bool MidiControlEditHistory::undo(EditRecord& record)
+{
+    if (!canUndo())
+    {
+        return false;
+    }
+    
+    position_--;
+    record = getRecord(position_);
+    last_edit_open_ = false;
+    
+    return true;
+}
+
+bool MidiControlEditHistory::redo(EditRecord& record)
+{
+    if (!canRedo())
+    {
+        return false;
+    }
+    
+    record = getRecord(position_);
+    position_++;
+    last_edit_open_ = false;
+    
+    return true;
+}
+
+void MidiControlEditHistory::clear()
+{
+    first_record_ = 0;
+    num_records_ = 0;
+    position_ = 0;
+    last_edit_open_ = false;
+}
@@ -0,0 +1,67 @@
+//
+//  MidiControlEditHistory.hpp
+//  Midiot
+//
+//  Created by Sean Bratnober on 2/26/18.
+//
+//
+
+#ifndef MidiControlEditHistory_hpp
+#define MidiControlEditHistory_hpp
+
+#include <stdio.h>
+#include "../JuceLibraryCode/JuceHeader.h"
+
+const int MIDI_EDIT_HISTORY_SIZE = 4096;
+// edits to one control closer together than this become one entry
+const uint32 MIDI_EDIT_MERGE_MS = 1000;
+
+// Undo/redo log of control edits, kept in a fixed ring of records so a
+// long session never grows it: once full, the oldest edit is forgotten.
+// Message thread only.
+class MidiControlEditHistory
+{
+public:
+    struct EditRecord
+    {
+        int control_id;
+        int old_value;
+        int new_value;
+        // Time::getMillisecondCounter()
+        uint32 time_ms;
+    };
+    
+    MidiControlEditHistory(int capacity = MIDI_EDIT_HISTORY_SIZE);
+    ~MidiControlEditHistory();
+    
+    // Drops anything that could be redone. A run of edits to the same
+    // control merges into the last entry until sealLastEdit() is called
+    // or the control rests for MIDI_EDIT_MERGE_MS.
+    void recordEdit(int control_id, int old_value, int new_value);
+    // the next edit starts a new entry, e.g. at the start of a drag
+    void sealLastEdit() { last_edit_open_ = false; }
+    
+    bool canUndo() const { return position_ > 0; }
+    bool canRedo() const { return position_ < num_records_; }
+    
+    // The entry to revert (apply its old_value) or reapply (new_value).
+    bool undo(EditRecord& record);
+    bool redo(EditRecord& record);
+    
+    void clear();
+    
+private:
+    EditRecord& getRecord(int index) { return records_[(first_record_ + index) % capacity_]; }
+    
+    const int capacity_;
+    HeapBlock<EditRecord> records_;
+    int first_record_;
+    int num_records_;
+    // records before this are applied, the rest can be redone
+    int position_;
+    bool last_edit_open_;
+    
+    JUCE_DECLARE_NON_COPYABLE(MidiControlEditHistory)
+};
+
+#endif /* MidiControlEditHistory_hpp */
@@ -0,0 +1,75 @@
+//
+//  MidiControlStore.cpp
+//  Midiot
+//
+//  Created by Sean Bratnober on 2/8/18.
+//
+//
+
+#include "MidiControlStore.hpp"
+
+MidiControlStore::MidiControlStore()
+{
+}
+
+MidiControlStore::~MidiControlStore()
+{
+}
+
+void MidiControlStore::ensureStorageAllocated(int num_controls)
+{
+    names_.ensureStorageAllocated(num_controls);
+    values_.ensureStorageAllocated(num_controls);
+    hardware_values_.ensureStorageAllocated(num_controls);
+    cc_numbers_.ensureStorageAllocated(num_controls);
+    sysex_addresses_.ensureStorageAllocated(num_controls);
+    sysex_size_bytes_.ensureStorageAllocated(num_controls);
+    range_mins_.ensureStorageAllocated(num_controls);
+    range_maxs_.ensureStorageAllocated(num_controls);
+}
+
+int MidiControlStore::addControl(const String& name,
+                                 int initial_value,
+                                 short cc_number,
+                                 int sysex_address,
+                                 short sysex_size_bytes,
+                                 int range_min,
+                                 int range_max)
+{
+    int control_id = values_.size();
+    
+    names_.add(name);
+    values_.add(initial_value);
+    hardware_values_.add(MIDI_CONTROL_VALUE_UNKNOWN);
+    cc_numbers_.add(cc_number);
+    sysex_addresses_.add(sysex_address);
+    sysex_size_bytes_.add(sysex_size_bytes);
+    range_mins_.add(range_min);
+    range_maxs_.add(range_max);
+    
+    return control_id;
+}
+
+void MidiControlStore::copyValuesTo(Array<int>& values) const
+{
+    values.clearQuick();
+    values.addArray(values_.begin(), values_.size());
+}
+
+void MidiControlStore::setValues(const Array<int>& values)
+{
+    const int num_values = jmin(values.size(), values_.size());
+    
+    for (int i=0; i<num_values; i++)
+    {
+        values_.setUnchecked(i, values.getUnchecked(i));
+    }
+}
+
+void MidiControlStore::invalidateHardwareValues()
+{
+    for (int i=0; i<hardware_values_.size(); i++)
+    {
+        hardware_values_.setUnchecked(i, MIDI_CONTROL_VALUE_UNKNOWN);
+    }
+}
@@ -0,0 +1,78 @@
+//
+//  MidiControlStore.hpp
+//  Midiot
+//
+//  Created by Sean Bratnober on 2/8/18.
+//
+//
+
+#ifndef MidiControlStore_hpp
+#define MidiControlStore_hpp
+
+#include <stdio.h>
+#include "../JuceLibraryCode/JuceHeader.h"
+
+// hardware value of a control that hasn't been sent or received yet
+const int MIDI_CONTROL_VALUE_UNKNOWN = (int)0x80000000;
+
+// Packed parameter storage for a MidiInstrumentModel. Every per-control
+// field lives in its own array indexed by control id, so whole-patch work
+// (snapshots, diffs, patch sends) walks a few contiguous arrays instead of
+// one heap object per control.
+class MidiControlStore
+{
+public:
+    MidiControlStore();
+    ~MidiControlStore();
+    
+    void ensureStorageAllocated(int num_controls);
+    
+    // cc_number and sysex_address are -1 when the control has none;
+    // sysex_address is packed with MidiControl::SysexControl::packAddress()
+    int addControl(const String& name,
+                   int initial_value,
+                   short cc_number,
+                   int sysex_address,
+                   short sysex_size_bytes,
+                   int range_min,
+                   int range_max);
+    
+    int size() const { return values_.size(); }
+    
+    const String& name(int control_id) const { return names_[control_id]; }
+    
+    int value(int control_id) const { return values_.getUnchecked(control_id); }
+    void set_value(int control_id, int value) { values_.setUnchecked(control_id, value); }
+    
+    short cc_number(int control_id) const { return cc_numbers_.getUnchecked(control_id); }
+    int sysex_address(int control_id) const { return sysex_addresses_.getUnchecked(control_id); }
+    short sysex_size_bytes(int control_id) const { return sysex_size_bytes_.getUnchecked(control_id); }
+    int range_min(int control_id) const { return range_mins_.getUnchecked(control_id); }
+    int range_max(int control_id) const { return range_maxs_.getUnchecked(control_id); }
+    
+    // last value known to be on the instrument itself, from a send or
+    // from the instrument reporting it
+    int hardware_value(int control_id) const { return hardware_values_.getUnchecked(control_id); }
+    void set_hardware_value(int control_id, int value) { hardware_values_.setUnchecked(control_id, value); }
+    void invalidateHardwareValues();
+    
+    // whole-patch access
+    const int* values() const { return values_.begin(); }
+    const int* hardware_values() const { return hardware_values_.begin(); }
+    void copyValuesTo(Array<int>& values) const;
+    void setValues(const Array<int>& values);
+    
+private:
+    StringArray names_;
+    Array<int> values_;
+    Array<int> hardware_values_;
+    Array<short> cc_numbers_;
+    Array<int> sysex_addresses_;
+    Array<short> sysex_size_bytes_;
+    Array<int> range_mins_;
+    Array<int> range_maxs_;
+    
+    JUCE_DECLARE_NON_COPYABLE(MidiControlStore)
+};
+
+#endif /* MidiControlStore_hpp */
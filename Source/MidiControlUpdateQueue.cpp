@@ -0,0 +1,63 @@
+//
+//  MidiControlUpdateQueue.cpp
+//  Midiot
+//
+//  Created by Sean Bratnober on 2/2/18.
+//
+//
+
+#include "MidiControlUpdateQueue.hpp"
+
+MidiControlUpdateQueue::MidiControlUpdateQueue(int queue_size)
+: fifo_(queue_size),
+updates_(queue_size),
+overflowed_(0)
+{
+}
+
+MidiControlUpdateQueue::~MidiControlUpdateQueue()
+{
+}
+
+bool MidiControlUpdateQueue::push(int control_id, int value)
+{
+    int start1, size1, start2, size2;
+    fifo_.prepareToWrite(1, start1, size1, start2, size2);
+    
+    if (size1 + size2 < 1)
+    {
+        overflowed_.set(1);
+        return false;
+    }
+    
+    ControlUpdate& update = updates_[size1 > 0 ? start1 : start2];
+    update.control_id = control_id;
+    update.value = value;
+    
+    fifo_.finishedWrite(1);
+    return true;
+}
+
+int MidiControlUpdateQueue::pop(ControlUpdate* updates, int max_updates)
+{
+    int start1, size1, start2, size2;
+    fifo_.prepareToRead(max_updates, start1, size1, start2, size2);
+    
+    for (int i=0; i<size1; i++)
+    {
+        updates[i] = updates_[start1 + i];
+    }
+    
+    for (int i=0; i<size2; i++)
+    {
+        updates[size1 + i] = updates_[start2 + i];
+    }
+    
+    fifo_.finishedRead(size1 + size2);
+    return size1 + size2;
+}
+
+bool MidiControlUpdateQueue::checkAndClearOverflow()
+{
+    return overflowed_.exchange(0) != 0;
+}
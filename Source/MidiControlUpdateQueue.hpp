@@ -0,0 +1,49 @@
+//
+//  MidiControlUpdateQueue.hpp
+//  Midiot
+//
+//  Created by Sean Bratnober on 2/2/18.
+//
+//
+
+#ifndef MidiControlUpdateQueue_hpp
+#define MidiControlUpdateQueue_hpp
+
+#include <stdio.h>
+#include "../JuceLibraryCode/JuceHeader.h"
+
+const int MIDI_CONTROL_UPDATE_QUEUE_SIZE = 1024;
+
+// Single-producer/single-consumer ring of (control_id, value) pairs.
+// The MIDI input thread pushes, the message thread pops; neither side
+// ever blocks or allocates.
+class MidiControlUpdateQueue
+{
+public:
+    struct ControlUpdate
+    {
+        int control_id;
+        int value;
+    };
+    
+    MidiControlUpdateQueue(int queue_size = MIDI_CONTROL_UPDATE_QUEUE_SIZE);
+    ~MidiControlUpdateQueue();
+    
+    // producer side: returns false (and flags an overflow) if the queue is full
+    bool push(int control_id, int value);
+    
+    // consumer side: copies up to max_updates into updates, returns the count
+    int pop(ControlUpdate* updates, int max_updates);
+    
+    // returns true once after any push was dropped, so the consumer can resync
+    bool checkAndClearOverflow();
+    
+private:
+    AbstractFifo fifo_;
+    HeapBlock<ControlUpdate> updates_;
+    Atomic<int> overflowed_;
+    
+    JUCE_DECLARE_NON_COPYABLE(MidiControlUpdateQueue)
+};
+
+#endif /* MidiControlUpdateQueue_hpp */
@@ -10,6 +10,7 @@
 #include "MidiInterface.hpp"
 #include "MidiInstrumentControllerComponent.hpp"
 #include "MidiControl.hpp"
+#include "MidiPatchFile.hpp"
 
 
 
@@ -24,24 +25,28 @@ MidiInstrument::MidiInstrument(MidiInstrumentModel* inst_model,
 channel_(input_channel),
 midi_input_port_(input_port),
 midi_output_port_(output_port),
-controller_component_(controller)
+controller_component_(controller),
+morph_controller_number_(MIDI_MORPH_DEFAULT_CC)
 {
     // Hook up keyboard component to midi_input_port_
     controller_component_->addMidiKeyboardStateListener(this);
     
-    MidiControl** ctrl_iter = inst_model->getMidiControlIterator();
+    controller_component_->addMidiInstrument(this);
+    
+    MidiControl* ctrl_iter = inst_model->getMidiControlIterator();
     
     for (ctrl_iter;
          ctrl_iter != inst_model->getMidiControlIteratorEnd();
          ctrl_iter++)
     {
-        MidiControl* midi_control = *ctrl_iter;
+        MidiControl* midi_control = ctrl_iter;
         printf("adding MidiControl: %s\n", midi_control->name().toRawUTF8());
         setupMidiControlInterface(midi_control);
     }
 
     midi_input_port_->addInstrumentToPort(this);
     
+    controller_component_->updatePatchSelectorMenu();
     controller_component_->setKeyboardMidiOutputChannel(output_channel+1);
 }
 
@@ -55,35 +60,137 @@ MidiInstrument::~MidiInstrument()
 
 var MidiInstrument::getInstrumentParametersVar()
 {
-    printf("MidiInstrument::getInstrumentParametersVar() called\n");
-    DynamicObject* params_obj = new DynamicObject();
+    return MidiPatchFile::createParametersVar(*inst_model_);
+}
+
+var MidiInstrument::getPatchVar(String patch_name)
+{
+    return MidiPatchFile::createPatchVar(patch_name, *inst_model_);
+}
+
+bool MidiInstrument::loadPatchFile(const File& patch_file)
+{
+    return MidiPatchFile::readPatch(patch_file, *inst_model_);
+}
+
+bool MidiInstrument::savePatchFile(const File& patch_file, const String& patch_name)
+{
+    return MidiPatchFile::writePatch(patch_file, patch_name, *inst_model_);
+}
+
+bool MidiInstrument::encodePatch(const File& patch_file, const String& patch_name, MemoryBlock& patch_data)
+{
+    return MidiPatchFile::encodePatch(patch_file, patch_name, *inst_model_, patch_data);
+}
+
+bool MidiInstrument::decodePatch(const MemoryBlock& patch_data)
+{
+    if (!MidiPatchFile::decodePatch(patch_data, *inst_model_))
+    {
+        return false;
+    }
     
-    MidiControl** ctrl_iter = inst_model_->getMidiControlIterator();
+    edit_history_.clear();
+    return true;
+}
+
+void MidiInstrument::replayControlCapture()
+{
+    if (!midi_output_port_ || control_capture_.getNumEvents() == 0)
+    {
+        return;
+    }
     
-    for (ctrl_iter;
-         ctrl_iter != inst_model_->getMidiControlIteratorEnd();
-         ctrl_iter++)
+    MidiBuffer capture_buffer;
+    control_capture_.createMidiBuffer(capture_buffer);
+    
+    // positions are milliseconds; a short lead keeps the first events on time
+    midi_output_port_->sendBlockOfMessages(capture_buffer,
+                                           Time::getMillisecondCounterHiRes() + MIDI_CAPTURE_REPLAY_LEAD_MS,
+                                           1000.0);
+}
+
+bool MidiInstrument::undoControlEdit()
+{
+    MidiControlEditHistory::EditRecord record;
+    
+    if (!edit_history_.undo(record))
     {
-        MidiControl* midi_control = *ctrl_iter;
-        params_obj->setProperty(midi_control->name(), midi_control->value());
+        return false;
     }
     
-    var json(params_obj);
-    return json;
+    applyControlEdit(record.control_id, record.old_value);
+    return true;
 }
 
-var MidiInstrument::getPatchVar(String patch_name)
+bool MidiInstrument::redoControlEdit()
 {
-    DynamicObject* patch_obj = new DynamicObject();
-    patch_obj->setProperty("manufacturer", inst_model_->manufacturer());
-    patch_obj->setProperty("model_name", inst_model_->model_name());
-    patch_obj->setProperty("patch_name", patch_name);
+    MidiControlEditHistory::EditRecord record;
     
-    var params = getInstrumentParametersVar();
-    patch_obj->setProperty("params", params);
+    if (!edit_history_.redo(record))
+    {
+        return false;
+    }
     
-    var json(patch_obj);
-    return json;
+    applyControlEdit(record.control_id, record.new_value);
+    return true;
+}
+
+void MidiInstrument::applyControlEdit(int control_id, int value)
+{
+    MidiControl* midi_control = inst_model_->getMidiControl(control_id);
+    
+    if (!midi_control)
+    {
+        return;
+    }
+    
+    inst_model_->getControlStore().set_value(control_id, value);
+    midi_control->send_value_to_midi();
+    
+    if (controller_component_)
+    {
+        controller_component_->postMidiControlValue(control_id, value);
+    }
+}
+
+void MidiInstrument::findSimilarPatches(const MidiPatchSimilarityIndex& index,
+                                        int max_results,
+                                        StringArray& patch_names,
+                                        const String& exclude_name)
+{
+    index.findNearestPatches(inst_model_->getControlStore().values(),
+                             max_results,
+                             patch_names,
+                             exclude_name);
+}
+
+void MidiInstrument::startPatchMorph(const Array<int>& patch_a, const Array<int>& patch_b)
+{
+    if (!patch_morpher_)
+    {
+        patch_morpher_ = new MidiPatchMorpher(inst_model_, controller_component_);
+    }
+    
+    patch_morpher_->setPatches(patch_a, patch_b);
+    patch_morpher_->setMorphPosition(0.0f);
+    patch_morpher_->startMorphing();
+}
+
+void MidiInstrument::stopPatchMorph()
+{
+    if (patch_morpher_)
+    {
+        patch_morpher_->stopMorphing();
+    }
+}
+
+void MidiInstrument::setMorphPosition(float position)
+{
+    if (patch_morpher_)
+    {
+        patch_morpher_->setMorphPosition(position);
+    }
 }
 
 String MidiInstrument::getManufacturerName()
@@ -99,11 +206,9 @@ String MidiInstrument::getModelName()
 void MidiInstrument::setupMidiControlInterface(MidiControl* midi_control)
 {
     MidiControlSlider* control_slider = controller_component_->addMidiControlSlider(midi_control);
-    controller_component_->addMidiInstrument(this);
     midi_control->setMidiInstrument(this);
     midi_control->setMidiControlSlider(control_slider);
-    midi_input_port_->addInstrumentToPort(this);
-    controller_component_->updatePatchSelectorMenu();
+    midi_control->setControllerComponent(controller_component_);
 }
 
 void MidiInstrument::listenToControllerComponentKeyboard()
@@ -117,31 +222,38 @@ void MidiInstrument::set_instrument_id(int instrument_id)
 }
 
 
-void MidiInstrument::sendControllerEvent(int midi_channel,
+bool MidiInstrument::sendControllerEvent(int midi_channel,
                                          int controller_type,
                                          int value)
 {
-    MidiMessage m(MidiMessage::controllerEvent(midi_channel, controller_type, value));
-    m.setTimeStamp(Time::getMillisecondCounterHiRes() * 0.0001);
-    midi_output_port_->sendMessageNow(m);
+    return midi_output_port_->sendControllerEvent(midi_channel, controller_type, value);
+}
+
+bool MidiInstrument::sendSysexParameterChange(int control_id)
+{
+    MidiMessage m;
+    
+    if (!inst_model_->createSysexParameterChange(control_id, m))
+    {
+        return false;
+    }
+    
+    int sysex_address = inst_model_->getControlStore().sysex_address(control_id);
+    return midi_output_port_->sendCoalescedMessage(MidiOutputScheduler::getSysexParameterKey(sysex_address), m);
 }
 
 void MidiInstrument::sendNoteOn(int midi_channel,
                                 int midi_note_number,
                                 float velocity)
 {
-    MidiMessage m (MidiMessage::noteOn (midi_channel, midi_note_number, velocity));
-    m.setTimeStamp (Time::getMillisecondCounterHiRes() * 0.001);
-    midi_output_port_->sendMessageNow(m);
+    midi_output_port_->sendNoteOn(midi_channel, midi_note_number, velocity);
 }
 
 void MidiInstrument::sendNoteOff(int midi_channel,
                                  int midi_note_number,
                                  float velocity)
 {
-    MidiMessage m (MidiMessage::noteOff (midi_channel, midi_note_number, velocity));
-    m.setTimeStamp (Time::getMillisecondCounterHiRes() * 0.001);
-    midi_output_port_->sendMessageNow(m);
+    midi_output_port_->sendNoteOff(midi_channel, midi_note_number, velocity);
 }
 
 
@@ -176,13 +288,33 @@ void MidiInstrument::handleIncomingMidiMessage(const MidiMessage& message)
     else if (message.isController())
     {
         //printf("MidiInstrument::handleIncomingMidiMessage() with controller\n");
-        inst_model_->handleMidiControlEvent(message);
+        control_capture_.addMessage(message);
+        
+        if (message.getControllerNumber() == morph_controller_number_ && isMorphing())
+        {
+            patch_morpher_->setMorphPosition(message.getControllerValue() / 127.0f);
+        }
+        else
+        {
+            inst_model_->handleMidiControlEvent(message);
+        }
     }
     else if (message.isSysEx())
     {
         //printf("MidiInstrument::handleIncomingMidiMessage() with sysex\n");
-        inst_model_->handleMidiSysexEvent(message);
-}
+        control_capture_.addMessage(message);
+        
+        // a dump sets many controls at once; refresh the sliders in one pass
+        if (inst_model_->handleMidiSysexEvent(message))
+        {
+            controller_component_->requestMidiControlResync();
+        }
+    }
+    else if (message.isProgramChange())
+    {
+        // the instrument has switched to one of its own patches
+        inst_model_->getControlStore().invalidateHardwareValues();
+    }
     else if (!message.isMidiClock())
     {
         //printf("MidiInstrument::handleIncomingMidiMessage()\n");
@@ -192,34 +324,121 @@ void MidiInstrument::handleIncomingMidiMessage(const MidiMessage& message)
 
 void MidiInstrument::sendSysexPatchDumpMessage()
 {
-    //const uint8 sysex_data_patch_dump[10] = { 0xF0, 0x43, 0x20, 0x7F, 0x1C, 0x03, 0x0E, 0x0F, 0x00, 0xF7 };
+    MidiMessage patch_dump_request;
     
-    const uint8 sysexDataDumpRequest[10] = { 0xF0, 0x43, 0x20, 0x7F, 0x1C, 0x03, 0x00, 0x00, 0x00, 0xF7 };
-    MidiMessage dumpRequest(MidiMessage::createSysExMessage ((const void*)sysexDataDumpRequest, 10));
-    printf("sending data dump request\n");
-    //midi_output_port_->sendMessageNow(dumpRequest);
-
-    const uint8 sysexDataPatchDump[10] = { 0xF0, 0x43, 0x20, 0x7F, 0x1C, 0x03, 0x0E, 0x0F, 0x00, 0xF7 };
-    MidiMessage patchDumpRequest (MidiMessage::createSysExMessage ((const void*)sysexDataPatchDump, 10));
-    printf("sending patch dump request\n");
-    midi_output_port_->sendMessageNow(patchDumpRequest);
+    if (inst_model_->createSysexPatchDumpRequest(patch_dump_request))
+    {
+        midi_output_port_->sendMessageNow(patch_dump_request);
+    }
+}
 
+static int getMidiBufferNumBytes(const MidiBuffer& buffer)
+{
+    MidiBuffer::Iterator buffer_iter(buffer);
+    const uint8* message_data;
+    int message_size;
+    int sample_position;
+    int num_bytes = 0;
     
-    const uint8 sysexDataIdRequest[6] = { 0xF0, 0x7E, 0x00, 0x06, 0x01, 0xF7 };
-    MidiMessage idRequest (MidiMessage::createSysExMessage ((const void*)sysexDataIdRequest, 6));
-    printf("sending data ID request\n");
-    //midi_output_port_->sendMessageNow(idRequest);
+    while (buffer_iter.getNextEvent(message_data, message_size, sample_position))
+    {
+        num_bytes += message_size;
+    }
     
-    int midi_channel = 1;
-    int midi_note_number = 60;
-    float velocity = 0.99;
-    MidiMessage m(MidiMessage::noteOn(midi_channel, midi_note_number, velocity));
-//    midi_output_port_->sendMessageNow(m);
+    return num_bytes;
 }
 
 void MidiInstrument::sendMidiControlPatchData()
 {
-    inst_model_->sendMidiControlPatchData();
+    MidiControlStore& control_store = inst_model_->getControlStore();
+    const int* values = control_store.values();
+    const int* hardware_values = control_store.hardware_values();
+    
+    patch_changes_.clearQuick();
+    int change_bytes = 0;
+    
+    for (int i=0; i<control_store.size(); i++)
+    {
+        if (values[i] == hardware_values[i])
+        {
+            continue;
+        }
+        
+        PatchChangeMessage change;
+        change.control_id = i;
+        
+        short cc = control_store.cc_number(i);
+        
+        if (cc >= 0)
+        {
+            change.message = MidiMessage::controllerEvent(channel_+1, cc, values[i]);
+        }
+        else if (!inst_model_->createSysexParameterChange(i, change.message))
+        {
+            continue;
+        }
+        
+        change_bytes += change.message.getRawDataSize();
+        patch_changes_.add(change);
+    }
+    
+    if (patch_changes_.size() == 0)
+    {
+        return;
+    }
+    
+    MidiBuffer patch_buffer;
+    int sample_position = 0;
+    
+    if (inst_model_->createSysexPatchDump(patch_buffer) &&
+        getMidiBufferNumBytes(patch_buffer) < change_bytes)
+    {
+        // the dump carries every control with a sysex address; anything
+        // else that changed still goes out on its own
+        sample_position = patch_buffer.getLastEventTime() + 1;
+        
+        for (int i=0; i<control_store.size(); i++)
+        {
+            if (control_store.sysex_address(i) >= 0)
+            {
+                midi_output_port_->flushCoalescedMessage(MidiOutputScheduler::getSysexParameterKey(control_store.sysex_address(i)));
+                control_store.set_hardware_value(i, values[i]);
+            }
+        }
+        
+        for (int i=patch_changes_.size()-1; i>=0; i--)
+        {
+            if (control_store.sysex_address(patch_changes_.getReference(i).control_id) >= 0)
+            {
+                patch_changes_.remove(i);
+            }
+        }
+    }
+    else
+    {
+        patch_buffer.clear();
+    }
+    
+    // stable, so controls of the same message size keep id order
+    PatchChangeSizeComparator comparator;
+    patch_changes_.sort(comparator, true);
+    
+    for (int i=0; i<patch_changes_.size(); i++)
+    {
+        const PatchChangeMessage& change = patch_changes_.getReference(i);
+        
+        // the scheduler flushes pending controllers itself, but can't tell
+        // which parameter a sysex message sets
+        if (control_store.cc_number(change.control_id) < 0)
+        {
+            midi_output_port_->flushCoalescedMessage(MidiOutputScheduler::getSysexParameterKey(control_store.sysex_address(change.control_id)));
+        }
+        
+        patch_buffer.addEvent(change.message, sample_position++);
+        control_store.set_hardware_value(change.control_id, values[change.control_id]);
+    }
+    
+    midi_output_port_->sendBlockNow(patch_buffer);
 }
 
 bool MidiInstrument::updateMidiControl(String control_name,
@@ -15,6 +15,11 @@
 #include "MidiDefines.hpp"
 #include "MidiControl.hpp"
 #include "MidiInstrumentModel.hpp"
+#include "MidiPatchMorpher.hpp"
+#include "MidiPatchSimilarityIndex.hpp"
+#include "MidiPatchGenerator.hpp"
+#include "MidiControlEditHistory.hpp"
+#include "MidiControlCapture.hpp"
 
 class MidiInputPort;
 class MidiOutputPort;
@@ -51,9 +56,11 @@ public:
     void sendNoteOff(int midi_channel,
                      int midi_note_number,
                      float velocity);
-    void sendControllerEvent(int midi_channel,
+    // both return false if the message was not queued
+    bool sendControllerEvent(int midi_channel,
                              int controller_type,
                              int value);
+    bool sendSysexParameterChange(int control_id);
     
     short channel() { return channel_; }
     void set_channel(short channel)
@@ -72,21 +79,47 @@ public:
     void setMidiOutputPort(MidiOutputPort* midi_output_port)
     {
         midi_output_port_ = midi_output_port;
+        // whatever is on the other end hasn't heard from us yet
+        inst_model_->getControlStore().invalidateHardwareValues();
     }
     
-    MidiControl** getMidiControlIterator()
+    MidiControl* getMidiControlIterator()
     {
         return inst_model_->getMidiControlIterator();
     }
     
     bool updateMidiControl(String control_name, int control_value, bool sendMidiOnUpdate = false);
     
+    // Slider edits, for undo/redo. Undoing or redoing sends only the
+    // control it changes. Loading a patch clears the history.
+    void recordControlEdit(int control_id, int old_value, int new_value)
+    {
+        edit_history_.recordEdit(control_id, old_value, new_value);
+    }
+    void sealControlEdit() { edit_history_.sealLastEdit(); }
+    bool undoControlEdit();
+    bool redoControlEdit();
+    bool canUndoControlEdit() { return edit_history_.canUndo(); }
+    bool canRedoControlEdit() { return edit_history_.canRedo(); }
+    
+    // Records the controller and sysex parameter changes the instrument
+    // sends while capturing. Replay sends the recording back out through
+    // the output scheduler with its original timing.
+    void startControlCapture() { control_capture_.startCapture(); }
+    void stopControlCapture() { control_capture_.stopCapture(); }
+    bool isCapturingControls() { return control_capture_.isCapturing(); }
+    int getNumCapturedEvents() { return control_capture_.getNumEvents(); }
+    void replayControlCapture();
+    bool exportControlCapture(const File& midi_file) { return control_capture_.writeMidiFile(midi_file); }
+    
+    // Sends only the controls whose value differs from what the hardware
+    // is known to have, smallest messages first, as one block; a bulk dump
+    // is used instead when it is the cheaper way to send the changes.
     void sendMidiControlPatchData();
     
     // 1. Adds UI slider for MidiControl to MidiInstrumentControllerComponent
-    // 2. Adds MidiInstrument to MidiInstrumentControllerComponent
-    // 3. Adds MidiInstrument pointer to MidiControl
-    // 4. Adds MidiControlSlider to MidiControl
+    // 2. Adds MidiInstrument pointer to MidiControl
+    // 3. Adds MidiControlSlider to MidiControl
     void setupMidiControlInterface(MidiControl* midi_control);
     
     void handleIncomingMidiMessage(const MidiMessage& message);
@@ -96,10 +129,60 @@ public:
     var getInstrumentParametersVar();
     var getPatchVar(String patch_name);
     
+    // .mdpb files use the binary format, anything else is read and written
+    // as JSON. Loading sets the control values without sending them.
+    bool loadPatchFile(const File& patch_file);
+    bool savePatchFile(const File& patch_file, const String& patch_name);
+    // for patch I/O done elsewhere, see MidiPatchIOQueue
+    bool encodePatch(const File& patch_file, const String& patch_name, MemoryBlock& patch_data);
+    bool decodePatch(const MemoryBlock& patch_data);
+    
+    void copyControlValuesTo(Array<int>& values) { inst_model_->getControlStore().copyValuesTo(values); }
+    MidiPatchGenerator* createPatchGenerator() { return new MidiPatchGenerator(*inst_model_); }
+    // a copy of the model for the IO queue to decode patches into
+    MidiInstrumentModel* createScratchModel() { return inst_model_->createScratchCopy(); }
+    
+    // the patches closest to the current control values, see
+    // MidiPatchSimilarityIndex
+    void findSimilarPatches(const MidiPatchSimilarityIndex& index,
+                            int max_results,
+                            StringArray& patch_names,
+                            const String& exclude_name);
+    
+    // Morphs between two patches, given as values by control id (see
+    // MidiPatchIOQueue::loadPatchValues()). While a morph runs, the morph
+    // controller (mod wheel by default) moves the position instead of
+    // reaching the model.
+    void startPatchMorph(const Array<int>& patch_a, const Array<int>& patch_b);
+    void stopPatchMorph();
+    bool isMorphing() { return patch_morpher_ != nullptr && patch_morpher_->isMorphing(); }
+    // the A and B values of the last morph, see MidiPatchMorpher::getPatches()
+    bool getMorphPatchValues(Array<int>& patch_a, Array<int>& patch_b)
+    {
+        return patch_morpher_ != nullptr && patch_morpher_->getPatches(patch_a, patch_b);
+    }
+    void setMorphPosition(float position);
+    float getMorphPosition() { return patch_morpher_ != nullptr ? patch_morpher_->getMorphPosition() : 0.0f; }
+    void setMorphControllerNumber(int controller_number) { morph_controller_number_ = controller_number; }
+    
     String getManufacturerName();
     String getModelName();
     
 private:
+    struct PatchChangeMessage
+    {
+        int control_id;
+        MidiMessage message;
+    };
+    
+    struct PatchChangeSizeComparator
+    {
+        static int compareElements(const PatchChangeMessage& first, const PatchChangeMessage& second)
+        {
+            return first.message.getRawDataSize() - second.message.getRawDataSize();
+        }
+    };
+    
     ScopedPointer<MidiInstrumentModel> inst_model_;
     int instrument_id_;
     
@@ -113,6 +196,18 @@ private:
     MidiOutputPort* midi_output_port_;
     
     MidiInstrumentControllerComponent* controller_component_;
+    
+    // reused by sendMidiControlPatchData()
+    Array<PatchChangeMessage> patch_changes_;
+    
+    void applyControlEdit(int control_id, int value);
+    
+    MidiControlEditHistory edit_history_;
+    // written by the MIDI thread while capturing
+    MidiControlCapture control_capture_;
+    
+    ScopedPointer<MidiPatchMorpher> patch_morpher_;
+    int morph_controller_number_;
 };
 
 #endif /* MidiInstrument_hpp */
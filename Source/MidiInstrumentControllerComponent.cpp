@@ -39,7 +39,10 @@ MidiInstrumentControllerComponent::MidiInstrumentControllerComponent ()
 keyboard_component_(keyboard_state_, MidiKeyboardComponent::horizontalKeyboard),
 control_slider_tabs_(),
 patch_selector_menu_("Patch Selector Combo"),
+similar_patch_menu_("Similar Patches Combo"),
+generator_mode_menu_("Generator Mode Combo"),
 patch_name_label_("Patch Name", "Patch Name"),
+midi_instrument_(NULL),
 midi_instrument_properties_()
 {
     addAndMakeVisible(keyboard_component_);
@@ -52,6 +55,11 @@ midi_instrument_properties_()
     patch_selector_menu_.setJustificationType(Justification::topLeft);
     patch_selector_menu_.addListener(this);
     
+    addAndMakeVisible(similar_patch_menu_);
+    similar_patch_menu_.setJustificationType(Justification::topLeft);
+    similar_patch_menu_.setTextWhenNothingSelected("Similar Patches");
+    similar_patch_menu_.addListener(this);
+    
     addAndMakeVisible(patch_name_label_);
     patch_name_label_.setEditable(true);
     patch_name_label_.addListener(this);
@@ -63,16 +71,89 @@ midi_instrument_properties_()
     addAndMakeVisible(patch_save_button_);
     patch_save_button_.setButtonText("Save Patch");
     patch_save_button_.addListener(this);
+    
+    addAndMakeVisible(undo_button_);
+    undo_button_.setButtonText("Undo");
+    undo_button_.addShortcut(KeyPress('z', ModifierKeys::commandModifier, 0));
+    undo_button_.addListener(this);
+    
+    addAndMakeVisible(redo_button_);
+    redo_button_.setButtonText("Redo");
+    redo_button_.addShortcut(KeyPress('z', ModifierKeys::commandModifier | ModifierKeys::shiftModifier, 0));
+    redo_button_.addListener(this);
+    
+    addAndMakeVisible(capture_button_);
+    capture_button_.setButtonText("Capture");
+    capture_button_.addListener(this);
+    
+    addAndMakeVisible(replay_capture_button_);
+    replay_capture_button_.setButtonText("Replay");
+    replay_capture_button_.addListener(this);
+    
+    addAndMakeVisible(export_capture_button_);
+    export_capture_button_.setButtonText("Export Capture");
+    export_capture_button_.addListener(this);
+    
+    addAndMakeVisible(morph_a_button_);
+    morph_a_button_.setButtonText("Morph A");
+    morph_a_button_.addListener(this);
+    
+    addAndMakeVisible(morph_b_button_);
+    morph_b_button_.setButtonText("Morph B");
+    morph_b_button_.addListener(this);
+    
+    addAndMakeVisible(morph_slider_);
+    morph_slider_.setSliderStyle(Slider::LinearHorizontal);
+    morph_slider_.setRange(0.0, 1.0);
+    morph_slider_.addListener(this);
+    
+    addAndMakeVisible(generator_mode_menu_);
+    generator_mode_menu_.addItem(MidiPatchGenerator::getGenerationModeName(MidiPatchGenerator::RandomPatches),
+                                 MidiPatchGenerator::RandomPatches+1);
+    generator_mode_menu_.addItem(MidiPatchGenerator::getGenerationModeName(MidiPatchGenerator::MutatePatch),
+                                 MidiPatchGenerator::MutatePatch+1);
+    generator_mode_menu_.addItem(MidiPatchGenerator::getGenerationModeName(MidiPatchGenerator::CrossoverPatches),
+                                 MidiPatchGenerator::CrossoverPatches+1);
+    generator_mode_menu_.setSelectedId(MidiPatchGenerator::RandomPatches+1, dontSendNotification);
+    
+    addAndMakeVisible(generate_button_);
+    generate_button_.setButtonText("Generate");
+    generate_button_.addListener(this);
+    
+    startTimerHz(MIDI_CONTROL_UPDATE_HZ);
 }
 
 MidiInstrumentControllerComponent::~MidiInstrumentControllerComponent()
 {
-
+    stopTimer();
+    
+    // lets any queued saves finish while the library is still around
+    patch_io_queue_ = nullptr;
+    
+    if (patch_library_)
+    {
+        patch_library_->removeChangeListener(this);
+    }
 }
 
 void MidiInstrumentControllerComponent::addMidiInstrument(MidiInstrument* midi_instrument)
 {
     midi_instrument_ = midi_instrument;
+    
+    patch_io_queue_ = nullptr;
+    similarity_index_ = nullptr;
+    patch_generator_ = nullptr;
+    
+    if (patch_library_)
+    {
+        patch_library_->removeChangeListener(this);
+    }
+    
+    patch_library_ = new MidiPatchLibrary(midi_instrument_->getManufacturerName(),
+                                          midi_instrument_->getModelName());
+    patch_library_->addChangeListener(this);
+    
+    patch_io_queue_ = new MidiPatchIOQueue(*patch_library_, this);
 }
 
 void MidiInstrumentControllerComponent::addMidiKeyboardStateListener(MidiKeyboardStateListener* const listener)
@@ -120,11 +201,34 @@ void MidiInstrumentControllerComponent::resized()
     patch_selector_menu_.setBounds(x_pos, y_pos, 200, 40);
     x_pos += 220;
     patch_name_label_.setBounds(x_pos, y_pos, 200, 40);
+    x_pos += 220;
+    similar_patch_menu_.setBounds(x_pos, y_pos, 200, 40);
     x_pos = 0;
     y_pos += 40;
     patch_request_button_.setBounds(x_pos, y_pos, 100, 40);
     x_pos += 110;
     patch_save_button_.setBounds(x_pos, y_pos, 100, 40);
+    x_pos += 110;
+    morph_a_button_.setBounds(x_pos, y_pos, 150, 40);
+    x_pos += 160;
+    morph_slider_.setBounds(x_pos, y_pos, 300, 40);
+    x_pos += 310;
+    morph_b_button_.setBounds(x_pos, y_pos, 150, 40);
+    x_pos = 0;
+    y_pos += 50;
+    generator_mode_menu_.setBounds(x_pos, y_pos, 150, 40);
+    x_pos += 160;
+    generate_button_.setBounds(x_pos, y_pos, 100, 40);
+    x_pos += 110;
+    undo_button_.setBounds(x_pos, y_pos, 80, 40);
+    x_pos += 90;
+    redo_button_.setBounds(x_pos, y_pos, 80, 40);
+    x_pos += 90;
+    capture_button_.setBounds(x_pos, y_pos, 100, 40);
+    x_pos += 110;
+    replay_capture_button_.setBounds(x_pos, y_pos, 80, 40);
+    x_pos += 90;
+    export_capture_button_.setBounds(x_pos, y_pos, 120, 40);
 }
 
 
@@ -164,6 +268,85 @@ void MidiInstrumentControllerComponent::buttonClicked (Button* button)
     {
         savePatch();
     }
+    else if (button == &undo_button_)
+    {
+        midi_instrument_->undoControlEdit();
+    }
+    else if (button == &redo_button_)
+    {
+        midi_instrument_->redoControlEdit();
+    }
+    else if (button == &capture_button_)
+    {
+        if (midi_instrument_->isCapturingControls())
+        {
+            midi_instrument_->stopControlCapture();
+            capture_button_.setButtonText("Capture");
+            printf("captured %d events\n", midi_instrument_->getNumCapturedEvents());
+        }
+        else
+        {
+            midi_instrument_->startControlCapture();
+            capture_button_.setButtonText("Stop Capture");
+        }
+    }
+    else if (button == &replay_capture_button_)
+    {
+        midi_instrument_->replayControlCapture();
+    }
+    else if (button == &export_capture_button_)
+    {
+        exportControlCapture();
+    }
+    else if (button == &generate_button_)
+    {
+        generatePatches();
+    }
+    else if (button == &morph_a_button_ || button == &morph_b_button_)
+    {
+        String selected_patch_name(patch_selector_menu_.getText());
+        
+        if (selected_patch_name.isEmpty())
+        {
+            return;
+        }
+        
+        if (button == &morph_a_button_)
+        {
+            morph_patch_a_name_ = selected_patch_name;
+            morph_a_button_.setButtonText("A: " + selected_patch_name);
+        }
+        else
+        {
+            morph_patch_b_name_ = selected_patch_name;
+            morph_b_button_.setButtonText("B: " + selected_patch_name);
+        }
+        
+        updatePatchMorph();
+    }
+}
+
+void MidiInstrumentControllerComponent::sliderValueChanged (Slider* slider)
+{
+    if (slider == &morph_slider_ && midi_instrument_)
+    {
+        midi_instrument_->setMorphPosition((float)morph_slider_.getValue());
+    }
+}
+
+void MidiInstrumentControllerComponent::updatePatchMorph()
+{
+    if (!midi_instrument_ || !patch_io_queue_ ||
+        morph_patch_a_name_.isEmpty() || morph_patch_b_name_.isEmpty())
+    {
+        return;
+    }
+    
+    StringArray patch_names;
+    patch_names.add(morph_patch_a_name_);
+    patch_names.add(morph_patch_b_name_);
+    
+    patch_io_queue_->loadPatchValues(patch_names, midi_instrument_->createScratchModel());
 }
 
 void MidiInstrumentControllerComponent::labelTextChanged (Label *labelThatHasChanged)
@@ -187,6 +370,15 @@ void MidiInstrumentControllerComponent::comboBoxChanged (ComboBox* comboBoxThatH
             loadSelectedPatch(selected_patch_name);
         }
     }
+    else if (comboBoxThatHasChanged == &similar_patch_menu_)
+    {
+        String similar_patch_name(similar_patch_menu_.getText());
+        if (similar_patch_name.length())
+        {
+            setSelectedPatchByName(similar_patch_name);
+            loadSelectedPatch(similar_patch_name);
+        }
+    }
 }
 
 void MidiInstrumentControllerComponent::loadSelectedPatch(String selected_patch_name)
@@ -194,64 +386,197 @@ void MidiInstrumentControllerComponent::loadSelectedPatch(String selected_patch_
     midi_instrument_properties_.set_patch_name(selected_patch_name);
     patch_name_label_.setText(selected_patch_name, NotificationType::dontSendNotification);
     
-    String patch_file_name = selected_patch_name + String(".mdp");
-    printf("loading patch file: %s\n", patch_file_name.toRawUTF8());
-    String manufacturer_name(midi_instrument_->getManufacturerName());
-    String model_name(midi_instrument_->getModelName());
+    printf("loading patch: %s\n", selected_patch_name.toRawUTF8());
     
-    String patch_file_path(MidiotFileUtils::getInstrumentPatchFolderPath(manufacturer_name, model_name));
-    patch_file_path += patch_file_name;
-    printf("--> at path: %s\n", patch_file_path.toRawUTF8());
+    patch_io_queue_->loadPatch(selected_patch_name);
+}
+
+void MidiInstrumentControllerComponent::patchLoadFinished(const String& patch_name,
+                                                          const MemoryBlock& patch_data,
+                                                          bool succeeded)
+{
+    // the selection may have moved on while the file was being read
+    if (!succeeded || patch_name != midi_instrument_properties_.patch_name())
+    {
+        return;
+    }
     
-    File patch_file(patch_file_path);
-    if (!patch_file.existsAsFile()) {
+    // a running morph would overwrite the patch on its next step
+    midi_instrument_->stopPatchMorph();
+    
+    if (midi_instrument_->decodePatch(patch_data))
+    {
+        resyncAllMidiControlSliders();
+        midi_instrument_->sendMidiControlPatchData();
+        updateSimilarPatchMenu();
+    }
+}
+
+void MidiInstrumentControllerComponent::patchValuesFinished(const StringArray& patch_names,
+                                                            const Array<int>& patch_values,
+                                                            bool succeeded)
+{
+    // either end of the morph may have changed while these were being read
+    if (!succeeded || patch_names.size() != 2 ||
+        patch_names[0] != morph_patch_a_name_ ||
+        patch_names[1] != morph_patch_b_name_)
+    {
         return;
     }
     
-    FileInputStream patch_file_stream(patch_file);
-    String patch_json_string(patch_file_stream.readEntireStreamAsString());
+    const int num_values = patch_values.size() / 2;
     
-    printf("patch_json_string: %s\n", patch_json_string.toRawUTF8());
-    var patch_json(JSON::fromString(patch_json_string));
+    Array<int> patch_a;
+    Array<int> patch_b;
+    patch_a.addArray(patch_values.begin(), num_values);
+    patch_b.addArray(patch_values.begin() + num_values, num_values);
     
-    if (auto* const patch_obj = patch_json.getDynamicObject())
+    midi_instrument_->startPatchMorph(patch_a, patch_b);
+    morph_slider_.setValue(0.0, dontSendNotification);
+}
+
+void MidiInstrumentControllerComponent::patchSaveFinished(const String& patch_name,
+                                                          const File& patch_file,
+                                                          bool succeeded)
+{
+    if (!succeeded)
     {
-        if (patch_obj->hasProperty("manufacturer") &&
-            patch_obj->hasProperty("model_name") &&
-            patch_obj->hasProperty("patch_name") &&
-            patch_obj->hasProperty("params"))
+        printf("failed to save patch: %s\n", patch_file.getFullPathName().toRawUTF8());
+        return;
+    }
+    
+    patch_library_->addPatchFile(patch_file);
+    updatePatchSelectorMenu(patch_name);
+    rebuildSimilarityIndex();
+}
+
+void MidiInstrumentControllerComponent::similarityIndexFinished(MidiPatchSimilarityIndex* index)
+{
+    similarity_index_ = index;
+    updateSimilarPatchMenu();
+}
+
+void MidiInstrumentControllerComponent::bankWriteFinished(const File& bank_file,
+                                                          int num_patches,
+                                                          bool succeeded)
+{
+    if (!succeeded)
+    {
+        printf("failed to write bank: %s\n", bank_file.getFullPathName().toRawUTF8());
+        return;
+    }
+    
+    printf("added %d patches to bank: %s\n", num_patches, bank_file.getFullPathName().toRawUTF8());
+    
+    // the library remaps the bank and tells us when the menu needs updating
+    patch_library_->rescanNow();
+}
+
+void MidiInstrumentControllerComponent::generatePatches()
+{
+    if (!midi_instrument_ || !patch_io_queue_)
+    {
+        return;
+    }
+    
+    if (!patch_generator_)
+    {
+        patch_generator_ = midi_instrument_->createPatchGenerator();
+    }
+    
+    const MidiPatchGenerator::GenerationMode mode = (MidiPatchGenerator::GenerationMode)(generator_mode_menu_.getSelectedId() - 1);
+    
+    Array<int> patch_a;
+    Array<int> patch_b;
+    
+    if (mode == MidiPatchGenerator::MutatePatch)
+    {
+        midi_instrument_->copyControlValuesTo(patch_a);
+    }
+    else if (mode == MidiPatchGenerator::CrossoverPatches)
+    {
+        // the morpher already holds both patches, so there is nothing to
+        // read and a running morph is left alone
+        if (!midi_instrument_->getMorphPatchValues(patch_a, patch_b))
         {
-            printf("VALIDATED patch file\n");
-            
-            var manufacturer_json = patch_obj->getProperty("manufacturer");
-            
-            String patch_name = patch_json["patch_name"];
-            printf("patch_name: %s\n", patch_name.toRawUTF8());
-            
-            if (patch_json["manufacturer"] == manufacturer_name &&
-                patch_json["model_name"] == model_name)
-            {
-                printf("validated manufacturer/model\n");
-                
-                var param_json = patch_json["params"];
-                if (auto* const param_obj = param_json.getDynamicObject())
-                {
-                    for (auto prop : param_obj->getProperties())
-                    {
-                        String property_name = prop.name.toString();
-                        int property_value = param_json[property_name.toRawUTF8()];
-                        
-                        printf("name: %s\t\tvalue: %d\n", property_name.toRawUTF8(), property_value);
-                        
-                        midi_instrument_->updateMidiControl(property_name,
-                                                            property_value);
-                    }
-                    
-                    midi_instrument_->sendMidiControlPatchData();
-                }
-            }
+            printf("crossover needs both morph patches\n");
+            return;
         }
     }
+    
+    // a new name for every batch, so earlier batches stay in the bank
+    const String name_prefix = MidiPatchGenerator::getGenerationModeName(mode) + " " +
+                               Time::getCurrentTime().formatted("%y%m%d-%H%M%S");
+    
+    StringArray patch_names;
+    Array<int> patch_values;
+    
+    if (!patch_generator_->generateBatch(mode,
+                                         MIDI_GENERATED_PATCHES_PER_BATCH,
+                                         name_prefix,
+                                         patch_a,
+                                         patch_b,
+                                         patch_names,
+                                         patch_values))
+    {
+        return;
+    }
+    
+    patch_io_queue_->addPatchesToBank(MidiotFileUtils::getInstrumentBankFile(midi_instrument_->getManufacturerName(),
+                                                                             midi_instrument_->getModelName()),
+                                      patch_generator_->getDefinitionHash(),
+                                      patch_generator_->getNumValues(),
+                                      patch_names,
+                                      patch_values);
+}
+
+void MidiInstrumentControllerComponent::exportControlCapture()
+{
+    if (!midi_instrument_ || midi_instrument_->getNumCapturedEvents() == 0)
+    {
+        return;
+    }
+    
+    String manufacturer_name = midi_instrument_->getManufacturerName();
+    String model_name = midi_instrument_->getModelName();
+    
+    String capture_file_path = MidiotFileUtils::getInstrumentCaptureFolderPath(manufacturer_name, model_name) + MidiotFileUtils::generatePatchFileName(manufacturer_name, model_name) + MidiotFileUtils::getCaptureFileExtension();
+    
+    File capture_file(capture_file_path);
+    
+    if (midi_instrument_->exportControlCapture(capture_file))
+    {
+        printf("wrote capture: %s\n", capture_file.getFullPathName().toRawUTF8());
+    }
+}
+
+void MidiInstrumentControllerComponent::rebuildSimilarityIndex()
+{
+    if (midi_instrument_ && patch_io_queue_)
+    {
+        patch_io_queue_->buildSimilarityIndex(midi_instrument_->createScratchModel());
+    }
+}
+
+void MidiInstrumentControllerComponent::updateSimilarPatchMenu()
+{
+    similar_patch_menu_.clear(dontSendNotification);
+    
+    if (!similarity_index_ || !midi_instrument_)
+    {
+        return;
+    }
+    
+    StringArray patch_names;
+    midi_instrument_->findSimilarPatches(*similarity_index_,
+                                         MIDI_SIMILAR_PATCHES_SHOWN,
+                                         patch_names,
+                                         midi_instrument_properties_.patch_name());
+    
+    for (int i=0; i<patch_names.size(); i++)
+    {
+        similar_patch_menu_.addItem(patch_names[i], i+1);
+    }
 }
 
 void MidiInstrumentControllerComponent::handleNoteOn(
@@ -284,17 +609,18 @@ void MidiInstrumentControllerComponent::savePatch()
         patch_name_label_.setText(patch_name, NotificationType::dontSendNotification);
     }
     
-    var patch = midi_instrument_->getPatchVar(patch_name);
-    String patch_json = JSON::toString(patch);
-    printf("patch_json: %s\n", patch_json.toRawUTF8());
-    File inst_patch_folder = MidiotFileUtils::getInstrumentPatchFolder(manufacturer_name, model_name);
-    
-    String patch_file_path = inst_patch_folder.getFullPathName() + File::separatorString + patch_name + MidiotFileUtils::getPatchFileExtension();
+    // the queue creates the folder; nothing here touches the disk
+    String patch_file_path = MidiotFileUtils::getInstrumentPatchFolderPath(manufacturer_name, model_name) + patch_name + MidiotFileUtils::getBinaryPatchFileExtension();
     
     File patch_file(patch_file_path);
-    patch_file.replaceWithText(patch_json);
+    MemoryBlock patch_data;
     
-    updatePatchSelectorMenu(patch_name);
+    if (!midi_instrument_->encodePatch(patch_file, patch_name, patch_data))
+    {
+        return;
+    }
+    
+    patch_io_queue_->savePatch(patch_name, patch_file, patch_data);
 }
 
 void MidiInstrumentControllerComponent::setSelectedPatchByName(String patch_name, bool loadPatch)
@@ -318,19 +644,20 @@ void MidiInstrumentControllerComponent::setSelectedPatchByName(String patch_name
 
 void MidiInstrumentControllerComponent::updatePatchSelectorMenu(String selected_patch_name)
 {
-    String manufacturer_name = midi_instrument_->getManufacturerName();
-    String model_name = midi_instrument_->getModelName();
-    File patch_folder(MidiotFileUtils::getInstrumentPatchFolder(manufacturer_name, model_name));
+    if (!patch_library_)
+    {
+        return;
+    }
     
     patch_selector_menu_.removeListener(this);
-    patch_selector_menu_.clear();
+    patch_selector_menu_.clear(dontSendNotification);
+    
+    StringArray patch_names;
+    patch_library_->getPatchNames(patch_names);
     
-    Array<File> patch_files;
-    patch_folder.findChildFiles(patch_files, File::findFiles, true, "*.mdp");
-    for (int i=0; i<patch_files.size(); i++)
+    for (int i=0; i<patch_names.size(); i++)
     {
-        String patch_file_name(patch_files[i].getFileNameWithoutExtension());
-        patch_selector_menu_.addItem(patch_file_name, i+1);
+        patch_selector_menu_.addItem(patch_names[i], i+1);
     }
     
     if (selected_patch_name.length())
@@ -351,6 +678,12 @@ MidiControlSlider* MidiInstrumentControllerComponent::addMidiControlSlider(MidiC
                              1.0);
     control_slider->addListener(midi_control);
     control_sliders_.add(control_slider);
+    
+    int control_id = midi_control->control_id();
+    midi_controls_.set(control_id, midi_control);
+    control_sliders_by_id_.set(control_id, control_slider);
+    pending_control_values_.set(control_id, 0);
+    pending_control_flags_.set(control_id, false);
 #if USE_MIDI_COMPONENT
     control_slider_tabs_.addAndMakeVisible(control_slider);
 //    midi_control_tab_.addMidiControlAndMakeVisible(control_slider);
@@ -371,3 +704,109 @@ void MidiInstrumentControllerComponent::setKeyboardMidiOutputChannel(short outpu
 {
     keyboard_component_.setMidiChannel(output_channel);
 }
+
+void MidiInstrumentControllerComponent::postMidiControlValue(int control_id, int value)
+{
+    if (MessageManager::existsAndIsCurrentThread())
+    {
+        applyMidiControlValue(control_id, value);
+    }
+    else
+    {
+        // never wait on the GUI here; a full queue is picked up as an
+        // overflow and answered with a resync on the next tick
+        control_update_queue_.push(control_id, value);
+    }
+}
+
+void MidiInstrumentControllerComponent::timerCallback()
+{
+    MidiControlUpdateQueue::ControlUpdate updates[128];
+    int num_updates;
+    
+    while ((num_updates = control_update_queue_.pop(updates, 128)) > 0)
+    {
+        for (int i=0; i<num_updates; i++)
+        {
+            int control_id = updates[i].control_id;
+            
+            if (!isPositiveAndBelow(control_id, pending_control_values_.size()))
+            {
+                continue;
+            }
+            
+            if (!pending_control_flags_.getUnchecked(control_id))
+            {
+                pending_control_flags_.set(control_id, true);
+                pending_control_ids_.add(control_id);
+            }
+            
+            // keep only the latest value per control
+            pending_control_values_.set(control_id, updates[i].value);
+        }
+    }
+    
+    bool resync = control_update_queue_.checkAndClearOverflow();
+    
+    if (resync_requested_.exchange(0) != 0)
+    {
+        resync = true;
+    }
+    
+    if (resync)
+    {
+        resyncAllMidiControlSliders();
+    }
+    
+    // follows the morph controller while the slider isn't being dragged
+    if (midi_instrument_ && midi_instrument_->isMorphing() && !morph_slider_.isMouseButtonDown())
+    {
+        morph_slider_.setValue(midi_instrument_->getMorphPosition(), dontSendNotification);
+    }
+    
+    for (int i=0; i<pending_control_ids_.size(); i++)
+    {
+        int control_id = pending_control_ids_.getUnchecked(i);
+        applyMidiControlValue(control_id, pending_control_values_.getUnchecked(control_id));
+        pending_control_flags_.set(control_id, false);
+    }
+    
+    pending_control_ids_.clearQuick();
+}
+
+void MidiInstrumentControllerComponent::changeListenerCallback(ChangeBroadcaster* source)
+{
+    if (source == patch_library_)
+    {
+        // patches were added, removed or edited outside the app
+        updatePatchSelectorMenu(midi_instrument_properties_.patch_name());
+        rebuildSimilarityIndex();
+    }
+}
+
+void MidiInstrumentControllerComponent::applyMidiControlValue(int control_id, int value)
+{
+    MidiControlSlider* control_slider = control_sliders_by_id_[control_id];
+    
+    if (control_slider)
+    {
+        control_slider->setValue(value, dontSendNotification);
+    }
+}
+
+void MidiInstrumentControllerComponent::resyncAllMidiControlSliders()
+{
+    // either updates were dropped or a whole patch arrived, so the queue
+    // doesn't tell the whole story; read every control's current value
+    for (int i=0; i<midi_controls_.size(); i++)
+    {
+        if (MidiControl* midi_control = midi_controls_.getUnchecked(i))
+        {
+            applyMidiControlValue(i, midi_control->value());
+        }
+        
+        pending_control_flags_.set(i, false);
+    }
+    
+    pending_control_ids_.clearQuick();
+}
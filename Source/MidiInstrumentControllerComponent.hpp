@@ -19,11 +19,19 @@
 #include "NoteGridProperties.hpp"
 #include "MidiClockUtilities.hpp"
 #include "MidiInstrumentControllerProperties.hpp"
+#include "MidiControlUpdateQueue.hpp"
+#include "MidiPatchLibrary.hpp"
+#include "MidiPatchIOQueue.hpp"
+#include "MidiPatchGenerator.hpp"
 
 #define MIDI_CONTROLS_PER_TAB       18
 
 #define USE_MIDI_COMPONENT  1
 
+#define MIDI_CONTROL_UPDATE_HZ      60
+
+#define MIDI_SIMILAR_PATCHES_SHOWN  10
+
 
 using std::vector;
 
@@ -152,7 +160,11 @@ class MidiInstrumentControllerComponent : public GraphicsComponentBase,
 private MidiKeyboardStateListener,
 private Button::Listener,
 private Label::Listener,
-private ComboBox::Listener
+private ComboBox::Listener,
+private Slider::Listener,
+private ChangeListener,
+private MidiPatchIOQueue::Listener,
+private Timer
 {
 public:
     enum GridResolution {
@@ -193,15 +205,53 @@ public:
     void buttonClicked (Button* button) override;
     void labelTextChanged (Label *labelThatHasChanged) override;
     void comboBoxChanged (ComboBox* comboBoxThatHasChanged) override;
+    void sliderValueChanged (Slider* slider) override;
 
     void savePatch();
     
+    // fills the menu from the patch library index; never touches the disk
     void updatePatchSelectorMenu(String selected_patch_name = "");
     void setSelectedPatchByName(String patch_name, bool loadPatch = false);
 
     void setKeyboardMidiOutputChannel(short output_channel);
     
+    // Called by MidiControl whenever its value changes. From the message
+    // thread the slider is moved directly; from any other thread the update
+    // is queued and applied on the next timer tick.
+    void postMidiControlValue(int control_id, int value);
+    
+    // Refreshes every slider from its control on the next timer tick.
+    // Safe from any thread.
+    void requestMidiControlResync() { resync_requested_.set(1); }
+    
 private:
+    void timerCallback() override;
+    void changeListenerCallback(ChangeBroadcaster* source) override;
+    void patchLoadFinished(const String& patch_name,
+                           const MemoryBlock& patch_data,
+                           bool succeeded) override;
+    void patchValuesFinished(const StringArray& patch_names,
+                             const Array<int>& patch_values,
+                             bool succeeded) override;
+    void patchSaveFinished(const String& patch_name,
+                           const File& patch_file,
+                           bool succeeded) override;
+    void similarityIndexFinished(MidiPatchSimilarityIndex* index) override;
+    void bankWriteFinished(const File& bank_file,
+                           int num_patches,
+                           bool succeeded) override;
+    // a batch in the mode picked in generator_mode_menu_, added to the bank
+    void generatePatches();
+    // writes the last capture to the instrument's capture folder
+    void exportControlCapture();
+    void rebuildSimilarityIndex();
+    // lists the patches closest to the current sound
+    void updateSimilarPatchMenu();
+    void applyMidiControlValue(int control_id, int value);
+    void resyncAllMidiControlSliders();
+    // once both ends have a patch, reads them on the IO queue; the morph
+    // starts in patchValuesFinished()
+    void updatePatchMorph();
 
     MidiKeyboardState keyboard_state_;
     MidiKeyboardComponent keyboard_component_;
@@ -209,12 +259,46 @@ private:
     MidiControlTabbedComponent control_slider_tabs_;
     
     OwnedArray<MidiControlSlider> control_sliders_;
+    
+    // indexed by MidiControl::control_id()
+    Array<MidiControl*> midi_controls_;
+    Array<MidiControlSlider*> control_sliders_by_id_;
+    
+    // MIDI thread -> message thread slider updates, coalesced per control
+    MidiControlUpdateQueue control_update_queue_;
+    Atomic<int> resync_requested_;
+    Array<int> pending_control_values_;
+    Array<bool> pending_control_flags_;
+    Array<int> pending_control_ids_;
 
     ComboBox patch_selector_menu_;
+    ScopedPointer<MidiPatchLibrary> patch_library_;
+    // declared after patch_library_, which it reads from
+    ScopedPointer<MidiPatchIOQueue> patch_io_queue_;
+    ScopedPointer<MidiPatchSimilarityIndex> similarity_index_;
+    ComboBox similar_patch_menu_;
     
     Label patch_name_label_;
     TextButton patch_request_button_;
     TextButton patch_save_button_;
+    TextButton undo_button_;
+    TextButton redo_button_;
+    
+    TextButton capture_button_;
+    TextButton replay_capture_button_;
+    TextButton export_capture_button_;
+    
+    // each takes the patch selected in patch_selector_menu_
+    TextButton morph_a_button_;
+    TextButton morph_b_button_;
+    Slider morph_slider_;
+    String morph_patch_a_name_;
+    String morph_patch_b_name_;
+    
+    // crossover uses the morph A and B patches
+    ComboBox generator_mode_menu_;
+    TextButton generate_button_;
+    ScopedPointer<MidiPatchGenerator> patch_generator_;
     
     
     MidiInstrument* midi_instrument_;
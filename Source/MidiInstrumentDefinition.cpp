@@ -0,0 +1,311 @@
+//
+//  MidiInstrumentDefinition.cpp
+//  Midiot
+//
+//  Created by Sean Bratnober on 2/6/18.
+//
+//
+
+#include "MidiInstrumentDefinition.hpp"
+
+MidiInstrumentDefinition::MidiInstrumentDefinition()
+: sysex_manufacturer_id_(0),
+sysex_device_id_(0),
+sysex_group_number_high_(0),
+sysex_group_number_low_(0)
+{
+}
+
+MidiInstrumentDefinition::~MidiInstrumentDefinition()
+{
+}
+
+MidiInstrumentDefinition* MidiInstrumentDefinition::createFromTable(const String manufacturer,
+                                                                    const String model_name,
+                                                                    uint8 sysex_manufacturer_id,
+                                                                    uint8 sysex_device_id,
+                                                                    uint8 sysex_group_number_high,
+                                                                    uint8 sysex_group_number_low,
+                                                                    uint8 sysex_model_id,
+                                                                    const MidiControlTableEntry* entries,
+                                                                    int num_entries,
+                                                                    const MidiSysexBlockEntry* blocks,
+                                                                    int num_blocks)
+{
+    MidiInstrumentDefinition* definition = new MidiInstrumentDefinition();
+    definition->manufacturer_ = manufacturer;
+    definition->model_name_ = model_name;
+    definition->sysex_manufacturer_id_ = sysex_manufacturer_id;
+    definition->sysex_device_id_ = sysex_device_id;
+    definition->sysex_group_number_high_ = sysex_group_number_high;
+    definition->sysex_group_number_low_ = sysex_group_number_low;
+    definition->sysex_model_id_.add(sysex_model_id);
+    
+    definition->controls_.resize(num_entries);
+    
+    for (int i=0; i<num_entries; i++)
+    {
+        const MidiControlTableEntry& entry = entries[i];
+        MidiControlDefinition& control = definition->controls_.getReference(i);
+        
+        control.name_ = entry.name;
+        control.initial_value_ = entry.initial_value;
+        control.cc_number_ = entry.cc_number;
+        control.has_sysex_ = true;
+        control.address_high_ = entry.address_high;
+        control.address_mid_ = entry.address_mid;
+        control.address_low_ = entry.address_low;
+        control.size_bytes_ = 1;
+        control.range_min_ = entry.range_min;
+        control.range_max_ = entry.range_max;
+        
+        if (entry.value_map)
+        {
+            control.value_map_.addArray(entry.value_map, entry.value_map_size);
+        }
+    }
+    
+    if (blocks)
+    {
+        definition->sysex_blocks_.addArray(blocks, num_blocks);
+    }
+    
+    return definition;
+}
+
+MidiInstrumentDefinition* MidiInstrumentDefinition::createFromJSON(const var& json)
+{
+    if (!json.hasProperty("manufacturer") ||
+        !json.hasProperty("model_name") ||
+        !json["controls"].isArray())
+    {
+        return NULL;
+    }
+    
+    ScopedPointer<MidiInstrumentDefinition> definition = new MidiInstrumentDefinition();
+    definition->manufacturer_ = json["manufacturer"].toString();
+    definition->model_name_ = json["model_name"].toString();
+    
+    const var& sysex_json = json["sysex"];
+    
+    if (sysex_json.isObject())
+    {
+        definition->sysex_manufacturer_id_ = (uint8)(int)sysex_json["manufacturer_id"];
+        definition->sysex_device_id_ = (uint8)(int)sysex_json["device_id"];
+        
+        const var& group_number = sysex_json["group_number"];
+        
+        if (group_number.size() == 2)
+        {
+            definition->sysex_group_number_high_ = (uint8)(int)group_number[0];
+            definition->sysex_group_number_low_ = (uint8)(int)group_number[1];
+        }
+        
+        const var& model_id = sysex_json["model_id"];
+        
+        for (int i=0; i<model_id.size(); i++)
+        {
+            definition->sysex_model_id_.add((uint8)(int)model_id[i]);
+        }
+    }
+    
+    const var& controls_json = json["controls"];
+    definition->controls_.resize(controls_json.size());
+    
+    for (int i=0; i<controls_json.size(); i++)
+    {
+        const var control_json = controls_json[i];
+        MidiControlDefinition& control = definition->controls_.getReference(i);
+        
+        if (!control_json.hasProperty("name"))
+        {
+            return NULL;
+        }
+        
+        control.name_ = control_json["name"].toString();
+        control.initial_value_ = control_json["initial_value"];
+        
+        if (control_json.hasProperty("cc"))
+        {
+            control.cc_number_ = (short)(int)control_json["cc"];
+            
+            if (!isPositiveAndBelow((int)control.cc_number_, 128))
+            {
+                return NULL;
+            }
+            
+            const var& cc_range = control_json["cc_range"];
+            
+            if (cc_range.size() == 2)
+            {
+                control.cc_range_min_ = (short)(int)cc_range[0];
+                control.cc_range_max_ = (short)(int)cc_range[1];
+            }
+        }
+        
+        const var& sysex_address = control_json["sysex_address"];
+        
+        if (sysex_address.size() == 4)
+        {
+            control.has_sysex_ = true;
+            control.param_table_ = (short)(int)sysex_address[0];
+            control.address_high_ = (short)(int)sysex_address[1];
+            control.address_mid_ = (short)(int)sysex_address[2];
+            control.address_low_ = (short)(int)sysex_address[3];
+            const int size_bytes = control_json.hasProperty("size_bytes")
+                                    ? (int)control_json["size_bytes"]
+                                    : 1;
+            
+            if (size_bytes < 1 || size_bytes > MIDI_MAX_SYSEX_PARAM_BYTES)
+            {
+                return NULL;
+            }
+            
+            control.size_bytes_ = (short)size_bytes;
+        }
+        
+        const var& range = control_json["range"];
+        
+        if (range.size() == 2)
+        {
+            control.range_min_ = range[0];
+            control.range_max_ = range[1];
+        }
+        else
+        {
+            control.range_min_ = control.cc_range_min_;
+            control.range_max_ = control.cc_range_max_;
+        }
+        
+        const var& value_map = control_json["value_map"];
+        
+        for (int j=0; j<value_map.size(); j++)
+        {
+            control.value_map_.add(value_map[j]);
+        }
+    }
+    
+    const var& blocks_json = json["sysex_blocks"];
+    
+    for (int i=0; i<blocks_json.size(); i++)
+    {
+        const var block_json = blocks_json[i];
+        
+        if (block_json.size() != 4)
+        {
+            return NULL;
+        }
+        
+        MidiSysexBlockEntry block;
+        block.address_high = (uint8)(int)block_json[0];
+        block.address_mid = (uint8)(int)block_json[1];
+        block.address_low = (uint8)(int)block_json[2];
+        block.size_bytes = (short)(int)block_json[3];
+        definition->sysex_blocks_.add(block);
+    }
+    
+    return definition.release();
+}
+
+MidiInstrumentDefinition* MidiInstrumentDefinition::createFromFile(const File& definition_file)
+{
+    if (!definition_file.existsAsFile())
+    {
+        return NULL;
+    }
+    
+    return createFromJSON(JSON::parse(definition_file));
+}
+
+var MidiInstrumentDefinition::toJSON()
+{
+    DynamicObject* definition_obj = new DynamicObject();
+    definition_obj->setProperty("manufacturer", manufacturer_);
+    definition_obj->setProperty("model_name", model_name_);
+    
+    DynamicObject* sysex_obj = new DynamicObject();
+    sysex_obj->setProperty("manufacturer_id", sysex_manufacturer_id_);
+    sysex_obj->setProperty("device_id", sysex_device_id_);
+    
+    Array<var> group_number;
+    group_number.add(sysex_group_number_high_);
+    group_number.add(sysex_group_number_low_);
+    sysex_obj->setProperty("group_number", group_number);
+    
+    Array<var> model_id;
+    for (int i=0; i<sysex_model_id_.size(); i++)
+    {
+        model_id.add(sysex_model_id_[i]);
+    }
+    sysex_obj->setProperty("model_id", model_id);
+    definition_obj->setProperty("sysex", var(sysex_obj));
+    
+    Array<var> controls;
+    
+    for (int i=0; i<controls_.size(); i++)
+    {
+        const MidiControlDefinition& control = controls_.getReference(i);
+        DynamicObject* control_obj = new DynamicObject();
+        
+        control_obj->setProperty("name", control.name_);
+        control_obj->setProperty("initial_value", control.initial_value_);
+        
+        if (control.cc_number_ >= 0)
+        {
+            control_obj->setProperty("cc", control.cc_number_);
+            
+            Array<var> cc_range;
+            cc_range.add(control.cc_range_min_);
+            cc_range.add(control.cc_range_max_);
+            control_obj->setProperty("cc_range", cc_range);
+        }
+        
+        if (control.has_sysex_)
+        {
+            Array<var> sysex_address;
+            sysex_address.add(control.param_table_);
+            sysex_address.add(control.address_high_);
+            sysex_address.add(control.address_mid_);
+            sysex_address.add(control.address_low_);
+            control_obj->setProperty("sysex_address", sysex_address);
+            control_obj->setProperty("size_bytes", control.size_bytes_);
+        }
+        
+        Array<var> range;
+        range.add(control.range_min_);
+        range.add(control.range_max_);
+        control_obj->setProperty("range", range);
+        
+        if (control.value_map_.size())
+        {
+            Array<var> value_map;
+            for (int j=0; j<control.value_map_.size(); j++)
+            {
+                value_map.add(control.value_map_[j]);
+            }
+            control_obj->setProperty("value_map", value_map);
+        }
+        
+        controls.add(var(control_obj));
+    }
+    
+    definition_obj->setProperty("controls", controls);
+    
+    Array<var> blocks;
+    
+    for (int i=0; i<sysex_blocks_.size(); i++)
+    {
+        const MidiSysexBlockEntry& block = sysex_blocks_.getReference(i);
+        
+        Array<var> block_json;
+        block_json.add(block.address_high);
+        block_json.add(block.address_mid);
+        block_json.add(block.address_low);
+        block_json.add(block.size_bytes);
+        blocks.add(block_json);
+    }
+    
+    definition_obj->setProperty("sysex_blocks", blocks);
+    
+    return var(definition_obj);
+}
@@ -0,0 +1,140 @@
+//
+//  MidiInstrumentDefinition.hpp
+//  Midiot
+//
+//  Created by Sean Bratnober on 2/6/18.
+//
+//
+
+#ifndef MidiInstrumentDefinition_hpp
+#define MidiInstrumentDefinition_hpp
+
+#include <stdio.h>
+#include "../JuceLibraryCode/JuceHeader.h"
+
+// One row of a compiled-in instrument table. Built-in models describe
+// their controls as a static array of these; every sysex parameter is a
+// single byte in param table 0.
+struct MidiControlTableEntry
+{
+    const char* name;
+    int initial_value;
+    short cc_number;            // -1 if the control has no CC
+    uint8 address_high;
+    uint8 address_mid;
+    uint8 address_low;
+    int range_min;
+    int range_max;
+    const int* value_map;       // optional, sysex value -> control value
+    int value_map_size;
+};
+
+// Largest sysex parameter, in bytes, a control can span
+const int MIDI_MAX_SYSEX_PARAM_BYTES = 4;
+
+// A contiguous run of sysex parameter memory that the instrument sends
+// and accepts as one bulk dump message.
+struct MidiSysexBlockEntry
+{
+    uint8 address_high;
+    uint8 address_mid;
+    uint8 address_low;
+    short size_bytes;
+};
+
+class MidiControlDefinition
+{
+public:
+    MidiControlDefinition()
+    : initial_value_(0),
+    cc_number_(-1),
+    cc_range_min_(0),
+    cc_range_max_(127),
+    has_sysex_(false),
+    param_table_(0),
+    address_high_(0),
+    address_mid_(0),
+    address_low_(0),
+    size_bytes_(0),
+    range_min_(0),
+    range_max_(0)
+    {
+    }
+    
+    String name_;
+    int initial_value_;
+    
+    short cc_number_;
+    short cc_range_min_;
+    short cc_range_max_;
+    
+    bool has_sysex_;
+    short param_table_;
+    short address_high_;
+    short address_mid_;
+    short address_low_;
+    short size_bytes_;
+    int range_min_;
+    int range_max_;
+    
+    // sysex values as sent by the instrument, mapped to control values;
+    // empty when the two are the same
+    Array<int> value_map_;
+};
+
+// Everything needed to build a MidiInstrumentModel: identity, sysex ids
+// and the control list. Comes either from a compiled-in table or from a
+// JSON file in the Midiot Instruments folder, e.g.
+//
+//  { "manufacturer": "Yamaha", "model_name": "Reface CS",
+//    "sysex": { "manufacturer_id": 67, "device_id": 0,
+//               "group_number": [127, 28], "model_id": [3] },
+//    "controls": [
+//      { "name": "Volume", "initial_value": 0, "cc": 7,
+//        "sysex_address": [0, 48, 0, 0], "size_bytes": 1,
+//        "range": [0, 127] },
+//      { "name": "Osc Type", "cc": 80, "sysex_address": [0, 48, 0, 6],
+//        "range": [0, 127], "value_map": [0, 32, 64, 95, 127] } ],
+//    "sysex_blocks": [ [48, 0, 0, 22] ] }
+//
+// sysex_blocks lists [address_high, address_mid, address_low, size] for
+// each bulk dump block of a patch, in the order they are sent. A control
+// size outside 1 to MIDI_MAX_SYSEX_PARAM_BYTES rejects the definition.
+class MidiInstrumentDefinition
+{
+public:
+    MidiInstrumentDefinition();
+    ~MidiInstrumentDefinition();
+    
+    static MidiInstrumentDefinition* createFromTable(const String manufacturer,
+                                                     const String model_name,
+                                                     uint8 sysex_manufacturer_id,
+                                                     uint8 sysex_device_id,
+                                                     uint8 sysex_group_number_high,
+                                                     uint8 sysex_group_number_low,
+                                                     uint8 sysex_model_id,
+                                                     const MidiControlTableEntry* entries,
+                                                     int num_entries,
+                                                     const MidiSysexBlockEntry* blocks = NULL,
+                                                     int num_blocks = 0);
+    
+    // return NULL if the data is not a usable definition
+    static MidiInstrumentDefinition* createFromJSON(const var& json);
+    static MidiInstrumentDefinition* createFromFile(const File& definition_file);
+    
+    var toJSON();
+    
+    String manufacturer_;
+    String model_name_;
+    
+    uint8 sysex_manufacturer_id_;
+    uint8 sysex_device_id_;
+    uint8 sysex_group_number_high_;
+    uint8 sysex_group_number_low_;
+    Array<uint8> sysex_model_id_;
+    
+    Array<MidiControlDefinition> controls_;
+    Array<MidiSysexBlockEntry> sysex_blocks_;
+};
+
+#endif /* MidiInstrumentDefinition_hpp */
@@ -8,17 +8,249 @@
 
 #include "MidiInstrumentModel.hpp"
 
+const int MIDI_STEPPED_CONTROL_MAX_STEPS = 16;
 
+MidiInstrumentModel::MidiInstrumentModel(MidiInstrumentDefinition* definition)
+:
+manufacturer_(definition->manufacturer_),
+model_name_(definition->model_name_),
+sysex_manufacturer_id_(definition->sysex_manufacturer_id_),
+sysex_device_id_(definition->sysex_device_id_),
+sysex_group_number_high_(definition->sysex_group_number_high_),
+sysex_group_number_low_(definition->sysex_group_number_low_),
+sysex_model_id_bytes_(0),
+definition_hash_(0),
+definition_(definition)
+{
+    for (int i=0; i<NUM_MIDI_CC; i++)
+    {
+        cc_redirect_table_[i] = -1;
+    }
+    
+    for (int i=0; i<SYSEX_MODEL_ID_BYTES; i++)
+    {
+        sysex_model_id_[i] = 0;
+    }
+    
+    sysex_model_id_bytes_ = jmin(definition->sysex_model_id_.size(), SYSEX_MODEL_ID_BYTES);
+    
+    for (int i=0; i<sysex_model_id_bytes_; i++)
+    {
+        sysex_model_id_[i] = definition->sysex_model_id_[i];
+    }
+    
+    const int num_controls = definition->controls_.size();
+    control_store_.ensureStorageAllocated(num_controls);
+    midi_controls_.ensureStorageAllocated(num_controls);
+    
+    for (int i=0; i<num_controls; i++)
+    {
+        const MidiControlDefinition& control = definition->controls_.getReference(i);
+        
+        int sysex_address = -1;
+        int range_min = control.cc_range_min_;
+        int range_max = control.cc_range_max_;
+        
+        if (control.has_sysex_)
+        {
+            sysex_address = MidiControl::SysexControl::packAddress(control.param_table_,
+                                                                   control.address_high_,
+                                                                   control.address_mid_,
+                                                                   control.address_low_);
+            range_min = control.range_min_;
+            range_max = control.range_max_;
+        }
+        
+        addMidiControl(control.name_,
+                       control.initial_value_,
+                       control.cc_number_,
+                       sysex_address,
+                       control.has_sysex_ ? control.size_bytes_ : 0,
+                       range_min,
+                       range_max);
+    }
+    
+    buildSysexBlockLayout();
+}
+
+int MidiInstrumentModel::addMidiControl(String name,
+                                        int intital_value,
+                                        MidiControl::ContinuousControl* cc_control,
+                                        MidiControl::SysexControl* sysex_control)
+{
+    ScopedPointer<MidiControl::ContinuousControl> cc_description(cc_control);
+    ScopedPointer<MidiControl::SysexControl> sysex_description(sysex_control);
+    
+    short cc_number = -1;
+    int sysex_address = -1;
+    short sysex_size_bytes = 0;
+    int range_min = 0;
+    int range_max = 0;
+    
+    if (cc_description)
+    {
+        cc_number = cc_description->number();
+        range_min = cc_description->range_min();
+        range_max = cc_description->range_max();
+    }
+    
+    if (sysex_description)
+    {
+        sysex_address = sysex_description->packed_address();
+        sysex_size_bytes = sysex_description->size_bytes();
+        range_min = sysex_description->range_min();
+        range_max = sysex_description->range_max();
+    }
+    
+    return addMidiControl(name,
+                          intital_value,
+                          cc_number,
+                          sysex_address,
+                          sysex_size_bytes,
+                          range_min,
+                          range_max);
+}
+
+int MidiInstrumentModel::addMidiControl(const String& name,
+                                        int initial_value,
+                                        short cc_number,
+                                        int sysex_address,
+                                        short sysex_size_bytes,
+                                        int range_min,
+                                        int range_max)
+{
+    int control_id = control_store_.addControl(name,
+                                               initial_value,
+                                               cc_number,
+                                               sysex_address,
+                                               sysex_size_bytes,
+                                               range_min,
+                                               range_max);
+    
+    midi_controls_.add(MidiControl(&control_store_, control_id));
+    definition_hash_ = 0;
+    
+    if (cc_number >= 0)
+    {
+        cc_redirect_table_[cc_number] = control_id;
+    }
+    
+    control_name_index_.set(name, control_id);
+    
+    if (sysex_address >= 0)
+    {
+        sysex_address_index_.set(sysex_address, control_id);
+    }
+    
+    return control_id;
+}
 
 bool MidiInstrumentModel::handleMidiControlEvent(const MidiMessage& message)
 {
     int controller_number = message.getControllerNumber();
+    int control_id = cc_redirect_table_[controller_number];
+    
+    if (control_id < 0)
+    {
+        return false;
+    }
     
-    midi_controls_[cc_redirect_table_[controller_number]]->handleMidiControlEvent(message);
+    midi_controls_.getReference(control_id).handleMidiControlEvent(message);
     
     return true;
 }
 
+static uint32 hashBytes(uint32 hash, const void* data, size_t num_bytes)
+{
+    // FNV-1a
+    const uint8* bytes = static_cast<const uint8*>(data);
+    
+    for (size_t i=0; i<num_bytes; i++)
+    {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    
+    return hash;
+}
+
+static uint32 hashString(uint32 hash, const String& string)
+{
+    // include the terminator so "ab","c" and "a","bc" differ
+    return hashBytes(hash, string.toRawUTF8(), string.getNumBytesAsUTF8() + 1);
+}
+
+static uint32 hashInt(uint32 hash, int value)
+{
+    const uint32 little_endian_value = ByteOrder::swapIfBigEndian((uint32)value);
+    return hashBytes(hash, &little_endian_value, sizeof(little_endian_value));
+}
+
+uint32 MidiInstrumentModel::getDefinitionHash()
+{
+    if (definition_hash_ != 0)
+    {
+        return definition_hash_;
+    }
+    
+    uint32 hash = 2166136261u;
+    
+    hash = hashString(hash, manufacturer());
+    hash = hashString(hash, model_name());
+    
+    for (int i=0; i<control_store_.size(); i++)
+    {
+        hash = hashString(hash, control_store_.name(i));
+        hash = hashInt(hash, control_store_.cc_number(i));
+        hash = hashInt(hash, control_store_.sysex_address(i));
+        hash = hashInt(hash, control_store_.sysex_size_bytes(i));
+    }
+    
+    // 0 means "not computed yet"
+    definition_hash_ = (hash != 0) ? hash : 1;
+    
+    return definition_hash_;
+}
+
+MidiInstrumentModel* MidiInstrumentModel::createScratchCopy()
+{
+    MidiInstrumentModel* scratch_model = new MidiInstrumentModel(manufacturer(), model_name());
+    
+    for (int i=0; i<control_store_.size(); i++)
+    {
+        scratch_model->addMidiControl(control_store_.name(i),
+                                      control_store_.value(i),
+                                      control_store_.cc_number(i),
+                                      control_store_.sysex_address(i),
+                                      control_store_.sysex_size_bytes(i),
+                                      control_store_.range_min(i),
+                                      control_store_.range_max(i));
+    }
+    
+    return scratch_model;
+}
+
+bool MidiInstrumentModel::isSteppedControl(int control_id)
+{
+    if (getControlValueMap(control_id).size() > 0)
+    {
+        return true;
+    }
+    
+    return control_store_.range_max(control_id) - control_store_.range_min(control_id) < MIDI_STEPPED_CONTROL_MAX_STEPS;
+}
+
+const Array<int>& MidiInstrumentModel::getControlValueMap(int control_id)
+{
+    static const Array<int> no_value_map;
+    
+    if (!definition_ || !isPositiveAndBelow(control_id, definition_->controls_.size()))
+    {
+        return no_value_map;
+    }
+    
+    return definition_->controls_.getReference(control_id).value_map_;
+}
+
 const String MidiInstrumentModel::manufacturer()
 {
     return manufacturer_.toString();
@@ -31,35 +263,49 @@ const String MidiInstrumentModel::model_name()
 
 MidiControl* MidiInstrumentModel::getMidiControl(String control_name)
 {
-    MidiControl* requested_midi_control = NULL;
+    int control_id = getMidiControlId(control_name);
     
-    MidiControl** ctrl_iter;
-    for (ctrl_iter = getMidiControlIterator();
-         ctrl_iter != getMidiControlIteratorEnd();
-         ctrl_iter++)
+    if (control_id < 0)
     {
-        MidiControl* midi_control = *ctrl_iter;
-        
-        if (control_name == midi_control->name())
-        {
-            requested_midi_control = midi_control;
-            break;
-        }
+        return NULL;
     }
     
-    return requested_midi_control;
+    return &midi_controls_.getReference(control_id);
 }
 
-void MidiInstrumentModel::sendMidiControlPatchData()
+int MidiInstrumentModel::getMidiControlId(const String& control_name)
+{
+    if (!control_name_index_.contains(control_name))
+    {
+        return -1;
+    }
+    
+    return control_name_index_[control_name];
+}
+
+int MidiInstrumentModel::getMidiControlIdForSysexAddress(short param_table,
+                                                         short address_high,
+                                                         short address_mid,
+                                                         short address_low)
 {
-    MidiControl** ctrl_iter;
+    int packed_address = MidiControl::SysexControl::packAddress(param_table,
+                                                                address_high,
+                                                                address_mid,
+                                                                address_low);
     
-    for (ctrl_iter = getMidiControlIterator();
-         ctrl_iter != getMidiControlIteratorEnd();
-         ctrl_iter++)
+    if (!sysex_address_index_.contains(packed_address))
     {
-        MidiControl* midi_control = *ctrl_iter;
-        midi_control->send_value_to_midi();
+        return -1;
+    }
+    
+    return sysex_address_index_[packed_address];
+}
+
+void MidiInstrumentModel::sendMidiControlPatchData()
+{
+    for (int i=0; i<midi_controls_.size(); i++)
+    {
+        midi_controls_.getReference(i).send_value_to_midi();
     }
 }
 
@@ -83,3 +329,153 @@ bool MidiInstrumentModel::updateMidiControl(String control_name,
     
     return success;
 }
+
+void MidiInstrumentModel::buildSysexBlockLayout()
+{
+    sysex_blocks_.clearQuick();
+    sysex_block_offsets_.clearQuick();
+    sysex_block_data_.clearQuick();
+    sysex_block_control_ids_.clearQuick();
+    sysex_blocks_received_.clearQuick();
+    
+    if (!definition_)
+    {
+        return;
+    }
+    
+    sysex_blocks_.addArray(definition_->sysex_blocks_);
+    
+    int total_size = 0;
+    
+    for (int i=0; i<sysex_blocks_.size(); i++)
+    {
+        sysex_block_offsets_.add(total_size);
+        total_size += sysex_blocks_.getReference(i).size_bytes;
+    }
+    
+    sysex_block_data_.insertMultiple(0, 0, total_size);
+    sysex_block_control_ids_.insertMultiple(0, -1, total_size);
+    sysex_blocks_received_.insertMultiple(0, false, sysex_blocks_.size());
+    
+    for (int control_id=0; control_id<control_store_.size(); control_id++)
+    {
+        int sysex_address = control_store_.sysex_address(control_id);
+        
+        if (sysex_address < 0)
+        {
+            continue;
+        }
+        
+        uint8 address_high = (sysex_address >> 16) & 0xFF;
+        uint8 address_mid = (sysex_address >> 8) & 0xFF;
+        uint8 address_low = sysex_address & 0xFF;
+        
+        int block_index = findSysexBlock(address_high, address_mid, address_low);
+        
+        if (block_index >= 0)
+        {
+            int offset = sysex_block_offsets_[block_index]
+                       + address_low - sysex_blocks_.getReference(block_index).address_low;
+            sysex_block_control_ids_.set(offset, control_id);
+        }
+    }
+    
+    for (int i=0; i<sysex_blocks_.size(); i++)
+    {
+        writeControlValuesToSysexBlock(i);
+    }
+}
+
+int MidiInstrumentModel::findSysexBlock(uint8 address_high, uint8 address_mid, uint8 address_low)
+{
+    for (int i=0; i<sysex_blocks_.size(); i++)
+    {
+        const MidiSysexBlockEntry& block = sysex_blocks_.getReference(i);
+        
+        if (block.address_high == address_high &&
+            block.address_mid == address_mid &&
+            address_low >= block.address_low &&
+            address_low < block.address_low + block.size_bytes)
+        {
+            return i;
+        }
+    }
+    
+    return -1;
+}
+
+void MidiInstrumentModel::writeControlValuesToSysexBlock(int block_index)
+{
+    const int block_start = sysex_block_offsets_[block_index];
+    const int block_end = block_start + sysex_blocks_.getReference(block_index).size_bytes;
+    const int* values = control_store_.values();
+    
+    uint8* block_data = sysex_block_data_.getRawDataPointer();
+    const int* block_control_ids = sysex_block_control_ids_.getRawDataPointer();
+    
+    for (int i=block_start; i<block_end; i++)
+    {
+        int control_id = block_control_ids[i];
+        
+        if (control_id < 0)
+        {
+            continue;
+        }
+        
+        int sysex_value = controlValueToSysexValue(control_id, values[control_id]);
+        int size_bytes = jmin((int)control_store_.sysex_size_bytes(control_id), block_end - i);
+        
+        // multi-byte values go out 7 bits per byte, most significant first
+        for (int j=size_bytes-1; j>=0; j--)
+        {
+            block_data[i+j] = (uint8)(sysex_value & 0x7F);
+            sysex_value >>= 7;
+        }
+    }
+}
+
+int MidiInstrumentModel::controlValueToSysexValue(int control_id, int value)
+{
+    if (!definition_)
+    {
+        return value;
+    }
+    
+    const Array<int>& value_map = definition_->controls_.getReference(control_id).value_map_;
+    
+    if (value_map.size() == 0)
+    {
+        return value;
+    }
+    
+    // nearest mapped value wins, so in-between slider positions still
+    // land on a valid setting
+    int best_index = 0;
+    
+    for (int i=1; i<value_map.size(); i++)
+    {
+        if (std::abs(value_map.getUnchecked(i) - value) < std::abs(value_map.getUnchecked(best_index) - value))
+        {
+            best_index = i;
+        }
+    }
+    
+    return best_index;
+}
+
+int MidiInstrumentModel::sysexValueToControlValue(int control_id, int sysex_value)
+{
+    if (!definition_)
+    {
+        return sysex_value;
+    }
+    
+    const Array<int>& value_map = definition_->controls_.getReference(control_id).value_map_;
+    
+    if (value_map.size() == 0)
+    {
+        return sysex_value;
+    }
+    
+    return value_map[jlimit(0, value_map.size() - 1, sysex_value)];
+}
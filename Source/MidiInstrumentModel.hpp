@@ -13,6 +13,7 @@
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "MidiDefines.hpp"
 #include "MidiControl.hpp"
+#include "MidiInstrumentDefinition.hpp"
 
 const int SYSEX_MODEL_ID_BYTES = 16;
 
@@ -25,7 +26,10 @@ public:
     model_name_(model_name),
     sysex_manufacturer_id_(0),
     sysex_device_id_(0),
-    sysex_model_id_bytes_(0)
+    sysex_group_number_high_(0),
+    sysex_group_number_low_(0),
+    sysex_model_id_bytes_(0),
+    definition_hash_(0)
     {
         for (int i=0; i<NUM_MIDI_CC; i++)
         {
@@ -38,40 +42,55 @@ public:
         }
     }
     
-    ~MidiInstrumentModel()
+    // Builds the model from a definition table or file; takes ownership
+    // of the definition.
+    MidiInstrumentModel(MidiInstrumentDefinition* definition);
+    
+    virtual ~MidiInstrumentModel()
     {}
     
+    // cc_control and sysex_control only describe the mapping; they are
+    // copied into the control store and deleted. All controls must be
+    // added before the model is handed to a MidiInstrument.
     int addMidiControl(String name,
                        int intital_value = 0,
                        MidiControl::ContinuousControl* cc_control = NULL,
-                       MidiControl::SysexControl* sysex_control = NULL)
-    {
-        int control_id = midi_controls_.size();
-        
-        midi_controls_.add(new MidiControl(name,
-                                           control_id,
-                                           intital_value,
-                                           cc_control,
-                                           sysex_control));
-        
-        if (cc_control)
-        {
-            cc_redirect_table_[cc_control->number()] = control_id;
-        }
-        
-        return control_id;
-    }
+                       MidiControl::SysexControl* sysex_control = NULL);
+    
+    int addMidiControl(const String& name,
+                       int initial_value,
+                       short cc_number,
+                       int sysex_address,
+                       short sysex_size_bytes,
+                       int range_min,
+                       int range_max);
     
-    MidiControl** getMidiControlIterator() { return midi_controls_.begin(); }
-    MidiControl** getMidiControlIteratorEnd() { return midi_controls_.end(); }
+    MidiControl* getMidiControlIterator() { return midi_controls_.begin(); }
+    MidiControl* getMidiControlIteratorEnd() { return midi_controls_.end(); }
     
     bool updateMidiControl(String control_name,
                            int control_value,
                            bool sendMidiOnUpdate = false);
     
     MidiControl* getMidiControl(String control_name);
+    MidiControl* getMidiControl(int control_id)
+    {
+        return isPositiveAndBelow(control_id, midi_controls_.size())
+                ? &midi_controls_.getReference(control_id)
+                : NULL;
+    }
+    
+    // constant time lookups, -1 if there is no such control
+    int getMidiControlId(const String& control_name);
+    int getMidiControlIdForSysexAddress(short param_table,
+                                        short address_high,
+                                        short address_mid,
+                                        short address_low);
+    
+    int getNumMidiControls() { return midi_controls_.size(); }
     
     bool handleMidiControlEvent(const MidiMessage& message);
+    // returns true if control values changed
     virtual bool handleMidiSysexEvent(const MidiMessage& message) { return false; }
 
     virtual bool handleSysexIdRequest(const MidiMessage& message) { return false; }
@@ -80,19 +99,81 @@ public:
     
     void sendMidiControlPatchData();
     
+    // Sysex output, implemented by models that know their instrument's
+    // sysex format. Both return false if the model can't build the message;
+    // a patch dump also waits for the instrument to have sent one first.
+    virtual bool createSysexParameterChange(int control_id, MidiMessage& message) { return false; }
+    virtual bool createSysexPatchDump(MidiBuffer& patch_dump) { return false; }
+    virtual bool createSysexPatchDumpRequest(MidiMessage& message) { return false; }
+    
     const String manufacturer();
     const String model_name();
     
+    MidiControlStore& getControlStore() { return control_store_; }
+    
+    // Identifies the control layout: manufacturer, model and every control's
+    // name and mapping, in id order. Patches stored by control id are only
+    // valid for a model with the same hash.
+    uint32 getDefinitionHash();
+    
+    // Controls with a value map or only a handful of values; these jump
+    // between settings rather than sweeping.
+    bool isSteppedControl(int control_id);
+    // The only values a value-mapped control (LFO assign, oscillator type
+    // and so on) can take; empty for controls that take their whole range.
+    const Array<int>& getControlValueMap(int control_id);
+    
+    // NULL for models built by hand with addMidiControl()
+    MidiInstrumentDefinition* getDefinition() { return definition_; }
+    
+    // A plain model with the same controls and definition hash, holding
+    // the current values; scratch space for decoding patches on another
+    // thread. Knows nothing about sysex. The caller owns it.
+    MidiInstrumentModel* createScratchCopy();
+    
 protected:
-    OwnedArray<MidiControl> midi_controls_;
+    MidiControlStore control_store_;
+    // one view per control id, contiguous
+    Array<MidiControl> midi_controls_;
     int cc_redirect_table_[NUM_MIDI_CC];
+    HashMap<String, int> control_name_index_;
+    HashMap<int, int> sysex_address_index_;
     Identifier model_name_;
     Identifier manufacturer_;
     
     uint8 sysex_manufacturer_id_;
     uint8 sysex_device_id_;
+    uint8 sysex_group_number_high_;
+    uint8 sysex_group_number_low_;
     uint8 sysex_model_id_[SYSEX_MODEL_ID_BYTES];
     uint8 sysex_model_id_bytes_;
+    
+    // 0 until first asked for
+    uint32 definition_hash_;
+    
+    ScopedPointer<MidiInstrumentDefinition> definition_;
+    
+    // Bulk dump layout, built from the definition's sysex blocks.
+    // sysex_block_data_ holds the last known bytes of every block back to
+    // back, so parameters without a control (voice names, reserved bytes)
+    // survive a round trip; sysex_block_control_ids_ gives, per byte, the
+    // control whose value starts there or -1. Incoming dumps write the
+    // bytes on the MIDI thread and outgoing dumps on the message thread,
+    // so both hold sysex_block_lock_. A block's bytes only mean anything
+    // once the instrument has sent it, see sysex_blocks_received_.
+    void buildSysexBlockLayout();
+    int findSysexBlock(uint8 address_high, uint8 address_mid, uint8 address_low);
+    void writeControlValuesToSysexBlock(int block_index);
+    
+    int controlValueToSysexValue(int control_id, int value);
+    int sysexValueToControlValue(int control_id, int sysex_value);
+    
+    Array<MidiSysexBlockEntry> sysex_blocks_;
+    Array<int> sysex_block_offsets_;
+    Array<uint8> sysex_block_data_;
+    Array<int> sysex_block_control_ids_;
+    Array<bool> sysex_blocks_received_;
+    CriticalSection sysex_block_lock_;
 };
 
 
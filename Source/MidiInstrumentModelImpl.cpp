@@ -7,1891 +7,490 @@
 //
 
 #include "MidiInstrumentModelImpl.hpp"
+#include "MidiotFileUtils.hpp"
 
-const uint8 NUM_REFACE_CS_PARAMS = 18;
+// F0 43 0n 7F 1C bh bl model ah am al ... cs F7, without the data
+const int REFACE_BULK_DUMP_OVERHEAD_BYTES = 13;
+const int REFACE_MAX_BULK_DUMP_DATA_BYTES = 128;
 
-const uint8 REFACE_CS_LFO_ASSIGN = 2;
-const uint8 REFACE_CS_PORTAMENTO = 5;
-const uint8 REFACE_CS_OSC_TYPE = 6;
-const uint8 REFACE_CS_EFFECT_TYPE = 16;
+// LFO Assign, Osc Type and Effect Type report 0-4 over sysex but sit on
+// evenly spaced CC values
+const int REFACE_CS_VALUE_MAP[] = { 0, 32, 64, 95, 127 };
 
-
-YamahaRefaceCSModel::YamahaRefaceCSModel()
-: MidiInstrumentModel("Yamaha", "Reface CS")
+//                name                  init   cc   address high/mid/low  range min/max  value map
+const MidiControlTableEntry REFACE_CS_CONTROLS[] =
 {
-    sysex_manufacturer_id_ = 0x43;
-    sysex_device_id_ = 0x00;
-    sysex_model_id_bytes_ = 1;
-    sysex_model_id_[0] = 0x03;
-    sysex_group_number_high_ = 0x7f;
-    sysex_group_number_low_ = 0x1c;
-    
-    addMidiControl(String("Volume"),        // name
-                   0,                               // initial value
-                   
-                   createContinuousControl(7,      // cc number
-                                           0,       // range_min
-                                           127),    // range_max
-                   
-                   createSysexControl(0,            // param table
-                                      0x30,         // address_high
-                                      0x00,         // address_mid
-                                      0x00,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
+    { "Volume",             0,    7,  0x30, 0x00, 0x00,  0x00, 0x7F,  NULL, 0 },
+    { "LFO Assign",         0,   78,  0x30, 0x00, 0x02,  0x00, 0x7F,  REFACE_CS_VALUE_MAP, 5 },
+    { "LFO Depth",          0,   77,  0x30, 0x00, 0x03,  0x00, 0x7F,  NULL, 0 },
+    { "LFO Speed",          0,   76,  0x30, 0x00, 0x04,  0x00, 0x7F,  NULL, 0 },
+    { "Portamento",         0,   20,  0x30, 0x00, 0x05,  0x00, 0x7F,  NULL, 0 },
+    { "Osc Type",           0,   80,  0x30, 0x00, 0x06,  0x00, 0x7F,  REFACE_CS_VALUE_MAP, 5 },
+    { "Osc Texture",        0,   81,  0x30, 0x00, 0x07,  0x00, 0x7F,  NULL, 0 },
+    { "Osc Mod",            0,   82,  0x30, 0x00, 0x08,  0x00, 0x7F,  NULL, 0 },
+    { "Filter Cutoff",      0,   74,  0x30, 0x00, 0x09,  0x00, 0x7F,  NULL, 0 },
+    { "Filter Resonance",   0,   71,  0x30, 0x00, 0x0A,  0x00, 0x7F,  NULL, 0 },
+    { "EG Balance",         0,   83,  0x30, 0x00, 0x0B,  0x00, 0x7F,  NULL, 0 },
+    { "EG Attack",          0,   73,  0x30, 0x00, 0x0C,  0x00, 0x7F,  NULL, 0 },
+    { "EG Decay",           0,   75,  0x30, 0x00, 0x0D,  0x00, 0x7F,  NULL, 0 },
+    { "EG Sustain",         0,   79,  0x30, 0x00, 0x0E,  0x00, 0x7F,  NULL, 0 },
+    { "EG Release",         0,   72,  0x30, 0x00, 0x0F,  0x00, 0x7F,  NULL, 0 },
+    { "Effect Type",        0,   17,  0x30, 0x00, 0x10,  0x00, 0x7F,  REFACE_CS_VALUE_MAP, 5 },
+    { "Effect Depth",       0,   18,  0x30, 0x00, 0x11,  0x00, 0x7F,  NULL, 0 },
+    { "Effect Rate",        0,   19,  0x30, 0x00, 0x12,  0x00, 0x7F,  NULL, 0 },
+};
+
+const MidiSysexBlockEntry REFACE_CS_BLOCKS[] =
+{
+    { 0x30, 0x00, 0x00, 22 },       // tone
+};
 
+const MidiSysexBlockEntry REFACE_DX_BLOCKS[] =
+{
+    { 0x30, 0x00, 0x00, 0x26 },     // voice common
+    { 0x31, 0x00, 0x00, 0x1C },     // operator 1
+    { 0x31, 0x01, 0x00, 0x1C },     // operator 2
+    { 0x31, 0x02, 0x00, 0x1C },     // operator 3
+    { 0x31, 0x03, 0x00, 0x1C },     // operator 4
+};
+
+//                name                        init   cc   address high/mid/low  range min/max  value map
+const MidiControlTableEntry REFACE_DX_CONTROLS[] =
+{
+    { "Transpose",                   25,   -1,  0x30, 0x00, 0x0C,  0x28, 0x58,  NULL, 0 },
+    { "Part Mode",                    0,   -1,  0x30, 0x00, 0x0D,  0x00, 0x02,  NULL, 0 },
+    { "Portamento",                   0,   -1,  0x30, 0x00, 0x0E,  0x00, 0x7F,  NULL, 0 },
+    { "Pitch Bend Range",            12,   -1,  0x30, 0x00, 0x0F,  0x28, 0x58,  NULL, 0 },
+    { "Algorithm",                    0,   80,  0x30, 0x00, 0x10,  0x00, 0x0B,  NULL, 0 },
+    { "LFO Wave",                     0,   -1,  0x30, 0x00, 0x11,  0x00, 0x06,  NULL, 0 },
+    { "LFO Speed",                    0,   -1,  0x30, 0x00, 0x12,  0x00, 0x7F,  NULL, 0 },
+    { "LFO Delay",                    0,   -1,  0x30, 0x00, 0x13,  0x00, 0x7F,  NULL, 0 },
+    { "LFO Pitch Mod",                0,   -1,  0x30, 0x00, 0x14,  0x00, 0x7F,  NULL, 0 },
+    { "Pitch EG Rate 1",              0,   -1,  0x30, 0x00, 0x15,  0x00, 0x7F,  NULL, 0 },
+    { "Pitch EG Rate 2",              0,   -1,  0x30, 0x00, 0x16,  0x00, 0x7F,  NULL, 0 },
+    { "Pitch EG Rate 3",              0,   -1,  0x30, 0x00, 0x17,  0x00, 0x7F,  NULL, 0 },
+    { "Pitch EG Rate 4",              0,   -1,  0x30, 0x00, 0x18,  0x00, 0x7F,  NULL, 0 },
+    { "Pitch EG Level 1",            49,   -1,  0x30, 0x00, 0x19,  0x10, 0x70,  NULL, 0 },
+    { "Pitch EG Level 2",            49,   -1,  0x30, 0x00, 0x1A,  0x10, 0x70,  NULL, 0 },
+    { "Pitch EG Level 3",            49,   -1,  0x30, 0x00, 0x1B,  0x10, 0x70,  NULL, 0 },
+    { "Pitch EG Level 4",            49,   -1,  0x30, 0x00, 0x1C,  0x10, 0x70,  NULL, 0 },
+    { "Effect 1 Type",                0,   -1,  0x30, 0x00, 0x1D,  0x00, 0x07,  NULL, 0 },
+    { "Effect 1 Parameter 1",         0,   -1,  0x30, 0x00, 0x1E,  0x00, 0x7F,  NULL, 0 },
+    { "Effect 1 Parameter 2",         0,   -1,  0x30, 0x00, 0x1F,  0x00, 0x7F,  NULL, 0 },
+    { "Effect 2 Type",                0,   -1,  0x30, 0x00, 0x20,  0x00, 0x07,  NULL, 0 },
+    { "Effect 2 Parameter 1",         0,   -1,  0x30, 0x00, 0x21,  0x00, 0x7F,  NULL, 0 },
+    { "Effect 2 Parameter 2",         0,   -1,  0x30, 0x00, 0x22,  0x00, 0x7F,  NULL, 0 },
+    { "Op 1 On/Off",                  1,   -1,  0x31, 0x00, 0x00,  0x00, 0x01,  NULL, 0 },
+    { "Op 1 EG Rate 1",               0,   -1,  0x31, 0x00, 0x01,  0x00, 0x7F,  NULL, 0 },
+    { "Op 1 EG Rate 2",               0,   -1,  0x31, 0x00, 0x02,  0x00, 0x7F,  NULL, 0 },
+    { "Op 1 EG Rate 3",               0,   -1,  0x31, 0x00, 0x03,  0x00, 0x7F,  NULL, 0 },
+    { "Op 1 EG Rate 4",               0,   -1,  0x31, 0x00, 0x04,  0x00, 0x7F,  NULL, 0 },
+    { "Op 1 EG Level 1",              0,   -1,  0x31, 0x00, 0x05,  0x00, 0x7F,  NULL, 0 },
+    { "Op 1 EG Level 2",              0,   -1,  0x31, 0x00, 0x06,  0x00, 0x7F,  NULL, 0 },
+    { "Op 1 EG Level 3",              0,   -1,  0x31, 0x00, 0x07,  0x00, 0x7F,  NULL, 0 },
+    { "Op 1 EG Level 4",              0,   -1,  0x31, 0x00, 0x08,  0x00, 0x7F,  NULL, 0 },
+    { "Op 1 KSC-R",                   0,   -1,  0x31, 0x00, 0x09,  0x00, 0x7F,  NULL, 0 },
+    { "Op 1 KSC-Level Left Depth",    0,   -1,  0x31, 0x00, 0x0A,  0x00, 0x7F,  NULL, 0 },
+    { "Op 1 KSC-Level Right Depth",   0,   -1,  0x31, 0x00, 0x0B,  0x00, 0x7F,  NULL, 0 },
+    { "Op 1 KSC-Level Left Curve",    0,   -1,  0x31, 0x00, 0x0C,  0x00, 0x03,  NULL, 0 },
+    { "Op 1 KSC-Level Right Curve",   0,   -1,  0x31, 0x00, 0x0D,  0x00, 0x03,  NULL, 0 },
+    { "Op 1 LFO Amp Depth",           0,   -1,  0x31, 0x00, 0x0E,  0x00, 0x7F,  NULL, 0 },
+    { "Op 1 LFO Pitch Mod On/Off",    1,   -1,  0x31, 0x00, 0x0F,  0x00, 0x01,  NULL, 0 },
+    { "Op 1 Pitch EG On/Off",         1,   -1,  0x31, 0x00, 0x10,  0x00, 0x01,  NULL, 0 },
+    { "Op 1 Level Velocity Sens",     0,   -1,  0x31, 0x00, 0x11,  0x00, 0x7F,  NULL, 0 },
+    { "Op 1 Output Level",            0,   85,  0x31, 0x00, 0x12,  0x00, 0x7F,  NULL, 0 },
+    { "Op 1 Feedback Level",          0,   86,  0x31, 0x00, 0x13,  0x00, 0x7F,  NULL, 0 },
+    { "Op 1 Feedback Type",           0,   87,  0x31, 0x00, 0x14,  0x00, 0x01,  NULL, 0 },
+    { "Op 1 Freq Mode",               0,   88,  0x31, 0x00, 0x15,  0x00, 0x01,  NULL, 0 },
+    { "Op 1 Freq Coarse",             0,   89,  0x31, 0x00, 0x16,  0x00, 0x1F,  NULL, 0 },
+    { "Op 1 Freq Fine",               0,   90,  0x31, 0x00, 0x17,  0x00, 0x63,  NULL, 0 },
+    { "Op 1 Freq Detune",            65,   -1,  0x31, 0x00, 0x18,  0x00, 0x7F,  NULL, 0 },
+    { "Op 2 On/Off",                  1,   -1,  0x31, 0x01, 0x00,  0x00, 0x01,  NULL, 0 },
+    { "Op 2 EG Rate 1",               0,   -1,  0x31, 0x01, 0x01,  0x00, 0x7F,  NULL, 0 },
+    { "Op 2 EG Rate 2",               0,   -1,  0x31, 0x01, 0x02,  0x00, 0x7F,  NULL, 0 },
+    { "Op 2 EG Rate 3",               0,   -1,  0x31, 0x01, 0x03,  0x00, 0x7F,  NULL, 0 },
+    { "Op 2 EG Rate 4",               0,   -1,  0x31, 0x01, 0x04,  0x00, 0x7F,  NULL, 0 },
+    { "Op 2 EG Level 1",              0,   -1,  0x31, 0x01, 0x05,  0x00, 0x7F,  NULL, 0 },
+    { "Op 2 EG Level 2",              0,   -1,  0x31, 0x01, 0x06,  0x00, 0x7F,  NULL, 0 },
+    { "Op 2 EG Level 3",              0,   -1,  0x31, 0x01, 0x07,  0x00, 0x7F,  NULL, 0 },
+    { "Op 2 EG Level 4",              0,   -1,  0x31, 0x01, 0x08,  0x00, 0x7F,  NULL, 0 },
+    { "Op 2 KSC-R",                   0,   -1,  0x31, 0x01, 0x09,  0x00, 0x7F,  NULL, 0 },
+    { "Op 2 KSC-Level Left Depth",    0,   -1,  0x31, 0x01, 0x0A,  0x00, 0x7F,  NULL, 0 },
+    { "Op 2 KSC-Level Right Depth",   0,   -1,  0x31, 0x01, 0x0B,  0x00, 0x7F,  NULL, 0 },
+    { "Op 2 KSC-Level Left Curve",    0,   -1,  0x31, 0x01, 0x0C,  0x00, 0x03,  NULL, 0 },
+    { "Op 2 KSC-Level Right Curve",   0,   -1,  0x31, 0x01, 0x0D,  0x00, 0x03,  NULL, 0 },
+    { "Op 2 LFO Amp Depth",           0,   -1,  0x31, 0x01, 0x0E,  0x00, 0x7F,  NULL, 0 },
+    { "Op 2 LFO Pitch Mod On/Off",    1,   -1,  0x31, 0x01, 0x0F,  0x00, 0x01,  NULL, 0 },
+    { "Op 2 Pitch EG On/Off",         1,   -1,  0x31, 0x01, 0x10,  0x00, 0x01,  NULL, 0 },
+    { "Op 2 Level Velocity Sens",     0,   -1,  0x31, 0x01, 0x11,  0x00, 0x7F,  NULL, 0 },
+    { "Op 2 Output Level",            0,  102,  0x31, 0x01, 0x12,  0x00, 0x7F,  NULL, 0 },
+    { "Op 2 Feedback Level",          0,  103,  0x31, 0x01, 0x13,  0x00, 0x7F,  NULL, 0 },
+    { "Op 2 Feedback Type",           0,  104,  0x31, 0x01, 0x14,  0x00, 0x01,  NULL, 0 },
+    { "Op 2 Freq Mode",               0,  105,  0x31, 0x01, 0x15,  0x00, 0x01,  NULL, 0 },
+    { "Op 2 Freq Coarse",             0,  106,  0x31, 0x01, 0x16,  0x00, 0x1F,  NULL, 0 },
+    { "Op 2 Freq Fine",               0,  107,  0x31, 0x01, 0x17,  0x00, 0x63,  NULL, 0 },
+    { "Op 2 Freq Detune",            65,   -1,  0x31, 0x01, 0x18,  0x00, 0x7F,  NULL, 0 },
+    { "Op 3 On/Off",                  1,   -1,  0x31, 0x02, 0x00,  0x00, 0x01,  NULL, 0 },
+    { "Op 3 EG Rate 1",               0,   -1,  0x31, 0x02, 0x01,  0x00, 0x7F,  NULL, 0 },
+    { "Op 3 EG Rate 2",               0,   -1,  0x31, 0x02, 0x02,  0x00, 0x7F,  NULL, 0 },
+    { "Op 3 EG Rate 3",               0,   -1,  0x31, 0x02, 0x03,  0x00, 0x7F,  NULL, 0 },
+    { "Op 3 EG Rate 4",               0,   -1,  0x31, 0x02, 0x04,  0x00, 0x7F,  NULL, 0 },
+    { "Op 3 EG Level 1",              0,   -1,  0x31, 0x02, 0x05,  0x00, 0x7F,  NULL, 0 },
+    { "Op 3 EG Level 2",              0,   -1,  0x31, 0x02, 0x06,  0x00, 0x7F,  NULL, 0 },
+    { "Op 3 EG Level 3",              0,   -1,  0x31, 0x02, 0x07,  0x00, 0x7F,  NULL, 0 },
+    { "Op 3 EG Level 4",              0,   -1,  0x31, 0x02, 0x08,  0x00, 0x7F,  NULL, 0 },
+    { "Op 3 KSC-R",                   0,   -1,  0x31, 0x02, 0x09,  0x00, 0x7F,  NULL, 0 },
+    { "Op 3 KSC-Level Left Depth",    0,   -1,  0x31, 0x02, 0x0A,  0x00, 0x7F,  NULL, 0 },
+    { "Op 3 KSC-Level Right Depth",   0,   -1,  0x31, 0x02, 0x0B,  0x00, 0x7F,  NULL, 0 },
+    { "Op 3 KSC-Level Left Curve",    0,   -1,  0x31, 0x02, 0x0C,  0x00, 0x03,  NULL, 0 },
+    { "Op 3 KSC-Level Right Curve",   0,   -1,  0x31, 0x02, 0x0D,  0x00, 0x03,  NULL, 0 },
+    { "Op 3 LFO Amp Depth",           0,   -1,  0x31, 0x02, 0x0E,  0x00, 0x7F,  NULL, 0 },
+    { "Op 3 LFO Pitch Mod On/Off",    1,   -1,  0x31, 0x02, 0x0F,  0x00, 0x01,  NULL, 0 },
+    { "Op 3 Pitch EG On/Off",         1,   -1,  0x31, 0x02, 0x10,  0x00, 0x01,  NULL, 0 },
+    { "Op 3 Level Velocity Sens",     0,   -1,  0x31, 0x02, 0x11,  0x00, 0x7F,  NULL, 0 },
+    { "Op 3 Output Level",            0,  108,  0x31, 0x02, 0x12,  0x00, 0x7F,  NULL, 0 },
+    { "Op 3 Feedback Level",          0,  109,  0x31, 0x02, 0x13,  0x00, 0x7F,  NULL, 0 },
+    { "Op 3 Feedback Type",           0,  110,  0x31, 0x02, 0x14,  0x00, 0x01,  NULL, 0 },
+    { "Op 3 Freq Mode",               0,  111,  0x31, 0x02, 0x15,  0x00, 0x01,  NULL, 0 },
+    { "Op 3 Freq Coarse",             0,  112,  0x31, 0x02, 0x16,  0x00, 0x1F,  NULL, 0 },
+    { "Op 3 Freq Fine",               0,  113,  0x31, 0x02, 0x17,  0x00, 0x63,  NULL, 0 },
+    { "Op 3 Freq Detune",            65,   -1,  0x31, 0x02, 0x18,  0x00, 0x7F,  NULL, 0 },
+    { "Op 4 On/Off",                  1,   -1,  0x31, 0x03, 0x00,  0x00, 0x01,  NULL, 0 },
+    { "Op 4 EG Rate 1",               0,   -1,  0x31, 0x03, 0x01,  0x00, 0x7F,  NULL, 0 },
+    { "Op 4 EG Rate 2",               0,   -1,  0x31, 0x03, 0x02,  0x00, 0x7F,  NULL, 0 },
+    { "Op 4 EG Rate 3",               0,   -1,  0x31, 0x03, 0x03,  0x00, 0x7F,  NULL, 0 },
+    { "Op 4 EG Rate 4",               0,   -1,  0x31, 0x03, 0x04,  0x00, 0x7F,  NULL, 0 },
+    { "Op 4 EG Level 1",              0,   -1,  0x31, 0x03, 0x05,  0x00, 0x7F,  NULL, 0 },
+    { "Op 4 EG Level 2",              0,   -1,  0x31, 0x03, 0x06,  0x00, 0x7F,  NULL, 0 },
+    { "Op 4 EG Level 3",              0,   -1,  0x31, 0x03, 0x07,  0x00, 0x7F,  NULL, 0 },
+    { "Op 4 EG Level 4",              0,   -1,  0x31, 0x03, 0x08,  0x00, 0x7F,  NULL, 0 },
+    { "Op 4 KSC-R",                   0,   -1,  0x31, 0x03, 0x09,  0x00, 0x7F,  NULL, 0 },
+    { "Op 4 KSC-Level Left Depth",    0,   -1,  0x31, 0x03, 0x0A,  0x00, 0x7F,  NULL, 0 },
+    { "Op 4 KSC-Level Right Depth",   0,   -1,  0x31, 0x03, 0x0B,  0x00, 0x7F,  NULL, 0 },
+    { "Op 4 KSC-Level Left Curve",    0,   -1,  0x31, 0x03, 0x0C,  0x00, 0x03,  NULL, 0 },
+    { "Op 4 KSC-Level Right Curve",   0,   -1,  0x31, 0x03, 0x0D,  0x00, 0x03,  NULL, 0 },
+    { "Op 4 LFO Amp Depth",           0,   -1,  0x31, 0x03, 0x0E,  0x00, 0x7F,  NULL, 0 },
+    { "Op 4 LFO Pitch Mod On/Off",    1,   -1,  0x31, 0x03, 0x0F,  0x00, 0x01,  NULL, 0 },
+    { "Op 4 Pitch EG On/Off",         1,   -1,  0x31, 0x03, 0x10,  0x00, 0x01,  NULL, 0 },
+    { "Op 4 Level Velocity Sens",     0,   -1,  0x31, 0x03, 0x11,  0x00, 0x7F,  NULL, 0 },
+    { "Op 4 Output Level",            0,  114,  0x31, 0x03, 0x12,  0x00, 0x7F,  NULL, 0 },
+    { "Op 4 Feedback Level",          0,  115,  0x31, 0x03, 0x13,  0x00, 0x7F,  NULL, 0 },
+    { "Op 4 Feedback Type",           0,  116,  0x31, 0x03, 0x14,  0x00, 0x01,  NULL, 0 },
+    { "Op 4 Freq Mode",               0,  117,  0x31, 0x03, 0x15,  0x00, 0x01,  NULL, 0 },
+    { "Op 4 Freq Coarse",             0,  118,  0x31, 0x03, 0x16,  0x00, 0x1F,  NULL, 0 },
+    { "Op 4 Freq Fine",               0,  119,  0x31, 0x03, 0x17,  0x00, 0x63,  NULL, 0 },
+    { "Op 4 Freq Detune",            65,   -1,  0x31, 0x03, 0x18,  0x00, 0x7F,  NULL, 0 },
+};
+
+
+bool YamahaRefaceModel::createSysexParameterChange(int control_id, MidiMessage& message)
+{
+    int sysex_address = control_store_.sysex_address(control_id);
     
-    addMidiControl(String("LFO Assign"),        // name
-                                   0,                               // initial value
-                   
-                                   createContinuousControl(78,      // cc number
-                                                           0,       // range_min
-                                                           127),    // range_max
-                                   
-                                   createSysexControl(0,            // param table
-                                                      0x30,         // address_high
-                                                      0x00,         // address_mid
-                                                      0x02,         // address_low
-                                                      1,            // size (bytes)
-                                                      0x00,         // range_min
-                                                      0x7F));       // range_max
-    
-    addMidiControl(String("LFO Depth"),        // name
-                                   0,                               // initial value
-                                   
-                                   createContinuousControl(77,      // cc number
-                                                           0,       // range_min
-                                                           127),    // range_max
-                                   
-                                   createSysexControl(0,            // param table
-                                                      0x30,         // address_high
-                                                      0x00,         // address_mid
-                                                      0x03,         // address_low
-                                                      1,            // size (bytes)
-                                                      0x00,         // range_min
-                                                      0x7F));       // range_max
-    
-    addMidiControl(String("LFO Speed"),        // name
-                                   0,                               // initial value
-                                   
-                                   createContinuousControl(76,      // cc number
-                                                           0,       // range_min
-                                                           127),    // range_max
-                                   
-                                   createSysexControl(0,            // param table
-                                                      0x30,         // address_high
-                                                      0x00,         // address_mid
-                                                      0x04,         // address_low
-                                                      1,            // size (bytes)
-                                                      0x00,         // range_min
-                                                      0x7F));       // range_max
-    
-    addMidiControl(String("Portamento"),        // name
-                                   0,                               // initial value
-                                   
-                                   createContinuousControl(20,      // cc number
-                                                           0,       // range_min
-                                                           127),    // range_max
-                                   
-                                   createSysexControl(0,            // param table
-                                                      0x30,         // address_high
-                                                      0x00,         // address_mid
-                                                      0x05,         // address_low
-                                                      1,            // size (bytes)
-                                                      0x00,         // range_min
-                                                      0x7F));       // range_max
-    
-    addMidiControl(String("Osc Type"),        // name
-                                   0,                               // initial value
-                                   
-                                   createContinuousControl(80,      // cc number
-                                                           0,       // range_min
-                                                           127),    // range_max
-                                   
-                                   createSysexControl(0,            // param table
-                                                      0x30,         // address_high
-                                                      0x00,         // address_mid
-                                                      0x06,         // address_low
-                                                      1,            // size (bytes)
-                                                      0x00,         // range_min
-                                                      0x7F));       // range_max
-    
-    addMidiControl(String("Osc Texture"),        // name
-                                   0,                               // initial value
-                                   
-                                   createContinuousControl(81,      // cc number
-                                                           0,       // range_min
-                                                           127),    // range_max
-                                   
-                                   createSysexControl(0,            // param table
-                                                      0x30,         // address_high
-                                                      0x00,         // address_mid
-                                                      0x07,         // address_low
-                                                      1,            // size (bytes)
-                                                      0x00,         // range_min
-                                                      0x7F));       // range_max
-    
-    addMidiControl(String("Osc Mod"),        // name
-                                   0,                               // initial value
-                                   
-                                   createContinuousControl(82,      // cc number
-                                                           0,       // range_min
-                                                           127),    // range_max
-                                   
-                                   createSysexControl(0,            // param table
-                                                      0x30,         // address_high
-                                                      0x00,         // address_mid
-                                                      0x08,         // address_low
-                                                      1,            // size (bytes)
-                                                      0x00,         // range_min
-                                                      0x7F));       // range_max
-    
-    addMidiControl(String("Filter Cutoff"),        // name
-                                   0,                               // initial value
-                                   
-                                   createContinuousControl(74,      // cc number
-                                                           0,       // range_min
-                                                           127),    // range_max
-                                   
-                                   createSysexControl(0,            // param table
-                                                      0x30,         // address_high
-                                                      0x00,         // address_mid
-                                                      0x09,         // address_low
-                                                      1,            // size (bytes)
-                                                      0x00,         // range_min
-                                                      0x7F));       // range_max
-    
-    addMidiControl(String("Filter Resonance"),        // name
-                                   0,                               // initial value
-                                   
-                                   createContinuousControl(71,      // cc number
-                                                           0,       // range_min
-                                                           127),    // range_max
-                                   
-                                   createSysexControl(0,            // param table
-                                                      0x30,         // address_high
-                                                      0x00,         // address_mid
-                                                      0x0A,         // address_low
-                                                      1,            // size (bytes)
-                                                      0x00,         // range_min
-                                                      0x7F));       // range_max
-    
-    addMidiControl(String("EG Balance"),        // name
-                                   0,                               // initial value
-                                   
-                                   createContinuousControl(83,      // cc number
-                                                           0,       // range_min
-                                                           127),    // range_max
-                                   
-                                   createSysexControl(0,            // param table
-                                                      0x30,         // address_high
-                                                      0x00,         // address_mid
-                                                      0x0B,         // address_low
-                                                      1,            // size (bytes)
-                                                      0x00,         // range_min
-                                                      0x7F));       // range_max
-    
-    addMidiControl(String("EG Attack"),        // name
-                                   0,                               // initial value
-                                   
-                                   createContinuousControl(73,      // cc number
-                                                           0,       // range_min
-                                                           127),    // range_max
-                                   
-                                   createSysexControl(0,            // param table
-                                                      0x30,         // address_high
-                                                      0x00,         // address_mid
-                                                      0x0C,         // address_low
-                                                      1,            // size (bytes)
-                                                      0x00,         // range_min
-                                                      0x7F));       // range_max
-    
-    addMidiControl(String("EG Decay"),        // name
-                                   0,                               // initial value
-                                   
-                                   createContinuousControl(75,      // cc number
-                                                           0,       // range_min
-                                                           127),    // range_max
-                                   
-                                   createSysexControl(0,            // param table
-                                                      0x30,         // address_high
-                                                      0x00,         // address_mid
-                                                      0x0D,         // address_low
-                                                      1,            // size (bytes)
-                                                      0x00,         // range_min
-                                                      0x7F));       // range_max
+    if (sysex_address < 0)
+    {
+        return false;
+    }
     
-    addMidiControl(String("EG Sustain"),        // name
-                                   0,                               // initial value
-                                   
-                                   createContinuousControl(79,      // cc number
-                                                           0,       // range_min
-                                                           127),    // range_max
-                                   
-                                   createSysexControl(0,            // param table
-                                                      0x30,         // address_high
-                                                      0x00,         // address_mid
-                                                      0x0E,         // address_low
-                                                      1,            // size (bytes)
-                                                      0x00,         // range_min
-                                                      0x7F));       // range_max
+    const int size_bytes = jlimit(1, MIDI_MAX_SYSEX_PARAM_BYTES, (int)control_store_.sysex_size_bytes(control_id));
+    int sysex_value = controlValueToSysexValue(control_id, control_store_.value(control_id));
     
-    addMidiControl(String("EG Release"),        // name
-                                   0,                               // initial value
-                                   
-                                   createContinuousControl(72,      // cc number
-                                                           0,       // range_min
-                                                           127),    // range_max
-                                   
-                                   createSysexControl(0,            // param table
-                                                      0x30,         // address_high
-                                                      0x00,         // address_mid
-                                                      0x0F,         // address_low
-                                                      1,            // size (bytes)
-                                                      0x00,         // range_min
-                                                      0x7F));       // range_max
+    uint8 message_data[15];
+    int num_bytes = 0;
     
-    addMidiControl(String("Effect Type"),        // name
-                                   0,                               // initial value
-                                   
-                                   createContinuousControl(17,      // cc number
-                                                           0,       // range_min
-                                                           127),    // range_max
-                                   
-                                   createSysexControl(0,            // param table
-                                                      0x30,         // address_high
-                                                      0x00,         // address_mid
-                                                      0x10,         // address_low
-                                                      1,            // size (bytes)
-                                                      0x00,         // range_min
-                                                      0x7F));       // range_max
+    message_data[num_bytes++] = 0xF0;
+    message_data[num_bytes++] = sysex_manufacturer_id_;
+    message_data[num_bytes++] = 0x10 | (sysex_device_id_ & 0x0F);
+    message_data[num_bytes++] = sysex_group_number_high_;
+    message_data[num_bytes++] = sysex_group_number_low_;
+    message_data[num_bytes++] = sysex_model_id_[0];
+    message_data[num_bytes++] = (sysex_address >> 16) & 0x7F;
+    message_data[num_bytes++] = (sysex_address >> 8) & 0x7F;
+    message_data[num_bytes++] = sysex_address & 0x7F;
     
-    addMidiControl(String("Effect Depth"),        // name
-                                   0,                               // initial value
-                                   
-                                   createContinuousControl(18,      // cc number
-                                                           0,       // range_min
-                                                           127),    // range_max
-                                   
-                                   createSysexControl(0,            // param table
-                                                      0x30,         // address_high
-                                                      0x00,         // address_mid
-                                                      0x11,         // address_low
-                                                      1,            // size (bytes)
-                                                      0x00,         // range_min
-                                                      0x7F));       // range_max
+    for (int i=size_bytes-1; i>=0; i--)
+    {
+        message_data[num_bytes++] = (sysex_value >> (7 * i)) & 0x7F;
+    }
     
-    addMidiControl(String("Effect Rate"),        // name
-                                   0,                               // initial value
-                                   
-                                   createContinuousControl(19,      // cc number
-                                                           0,       // range_min
-                                                           127),    // range_max
-                                   
-                                   createSysexControl(0,            // param table
-                                                      0x30,         // address_high
-                                                      0x00,         // address_mid
-                                                      0x12,         // address_low
-                                                      1,            // size (bytes)
-                                                      0x00,         // range_min
-                                                      0x7F));       // range_max
+    message_data[num_bytes++] = 0xF7;
     
-
+    message = MidiMessage(message_data, num_bytes);
     
+    return true;
 }
 
-bool YamahaRefaceCSModel::handleMidiSysexEvent(const MidiMessage& message)
+bool YamahaRefaceModel::createSysexPatchDump(MidiBuffer& patch_dump)
 {
-    printf("MidiInstrumentModel::handleMidiSysexEvent with sysex data size: %d and data size: %d\n", message.getSysExDataSize(), message.getRawDataSize());
-    
-    int data_size = message.getSysExDataSize();
-    const uint8* sysex_data = message.getSysExData();
-    
-    for (int i=0; i<data_size; i++)
-    {
-        printf("sysex_data[%d]: %02x\n", i, sysex_data[i]);
-    }
-    
-    if (sysex_data[0] != sysex_manufacturer_id_ ||
-        sysex_data[1] != sysex_device_id_ ||
-        sysex_data[2] != sysex_group_number_high_ ||
-        sysex_data[3] != sysex_group_number_low_ ||
-        sysex_data[6] != sysex_model_id_[0])
+    if (sysex_blocks_.size() == 0)
     {
         return false;
     }
     
-    uint8 byte_count_high = sysex_data[4];
-    uint8 byte_count_low = sysex_data[5];
-    
-    uint16 byte_count = byte_count_high;
-    byte_count = (byte_count << 2) + byte_count_low;
+    const ScopedLock sl(sysex_block_lock_);
     
-    printf("handleMidiSysexEvent returning true with byte_count: %d\n", byte_count);
+    for (int i=0; i<sysex_blocks_.size(); i++)
+    {
+        // a dump also rewrites the bytes no control covers (voice name,
+        // reserved), so wait until the instrument has sent us every block;
+        // a block too long for one message can't go out at all
+        if (!sysex_blocks_received_[i] ||
+            sysex_blocks_.getReference(i).size_bytes > REFACE_MAX_BULK_DUMP_DATA_BYTES)
+        {
+            return false;
+        }
+    }
     
-    uint8 address_high = sysex_data[7];
-    uint8 address_mid = sysex_data[8];
-    uint8 address_low = sysex_data[9];
+    int sample_number = 0;
     
-    printf("evaluating sysex dump at address %02x : %02x : %02x\n", address_high, address_mid, address_low);
+    patch_dump.addEvent(createBulkDumpMessage(0x0E, 0x0F, 0x00, NULL, 0), sample_number++);
     
-    if (address_high == 0x30 &&
-        address_mid == 0x00 &&
-        address_low == 0x00 &&
-        byte_count == 26)
+    for (int i=0; i<sysex_blocks_.size(); i++)
     {
-        printf("handle patch dump\n");
+        const MidiSysexBlockEntry& block = sysex_blocks_.getReference(i);
         
-        int param_index = 0;
-        int param_byte = 10;
+        writeControlValuesToSysexBlock(i);
         
-        for (int i=0; i<NUM_REFACE_CS_PARAMS+1; i++)
-        {
-            if (i == 1)
-            {
-                param_byte++;
-                continue;
-            }
-            
-            int value_to_set = sysex_data[param_byte++];
-            
-            if (i == REFACE_CS_LFO_ASSIGN ||
-                i == REFACE_CS_OSC_TYPE ||
-                i == REFACE_CS_EFFECT_TYPE)
-            {
-                switch (value_to_set)
-                {
-                    case 0:
-                        break;
-                    case 1:
-                        value_to_set = 32;
-                        break;
-                    case 2:
-                        value_to_set = 64;
-                        break;
-                    case 3:
-                        value_to_set = 95;
-                        break;
-                    case 4:
-                        value_to_set = 127;
-                        break;
-                };
-            }
-            
-            midi_controls_[param_index++]->set_value(value_to_set, true);
-        }
+        patch_dump.addEvent(createBulkDumpMessage(block.address_high,
+                                                  block.address_mid,
+                                                  block.address_low,
+                                                  sysex_block_data_.getRawDataPointer() + sysex_block_offsets_[i],
+                                                  block.size_bytes),
+                            sample_number++);
     }
     
+    patch_dump.addEvent(createBulkDumpMessage(0x0F, 0x0F, 0x00, NULL, 0), sample_number++);
+    
     return true;
 }
 
-
-
-YamahaRefaceDXModel::YamahaRefaceDXModel()
-: MidiInstrumentModel("Yamaha", "Reface DX")
+MidiMessage YamahaRefaceModel::createBulkDumpMessage(uint8 address_high,
+                                                     uint8 address_mid,
+                                                     uint8 address_low,
+                                                     const uint8* data,
+                                                     int num_bytes)
 {
-    sysex_manufacturer_id_ = 0x43;
-    sysex_device_id_ = 0x00;
-    sysex_model_id_bytes_ = 1;
-    sysex_model_id_[0] = 0x05;
-    sysex_group_number_high_ = 0x7f;
-    sysex_group_number_low_ = 0x1c;
+    jassert(num_bytes <= REFACE_MAX_BULK_DUMP_DATA_BYTES);
+    num_bytes = jmin(num_bytes, REFACE_MAX_BULK_DUMP_DATA_BYTES);
     
-    addMidiControl(String("Transpose"),        // name
-                   25,                               // initial value
-                   NULL,                            // no cc control
-                   createSysexControl(0,            // param table
-                                      0x30,         // address_high
-                                      0x00,         // address_mid
-                                      0x0C,         // address_low
-                                      1,            // size (bytes)
-                                      0x28,         // range_min
-                                      0x58));       // range_max
+    uint8 message_data[REFACE_BULK_DUMP_OVERHEAD_BYTES + REFACE_MAX_BULK_DUMP_DATA_BYTES];
+    int message_size = 0;
     
-    addMidiControl(String("Part Mode"),        // name
-                   0,                               // initial value
-                   NULL,                            // no cc control
-                   createSysexControl(0,            // param table
-                                      0x30,         // address_high
-                                      0x00,         // address_mid
-                                      0x0D,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x02));       // range_max
+    // the byte count covers model id, address and data
+    const int byte_count = num_bytes + 4;
     
-    addMidiControl(String("Portamento"),        // name
-                   0,                               // initial value
-                   NULL,                            // no cc control
-                   createSysexControl(0,            // param table
-                                      0x30,         // address_high
-                                      0x00,         // address_mid
-                                      0x0E,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Pitch Bend Range"),        // name
-                   12,                               // initial value
-                   NULL,                            // no cc control
-                   createSysexControl(0,            // param table
-                                      0x30,         // address_high
-                                      0x00,         // address_mid
-                                      0x0F,         // address_low
-                                      1,            // size (bytes)
-                                      0x28,         // range_min
-                                      0x58));       // range_max
-
-    addMidiControl(String("Algorithm"),        // name
-                   0,                               // initial value
-                   
-                   createContinuousControl(80,      // cc number
-                                           0,       // range_min
-                                           127),    // range_max
-                   
-                   createSysexControl(0,            // param table
-                                      0x30,         // address_high
-                                      0x00,         // address_mid
-                                      0x10,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x0B));       // range_max
-    
-    addMidiControl(String("LFO Wave"),        // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x30,         // address_high
-                                      0x00,         // address_mid
-                                      0x11,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x06));       // range_max
-
-    addMidiControl(String("LFO Speed"),        // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x30,         // address_high
-                                      0x00,         // address_mid
-                                      0x12,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-
-    addMidiControl(String("LFO Delay"),        // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x30,         // address_high
-                                      0x00,         // address_mid
-                                      0x13,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-
-    addMidiControl(String("LFO Pitch Mod"),        // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x30,         // address_high
-                                      0x00,         // address_mid
-                                      0x14,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-
-    addMidiControl(String("Pitch EG Rate 1"),        // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x30,         // address_high
-                                      0x00,         // address_mid
-                                      0x15,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
+    message_data[message_size++] = 0xF0;
+    message_data[message_size++] = sysex_manufacturer_id_;
+    message_data[message_size++] = sysex_device_id_ & 0x0F;
+    message_data[message_size++] = sysex_group_number_high_;
+    message_data[message_size++] = sysex_group_number_low_;
+    message_data[message_size++] = (byte_count >> 7) & 0x7F;
+    message_data[message_size++] = byte_count & 0x7F;
     
-    addMidiControl(String("Pitch EG Rate 2"),        // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x30,         // address_high
-                                      0x00,         // address_mid
-                                      0x16,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
+    const int checksum_start = message_size;
     
-    addMidiControl(String("Pitch EG Rate 3"),        // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x30,         // address_high
-                                      0x00,         // address_mid
-                                      0x17,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
+    message_data[message_size++] = sysex_model_id_[0];
+    message_data[message_size++] = address_high;
+    message_data[message_size++] = address_mid;
+    message_data[message_size++] = address_low;
     
-    addMidiControl(String("Pitch EG Rate 4"),        // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x30,         // address_high
-                                      0x00,         // address_mid
-                                      0x18,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
+    for (int i=0; i<num_bytes; i++)
+    {
+        message_data[message_size++] = data[i] & 0x7F;
+    }
     
-    addMidiControl(String("Pitch EG Level 1"),        // name
-                   49,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x30,         // address_high
-                                      0x00,         // address_mid
-                                      0x19,         // address_low
-                                      1,            // size (bytes)
-                                      0x10,         // range_min
-                                      0x70));       // range_max
+    // model id, address, data and checksum sum to 0 in the low 7 bits
+    int sum = 0;
     
-    addMidiControl(String("Pitch EG Level 2"),        // name
-                   49,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x30,         // address_high
-                                      0x00,         // address_mid
-                                      0x1A,         // address_low
-                                      1,            // size (bytes)
-                                      0x10,         // range_min
-                                      0x70));       // range_max
+    for (int i=checksum_start; i<message_size; i++)
+    {
+        sum += message_data[i];
+    }
     
-    addMidiControl(String("Pitch EG Level 3"),        // name
-                   49,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x30,         // address_high
-                                      0x00,         // address_mid
-                                      0x1B,         // address_low
-                                      1,            // size (bytes)
-                                      0x10,         // range_min
-                                      0x70));       // range_max
+    message_data[message_size++] = (128 - (sum & 0x7F)) & 0x7F;
+    message_data[message_size++] = 0xF7;
     
-    addMidiControl(String("Pitch EG Level 4"),        // name
-                   49,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x30,         // address_high
-                                      0x00,         // address_mid
-                                      0x1C,         // address_low
-                                      1,            // size (bytes)
-                                      0x10,         // range_min
-                                      0x70));       // range_max
+    return MidiMessage(message_data, message_size);
+}
 
-    addMidiControl(String("Effect 1 Type"),        // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x30,         // address_high
-                                      0x00,         // address_mid
-                                      0x1D,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x07));       // range_max
+bool YamahaRefaceModel::createSysexPatchDumpRequest(MidiMessage& message)
+{
+    // dump request for the header block, answered with the whole patch
+    const uint8 message_data[] = { 0xF0,
+                                   sysex_manufacturer_id_,
+                                   (uint8)(0x20 | (sysex_device_id_ & 0x0F)),
+                                   sysex_group_number_high_,
+                                   sysex_group_number_low_,
+                                   sysex_model_id_[0],
+                                   0x0E, 0x0F, 0x00,
+                                   0xF7 };
+    
+    message = MidiMessage(message_data, (int)sizeof(message_data));
     
-    addMidiControl(String("Effect 1 Parameter 1"),        // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x30,         // address_high
-                                      0x00,         // address_mid
-                                      0x1E,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
+    return true;
+}
 
-    addMidiControl(String("Effect 1 Parameter 2"),        // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x30,         // address_high
-                                      0x00,         // address_mid
-                                      0x1F,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    
-    addMidiControl(String("Effect 2 Type"),        // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x30,         // address_high
-                                      0x00,         // address_mid
-                                      0x20,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x07));       // range_max
-    
-    addMidiControl(String("Effect 2 Parameter 1"),        // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x30,         // address_high
-                                      0x00,         // address_mid
-                                      0x21,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Effect 2 Parameter 2"),        // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x30,         // address_high
-                                      0x00,         // address_mid
-                                      0x22,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 1 On/Off"),     // name
-                   1,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x00,         // address_mid
-                                      0x00,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x01));       // range_max
-    
-    addMidiControl(String("Op 1 EG Rate 1"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x00,         // address_mid
-                                      0x01,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 1 EG Rate 2"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x00,         // address_mid
-                                      0x02,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
+bool YamahaRefaceModel::handleMidiSysexEvent(const MidiMessage& message)
+{
+    // 43 0n 7F 1C bh bl model ah am al data... cs, without F0/F7
+    const int data_size = message.getSysExDataSize();
+    const uint8* sysex_data = message.getSysExData();
     
-    addMidiControl(String("Op 1 EG Rate 3"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x00,         // address_mid
-                                      0x03,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
+    if (data_size < 11 ||
+        sysex_data[0] != sysex_manufacturer_id_ ||
+        sysex_data[1] != (sysex_device_id_ & 0x0F) ||
+        sysex_data[2] != sysex_group_number_high_ ||
+        sysex_data[3] != sysex_group_number_low_ ||
+        sysex_data[6] != sysex_model_id_[0])
+    {
+        return false;
+    }
     
-    addMidiControl(String("Op 1 EG Rate 4"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x00,         // address_mid
-                                      0x04,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
+    // the byte count covers model id, address and data
+    const int byte_count = (sysex_data[4] << 7) | sysex_data[5];
+    const int num_data_bytes = byte_count - 4;
     
-    addMidiControl(String("Op 1 EG Level 1"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x00,         // address_mid
-                                      0x05,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
+    if (num_data_bytes <= 0 || 10 + num_data_bytes + 1 > data_size)
+    {
+        // header and footer blocks carry no data
+        return false;
+    }
     
-    addMidiControl(String("Op 1 EG Level 2"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x00,         // address_mid
-                                      0x06,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
+    int sum = 0;
     
-    addMidiControl(String("Op 1 EG Level 3"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x00,         // address_mid
-                                      0x07,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
+    for (int i=6; i<=10+num_data_bytes; i++)
+    {
+        sum += sysex_data[i];
+    }
     
-    addMidiControl(String("Op 1 EG Level 4"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x00,         // address_mid
-                                      0x08,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
+    if ((sum & 0x7F) != 0)
+    {
+        return false;
+    }
     
-    addMidiControl(String("Op 1 KSC-R"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x00,         // address_mid
-                                      0x09,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
+    const uint8 address_high = sysex_data[7];
+    const uint8 address_mid = sysex_data[8];
+    const uint8 address_low = sysex_data[9];
     
-    addMidiControl(String("Op 1 KSC-Level Left Depth"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x00,         // address_mid
-                                      0x0A,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
+    const int block_index = findSysexBlock(address_high, address_mid, address_low);
     
-    addMidiControl(String("Op 1 KSC-Level Right Depth"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x00,         // address_mid
-                                      0x0B,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
+    if (block_index < 0)
+    {
+        return false;
+    }
     
-    addMidiControl(String("Op 1 KSC-Level Left Curve"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x00,         // address_mid
-                                      0x0C,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x03));       // range_max
+    const MidiSysexBlockEntry& block = sysex_blocks_.getReference(block_index);
+    const int block_offset = address_low - block.address_low;
+    const int num_bytes = jmin(num_data_bytes, (int)block.size_bytes - block_offset);
+    const int start = sysex_block_offsets_[block_index] + block_offset;
     
-    addMidiControl(String("Op 1 KSC-Level Right Curve"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x00,         // address_mid
-                                      0x0D,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x03));       // range_max
+    const ScopedLock sl(sysex_block_lock_);
     
-    addMidiControl(String("Op 1 LFO Amp Depth"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x00,         // address_mid
-                                      0x0E,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-
-    addMidiControl(String("Op 1 LFO Pitch Mod On/Off"),     // name
-                   1,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x00,         // address_mid
-                                      0x0F,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x01));       // range_max
+    if (block_offset == 0 && num_bytes == block.size_bytes)
+    {
+        sysex_blocks_received_.set(block_index, true);
+    }
     
-    addMidiControl(String("Op 1 Pitch EG On/Off"),     // name
-                   1,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x00,         // address_mid
-                                      0x10,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x01));       // range_max
+    memcpy(sysex_block_data_.getRawDataPointer() + start, sysex_data + 10, (size_t)num_bytes);
     
-
-    addMidiControl(String("Op 1 Level Velocity Sens"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x00,         // address_mid
-                                      0x11,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
+    const uint8* block_data = sysex_block_data_.getRawDataPointer();
+    const int* block_control_ids = sysex_block_control_ids_.getRawDataPointer();
+    bool controls_updated = false;
     
-    addMidiControl(String("Op 1 Output Level"),     // name
-                   0,                               // initial value
-                   
-                   createContinuousControl(85,      // cc number
-                                           0,       // range_min
-                                           127),    // range_max
-                   
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x00,         // address_mid
-                                      0x12,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
+    for (int i=start; i<start+num_bytes; i++)
+    {
+        const int control_id = block_control_ids[i];
+        
+        if (control_id < 0)
+        {
+            continue;
+        }
+        
+        const int size_bytes = jmin((int)control_store_.sysex_size_bytes(control_id), start + num_bytes - i);
+        int sysex_value = 0;
+        
+        for (int j=0; j<size_bytes; j++)
+        {
+            sysex_value = (sysex_value << 7) | (block_data[i+j] & 0x7F);
+        }
+        
+        const int control_value = sysexValueToControlValue(control_id, sysex_value);
+        control_store_.set_value(control_id, control_value);
+        control_store_.set_hardware_value(control_id, control_value);
+        controls_updated = true;
+    }
     
-    addMidiControl(String("Op 1 Feedback Level"),     // name
-                   0,                               // initial value
-                   
-                   createContinuousControl(86,      // cc number
-                                           0,       // range_min
-                                           127),    // range_max
+    return controls_updated;
+}
 
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x00,         // address_mid
-                                      0x13,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 1 Feedback Type"),     // name
-                   0,                               // initial value
-                   
-                   createContinuousControl(87,      // cc number
-                                           0,       // range_min
-                                           127),    // range_max
-                   
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x00,         // address_mid
-                                      0x14,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x01));       // range_max
-    
-    addMidiControl(String("Op 1 Freq Mode"),     // name
-                   0,                               // initial value
-                   
-                   createContinuousControl(88,      // cc number
-                                           0,       // range_min
-                                           127),    // range_max
-                   
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x00,         // address_mid
-                                      0x15,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x01));       // range_max
 
-    addMidiControl(String("Op 1 Freq Coarse"),     // name
-                   0,                               // initial value
-                   
-                   createContinuousControl(89,      // cc number
-                                           0,       // range_min
-                                           127),    // range_max
-                   
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x00,         // address_mid
-                                      0x16,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x1F));       // range_max
-    
-    addMidiControl(String("Op 1 Freq Fine"),     // name
-                   0,                               // initial value
-                   
-                   createContinuousControl(90,      // cc number
-                                           0,       // range_min
-                                           127),    // range_max
-                   
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x00,         // address_mid
-                                      0x17,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x63));       // range_max
-    
-    addMidiControl(String("Op 1 Freq Detune"),     // name
-                   65,                              // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x00,         // address_mid
-                                      0x18,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
+YamahaRefaceCSModel::YamahaRefaceCSModel()
+: YamahaRefaceModel(MidiInstrumentDefinition::createFromTable("Yamaha",
+                                                                "Reface CS",
+                                                                0x43,   // manufacturer id
+                                                                0x00,   // device id
+                                                                0x7f,   // group number high
+                                                                0x1c,   // group number low
+                                                                0x03,   // model id
+                                                                REFACE_CS_CONTROLS,
+                                                                numElementsInArray(REFACE_CS_CONTROLS),
+                                                                REFACE_CS_BLOCKS,
+                                                                numElementsInArray(REFACE_CS_BLOCKS)))
+{
+}
 
+YamahaRefaceDXModel::YamahaRefaceDXModel()
+: YamahaRefaceModel(MidiInstrumentDefinition::createFromTable("Yamaha",
+                                                                "Reface DX",
+                                                                0x43,   // manufacturer id
+                                                                0x00,   // device id
+                                                                0x7f,   // group number high
+                                                                0x1c,   // group number low
+                                                                0x05,   // model id
+                                                                REFACE_DX_CONTROLS,
+                                                                numElementsInArray(REFACE_DX_CONTROLS),
+                                                                REFACE_DX_BLOCKS,
+                                                                numElementsInArray(REFACE_DX_BLOCKS)))
+{
+}
 
 
-    
-    
-    
-    
-    
-    
-    addMidiControl(String("Op 2 On/Off"),     // name
-                   1,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x01,         // address_mid
-                                      0x00,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x01));       // range_max
-    
-    addMidiControl(String("Op 2 EG Rate 1"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x01,         // address_mid
-                                      0x01,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 2 EG Rate 2"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x01,         // address_mid
-                                      0x02,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 2 EG Rate 3"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x01,         // address_mid
-                                      0x03,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 2 EG Rate 4"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x01,         // address_mid
-                                      0x04,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 2 EG Level 1"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x01,         // address_mid
-                                      0x05,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 2 EG Level 2"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x01,         // address_mid
-                                      0x06,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 2 EG Level 3"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x01,         // address_mid
-                                      0x07,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 2 EG Level 4"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x01,         // address_mid
-                                      0x08,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 2 KSC-R"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x01,         // address_mid
-                                      0x09,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 2 KSC-Level Left Depth"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x01,         // address_mid
-                                      0x0A,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 2 KSC-Level Right Depth"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x01,         // address_mid
-                                      0x0B,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 2 KSC-Level Left Curve"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x01,         // address_mid
-                                      0x0C,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x03));       // range_max
-    
-    addMidiControl(String("Op 2 KSC-Level Right Curve"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x01,         // address_mid
-                                      0x0D,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x03));       // range_max
-    
-    addMidiControl(String("Op 2 LFO Amp Depth"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x01,         // address_mid
-                                      0x0E,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 2 LFO Pitch Mod On/Off"),     // name
-                   1,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x01,         // address_mid
-                                      0x0F,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x01));       // range_max
-    
-    addMidiControl(String("Op 2 Pitch EG On/Off"),     // name
-                   1,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x01,         // address_mid
-                                      0x10,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x01));       // range_max
-    
-    
-    addMidiControl(String("Op 2 Level Velocity Sens"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x01,         // address_mid
-                                      0x11,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 2 Output Level"),     // name
-                   0,                               // initial value
-                   
-                   createContinuousControl(102,      // cc number
-                                           0,       // range_min
-                                           127),    // range_max
-                   
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x01,         // address_mid
-                                      0x12,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 2 Feedback Level"),     // name
-                   0,                               // initial value
-                   
-                   createContinuousControl(103,      // cc number
-                                           0,       // range_min
-                                           127),    // range_max
-                   
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x01,         // address_mid
-                                      0x13,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 2 Feedback Type"),     // name
-                   0,                               // initial value
-                   
-                   createContinuousControl(104,      // cc number
-                                           0,       // range_min
-                                           127),    // range_max
-                   
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x01,         // address_mid
-                                      0x14,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x01));       // range_max
-    
-    addMidiControl(String("Op 2 Freq Mode"),     // name
-                   0,                               // initial value
-                   
-                   createContinuousControl(105,      // cc number
-                                           0,       // range_min
-                                           127),    // range_max
-                   
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x01,         // address_mid
-                                      0x15,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x01));       // range_max
-    
-    addMidiControl(String("Op 2 Freq Coarse"),     // name
-                   0,                               // initial value
-                   
-                   createContinuousControl(106,      // cc number
-                                           0,       // range_min
-                                           127),    // range_max
-                   
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x01,         // address_mid
-                                      0x16,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x1F));       // range_max
-    
-    addMidiControl(String("Op 2 Freq Fine"),     // name
-                   0,                               // initial value
-                   
-                   createContinuousControl(107,      // cc number
-                                           0,       // range_min
-                                           127),    // range_max
-                   
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x01,         // address_mid
-                                      0x17,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x63));       // range_max
-    
-    addMidiControl(String("Op 2 Freq Detune"),     // name
-                   65,                              // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x01,         // address_mid
-                                      0x18,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    
 
-    
-    
-    
-    
-    
-    
-    
-    
-    
-    addMidiControl(String("Op 3 On/Off"),     // name
-                   1,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x02,         // address_mid
-                                      0x00,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x01));       // range_max
-    
-    addMidiControl(String("Op 3 EG Rate 1"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x02,         // address_mid
-                                      0x01,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 3 EG Rate 2"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x02,         // address_mid
-                                      0x02,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 3 EG Rate 3"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x02,         // address_mid
-                                      0x03,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 3 EG Rate 4"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x02,         // address_mid
-                                      0x04,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 3 EG Level 1"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x02,         // address_mid
-                                      0x05,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 3 EG Level 2"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x02,         // address_mid
-                                      0x06,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 3 EG Level 3"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x02,         // address_mid
-                                      0x07,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 3 EG Level 4"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x02,         // address_mid
-                                      0x08,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 3 KSC-R"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x02,         // address_mid
-                                      0x09,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 3 KSC-Level Left Depth"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x02,         // address_mid
-                                      0x0A,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 3 KSC-Level Right Depth"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x02,         // address_mid
-                                      0x0B,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 3 KSC-Level Left Curve"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x02,         // address_mid
-                                      0x0C,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x03));       // range_max
-    
-    addMidiControl(String("Op 3 KSC-Level Right Curve"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x02,         // address_mid
-                                      0x0D,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x03));       // range_max
-    
-    addMidiControl(String("Op 3 LFO Amp Depth"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x02,         // address_mid
-                                      0x0E,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 3 LFO Pitch Mod On/Off"),     // name
-                   1,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x02,         // address_mid
-                                      0x0F,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x01));       // range_max
-    
-    addMidiControl(String("Op 3 Pitch EG On/Off"),     // name
-                   1,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x02,         // address_mid
-                                      0x10,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x01));       // range_max
-    
-    
-    addMidiControl(String("Op 3 Level Velocity Sens"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x02,         // address_mid
-                                      0x11,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 3 Output Level"),     // name
-                   0,                               // initial value
-                   
-                   createContinuousControl(108,      // cc number
-                                           0,       // range_min
-                                           127),    // range_max
-                   
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x02,         // address_mid
-                                      0x12,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 3 Feedback Level"),     // name
-                   0,                               // initial value
-                   
-                   createContinuousControl(109,      // cc number
-                                           0,       // range_min
-                                           127),    // range_max
-                   
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x02,         // address_mid
-                                      0x13,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 3 Feedback Type"),     // name
-                   0,                               // initial value
-                   
-                   createContinuousControl(110,      // cc number
-                                           0,       // range_min
-                                           127),    // range_max
-                   
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x02,         // address_mid
-                                      0x14,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x01));       // range_max
-    
-    addMidiControl(String("Op 3 Freq Mode"),     // name
-                   0,                               // initial value
-                   
-                   createContinuousControl(111,      // cc number
-                                           0,       // range_min
-                                           127),    // range_max
-                   
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x02,         // address_mid
-                                      0x15,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x01));       // range_max
-    
-    addMidiControl(String("Op 3 Freq Coarse"),     // name
-                   0,                               // initial value
-                   
-                   createContinuousControl(112,      // cc number
-                                           0,       // range_min
-                                           127),    // range_max
-                   
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x02,         // address_mid
-                                      0x16,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x1F));       // range_max
-    
-    addMidiControl(String("Op 3 Freq Fine"),     // name
-                   0,                               // initial value
-                   
-                   createContinuousControl(113,      // cc number
-                                           0,       // range_min
-                                           127),    // range_max
-                   
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x02,         // address_mid
-                                      0x17,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x63));       // range_max
-    
-    addMidiControl(String("Op 3 Freq Detune"),     // name
-                   65,                              // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x02,         // address_mid
-                                      0x18,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    
-    
 
+MidiInstrumentModel* createMidiInstrumentModel(const String manufacturer,
+                                               const String model_name)
+{
+    if (manufacturer == "Yamaha" && model_name == "Reface CS")
+    {
+        return new YamahaRefaceCSModel();
+    }
     
+    if (manufacturer == "Yamaha" && model_name == "Reface DX")
+    {
+        return new YamahaRefaceDXModel();
+    }
     
+    Array<File> definition_files;
+    MidiotFileUtils::getInstrumentDefinitionFolder().findChildFiles(definition_files,
+                                                                    File::findFiles,
+                                                                    false,
+                                                                    "*" + MidiotFileUtils::getInstrumentDefinitionFileExtension());
     
+    for (int i=0; i<definition_files.size(); i++)
+    {
+        MidiInstrumentDefinition* definition = MidiInstrumentDefinition::createFromFile(definition_files[i]);
+        
+        if (definition)
+        {
+            if (definition->manufacturer_ == manufacturer &&
+                definition->model_name_ == model_name)
+            {
+                return new MidiInstrumentModel(definition);
+            }
+            
+            delete definition;
+        }
+    }
     
-    
-    addMidiControl(String("Op 4 On/Off"),     // name
-                   1,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x03,         // address_mid
-                                      0x00,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x01));       // range_max
-    
-    addMidiControl(String("Op 4 EG Rate 1"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x03,         // address_mid
-                                      0x01,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 4 EG Rate 2"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x03,         // address_mid
-                                      0x02,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 4 EG Rate 3"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x03,         // address_mid
-                                      0x03,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 4 EG Rate 4"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x03,         // address_mid
-                                      0x04,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 4 EG Level 1"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x03,         // address_mid
-                                      0x05,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 4 EG Level 2"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x03,         // address_mid
-                                      0x06,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 4 EG Level 3"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x03,         // address_mid
-                                      0x07,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 4 EG Level 4"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x03,         // address_mid
-                                      0x08,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 4 KSC-R"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x03,         // address_mid
-                                      0x09,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 4 KSC-Level Left Depth"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x03,         // address_mid
-                                      0x0A,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 4 KSC-Level Right Depth"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x03,         // address_mid
-                                      0x0B,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 4 KSC-Level Left Curve"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x03,         // address_mid
-                                      0x0C,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x03));       // range_max
-    
-    addMidiControl(String("Op 4 KSC-Level Right Curve"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x03,         // address_mid
-                                      0x0D,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x03));       // range_max
-    
-    addMidiControl(String("Op 4 LFO Amp Depth"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x03,         // address_mid
-                                      0x0E,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 4 LFO Pitch Mod On/Off"),     // name
-                   1,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x03,         // address_mid
-                                      0x0F,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x01));       // range_max
-    
-    addMidiControl(String("Op 4 Pitch EG On/Off"),     // name
-                   1,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x03,         // address_mid
-                                      0x10,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x01));       // range_max
-    
-    
-    addMidiControl(String("Op 4 Level Velocity Sens"),     // name
-                   0,                               // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x03,         // address_mid
-                                      0x11,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 4 Output Level"),     // name
-                   0,                               // initial value
-                   
-                   createContinuousControl(114,      // cc number
-                                           0,       // range_min
-                                           127),    // range_max
-                   
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x03,         // address_mid
-                                      0x12,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 4 Feedback Level"),     // name
-                   0,                               // initial value
-                   
-                   createContinuousControl(115,      // cc number
-                                           0,       // range_min
-                                           127),    // range_max
-                   
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x03,         // address_mid
-                                      0x13,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-    addMidiControl(String("Op 4 Feedback Type"),     // name
-                   0,                               // initial value
-                   
-                   createContinuousControl(116,      // cc number
-                                           0,       // range_min
-                                           127),    // range_max
-                   
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x03,         // address_mid
-                                      0x14,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x01));       // range_max
-    
-    addMidiControl(String("Op 4 Freq Mode"),     // name
-                   0,                               // initial value
-                   
-                   createContinuousControl(117,      // cc number
-                                           0,       // range_min
-                                           127),    // range_max
-                   
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x03,         // address_mid
-                                      0x15,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x01));       // range_max
-    
-    addMidiControl(String("Op 4 Freq Coarse"),     // name
-                   0,                               // initial value
-                   
-                   createContinuousControl(118,      // cc number
-                                           0,       // range_min
-                                           127),    // range_max
-                   
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x03,         // address_mid
-                                      0x16,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x1F));       // range_max
-    
-    addMidiControl(String("Op 4 Freq Fine"),     // name
-                   0,                               // initial value
-                   
-                   createContinuousControl(119,      // cc number
-                                           0,       // range_min
-                                           127),    // range_max
-                   
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x03,         // address_mid
-                                      0x17,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x63));       // range_max
-    
-    addMidiControl(String("Op 4 Freq Detune"),     // name
-                   65,                              // initial value
-                   NULL,
-                   createSysexControl(0,            // param table
-                                      0x31,         // address_high
-                                      0x03,         // address_mid
-                                      0x18,         // address_low
-                                      1,            // size (bytes)
-                                      0x00,         // range_min
-                                      0x7F));       // range_max
-    
-}
-
-
-
-
-bool YamahaRefaceDXModel::handleMidiSysexEvent(const MidiMessage& message)
-{
-    return true;
+    return NULL;
 }
-
@@ -14,35 +14,56 @@
 #include "MidiDefines.hpp"
 #include "MidiControl.hpp"
 #include "MidiInstrumentModel.hpp"
+#include "MidiInstrumentDefinition.hpp"
 
-class YamahaRefaceCSModel : public MidiInstrumentModel
+// Sysex encoding shared by the Reface line: parameter changes and bulk
+// dumps addressed by high/mid/low, with the device's model id after the
+// group number.
+class YamahaRefaceModel : public MidiInstrumentModel
 {
 public:
-    YamahaRefaceCSModel();
-    ~YamahaRefaceCSModel() {};
+    YamahaRefaceModel(MidiInstrumentDefinition* definition)
+    : MidiInstrumentModel(definition)
+    {}
     
-    virtual bool handleMidiSysexEvent(const MidiMessage& message);
+    virtual ~YamahaRefaceModel() {}
+    
+    virtual bool createSysexParameterChange(int control_id, MidiMessage& message);
+    virtual bool createSysexPatchDump(MidiBuffer& patch_dump);
+    virtual bool createSysexPatchDumpRequest(MidiMessage& message);
     
-private:
-    uint8 sysex_group_number_high_;
-    uint8 sysex_group_number_low_;
+    // Decodes a bulk dump block into the control store, driven by the
+    // definition's block layout. Sliders are not touched; returns true if
+    // any control changed so the caller can refresh them in one go.
+    virtual bool handleMidiSysexEvent(const MidiMessage& message);
     
+protected:
+    MidiMessage createBulkDumpMessage(uint8 address_high,
+                                      uint8 address_mid,
+                                      uint8 address_low,
+                                      const uint8* data,
+                                      int num_bytes);
 };
 
-class YamahaRefaceDXModel : public MidiInstrumentModel
+class YamahaRefaceCSModel : public YamahaRefaceModel
+{
+public:
+    YamahaRefaceCSModel();
+    ~YamahaRefaceCSModel() {};
+};
+
+class YamahaRefaceDXModel : public YamahaRefaceModel
 {
 public:
     YamahaRefaceDXModel();
     ~YamahaRefaceDXModel() {};
-    
-    virtual bool handleMidiSysexEvent(const MidiMessage& message);
-    
-private:
-    uint8 sysex_group_number_high_;
-    uint8 sysex_group_number_low_;
-    
 };
 
 
+// Returns the built-in model for manufacturer/model_name if there is one,
+// otherwise a generic model from a matching definition file in the Midiot
+// Instruments folder, otherwise NULL.
+MidiInstrumentModel* createMidiInstrumentModel(const String manufacturer,
+                                               const String model_name);
 
 #endif /* MidiInstrumentModelImpl_hpp */
@@ -9,37 +9,73 @@
 #include "MidiInterface.hpp"
 #include "MidiInstrument.hpp"
 
-MidiInputPort::MidiInputPort(const String name)
-: name_(name)
+MidiInputPort::MidiInputPort(const String name,
+                             int max_sysex_bytes,
+                             int sysex_timeout_ms)
+: channel_routing_table_(new ChannelRoutingTable()),
+active_dispatches_(0),
+sysex_assembler_(max_sysex_bytes, sysex_timeout_ms),
+name_(name)
 {
 
 }
 
 MidiInputPort::~MidiInputPort()
 {
-    
+    delete channel_routing_table_.exchange(NULL);
 }
 
 
 void MidiInputPort::addInstrumentToPort(MidiInstrument* instrument)
 {
+    const ScopedLock sl(routing_write_lock_);
+    
     short inst_channel = instrument->channel();
+    ChannelRoutingTable* current_table = channel_routing_table_.get();
+    
+    if (current_table->channel_instruments[inst_channel].contains(instrument))
+    {
+        return;
+    }
+    
+    ChannelRoutingTable* new_table = new ChannelRoutingTable(*current_table);
+    new_table->channel_instruments[inst_channel].add(instrument);
     
-    channel_routing_table_[inst_channel].addIfNotAlreadyThere(instrument);
+    publishRoutingTable(new_table);
 }
 
 void MidiInputPort::removeInstrumentFromPort(MidiInstrument* instrument)
 {
+    const ScopedLock sl(routing_write_lock_);
+    
     short inst_channel = instrument->channel();
+    ChannelRoutingTable* current_table = channel_routing_table_.get();
     
-    int inst_index = channel_routing_table_[inst_channel].indexOf(instrument);
+    int inst_index = current_table->channel_instruments[inst_channel].indexOf(instrument);
     
     if (inst_index >= 0)
     {
-        channel_routing_table_[inst_channel].remove(inst_index);
+        ChannelRoutingTable* new_table = new ChannelRoutingTable(*current_table);
+        new_table->channel_instruments[inst_channel].remove(inst_index);
+        
+        publishRoutingTable(new_table);
     }
 }
 
+void MidiInputPort::publishRoutingTable(ChannelRoutingTable* new_table)
+{
+    ChannelRoutingTable* old_table = channel_routing_table_.exchange(new_table);
+    
+    // a dispatch that started before the swap may still be walking the old
+    // table; dispatches are short, so wait them out before freeing it
+    while (active_dispatches_.get() != 0)
+    {
+        Thread::yield();
+    }
+    
+    delete old_table;
+}
+
 void MidiInputPort::handleIncomingMidiMessage(MidiInput* source,
                                               const MidiMessage& message)
 {
@@ -60,29 +96,65 @@ void MidiInputPort::handleIncomingMidiMessage(MidiInput* source,
         //printf("MidiInputPort::handleIncomingMessage() is it sysex?\n");
     }
     
-    Array<MidiInstrument*> channel_instruments;
+    if (message.isSysEx())
+    {
+        const uint8* raw_data = message.getRawData();
+        const int raw_size = message.getRawDataSize();
+        
+        if (raw_data[raw_size-1] != 0xF7)
+        {
+            // the start of a message that will arrive in pieces
+            if (sysex_assembler_.addData(raw_data, raw_size, message.getTimeStamp()))
+            {
+                dispatchSysexMessage(sysex_assembler_.getMessage());
+            }
+            
+            return;
+        }
+        
+        // a complete message supersedes anything half-assembled
+        sysex_assembler_.reset();
+        dispatchSysexMessage(message);
+        
+        return;
+    }
+    
+    // no copies and no locks here: read the published snapshot in place
+    ++active_dispatches_;
+    const ChannelRoutingTable* routing_table = channel_routing_table_.get();
+    
     if (message_channel) // handling note, cc, other channel-ized MIDI command
     {
-        channel_instruments = channel_routing_table_[message_channel-1];
+        const Array<MidiInstrument*>& channel_instruments =
+            routing_table->channel_instruments[message_channel-1];
         
         for (int i=0; i<channel_instruments.size(); i++)
         {
-            channel_instruments[i]->handleIncomingMidiMessage(message);
+            channel_instruments.getUnchecked(i)->handleIncomingMidiMessage(message);
         }
     }
-    else if (message.isSysEx()) // handle sysex
+    
+    --active_dispatches_;
+}
+
+void MidiInputPort::dispatchSysexMessage(const MidiMessage& message)
+{
+    ++active_dispatches_;
+    const ChannelRoutingTable* routing_table = channel_routing_table_.get();
+    
+    // sysex carries no channel, so every instrument on the port gets a look
+    for (int i=0; i<NUM_MIDI_CHANNELS; i++)
     {
-        for (int i=0; i<NUM_MIDI_CHANNELS; i++)
+        const Array<MidiInstrument*>& channel_instruments =
+            routing_table->channel_instruments[i];
+        
+        for (int j=0; j<channel_instruments.size(); j++)
         {
-            channel_instruments = channel_routing_table_[i];
-            
-            for (int j=0; j<channel_instruments.size(); j++)
-            {
-                channel_instruments[j]->handleIncomingMidiMessage(message);
-            }
+            channel_instruments.getUnchecked(j)->handleIncomingMidiMessage(message);
         }
     }
-
+    
+    --active_dispatches_;
 }
 
 void MidiInputPort::handlePartialSysexMessage(MidiInput* source,
@@ -90,7 +162,10 @@ void MidiInputPort::handlePartialSysexMessage(MidiInput* source,
                                               int numBytesSoFar,
                                               double timestamp)
 {
-    //printf("MidiInputPort::handlePartialSysexMessage() called\n");
+    if (sysex_assembler_.addData(messageData, numBytesSoFar, timestamp))
+    {
+        dispatchSysexMessage(sysex_assembler_.getMessage());
+    }
 }
 
 
@@ -114,19 +189,26 @@ MidiOutputPort::MidiOutputPort(const String name, MidiOutput* midi_output)
 : name_(name),
 midi_output_(midi_output)
 {
+    if (midi_output_)
+    {
+        output_scheduler_ = new MidiOutputScheduler(name_, midi_output_);
+    }
 }
 
 MidiOutputPort::~MidiOutputPort()
 {
+    output_scheduler_ = NULL;
 }
 
-void MidiOutputPort::sendControllerEvent(int midi_channel,
+bool MidiOutputPort::sendControllerEvent(int midi_channel,
                          int controller_type,
                          int value)
 {
     MidiMessage m(MidiMessage::controllerEvent(midi_channel, controller_type, value));
-    m.setTimeStamp(Time::getMillisecondCounterHiRes() * 0.0001);
-    midi_output_->sendMessageNow(m);
+    m.setTimeStamp(Time::getMillisecondCounterHiRes() * 0.001);
+    
+    // slider drags and patch sends only need the latest value to arrive
+    return sendCoalescedMessage(MidiOutputScheduler::getControllerKey(midi_channel, controller_type), m);
 }
 
 void MidiOutputPort::sendNoteOn(int midi_channel,
@@ -135,7 +217,7 @@ void MidiOutputPort::sendNoteOn(int midi_channel,
 {
     MidiMessage m (MidiMessage::noteOn (midi_channel, midi_note_number, velocity));
     m.setTimeStamp (Time::getMillisecondCounterHiRes() * 0.001);
-    midi_output_->sendMessageNow(m);
+    sendMessageNow(m);
 }
 
 void MidiOutputPort::sendNoteOff(int midi_channel,
@@ -144,12 +226,79 @@ void MidiOutputPort::sendNoteOff(int midi_channel,
 {
     MidiMessage m (MidiMessage::noteOff (midi_channel, midi_note_number, velocity));
     m.setTimeStamp (Time::getMillisecondCounterHiRes() * 0.001);
-    midi_output_->sendMessageNow(m);
+    sendMessageNow(m);
 }
 
 void MidiOutputPort::sendMessageNow(const MidiMessage& message)
 {
-    midi_output_->sendMessageNow(message);
+    if (output_scheduler_)
+    {
+        output_scheduler_->scheduleMessageNow(message);
+    }
+}
+
+void MidiOutputPort::sendMessageAt(const MidiMessage& message, double time_ms)
+{
+    if (output_scheduler_)
+    {
+        output_scheduler_->scheduleMessage(message, time_ms);
+    }
+}
+
+bool MidiOutputPort::sendCoalescedMessage(uint32 key, const MidiMessage& message)
+{
+    if (output_scheduler_)
+    {
+        return output_scheduler_->scheduleCoalescedMessage(key, message);
+    }
+    
+    return false;
+}
+
+void MidiOutputPort::flushCoalescedMessage(uint32 key)
+{
+    if (output_scheduler_)
+    {
+        output_scheduler_->flushCoalescedMessage(key);
+    }
+}
+
+void MidiOutputPort::sendBlockNow(const MidiBuffer& buffer)
+{
+    if (output_scheduler_)
+    {
+        output_scheduler_->sendBlockNow(buffer);
+    }
+}
+
+void MidiOutputPort::sendBlockOfMessages(const MidiBuffer& buffer,
+                                         double start_time_ms,
+                                         double samples_per_second)
+{
+    if (output_scheduler_)
+    {
+        output_scheduler_->scheduleBlockOfMessages(buffer,
+                                                   start_time_ms,
+                                                   samples_per_second);
+    }
+}
+
+void MidiOutputPort::setBandwidthLimit(int bytes_per_second)
+{
+    if (output_scheduler_)
+    {
+        output_scheduler_->setBandwidthLimit(bytes_per_second);
+    }
+}
+
+int MidiOutputPort::getNumCoalescedMessages()
+{
+    return output_scheduler_ ? output_scheduler_->getNumCoalescedMessages() : 0;
+}
+
+int MidiOutputPort::getNumDroppedMessages()
+{
+    return output_scheduler_ ? output_scheduler_->getNumDroppedMessages() : 0;
 }
 
 
@@ -11,17 +11,28 @@
 
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "MidiDefines.hpp"
+#include "MidiOutputScheduler.hpp"
+#include "MidiSysexAssembler.hpp"
 
 #include <stdio.h>
 
 class MidiInstrument;
 
+// Immutable per-channel routing snapshot. The MIDI driver thread only ever
+// reads one of these; writers build a fresh copy and publish it.
+struct ChannelRoutingTable
+{
+    Array<MidiInstrument*> channel_instruments[NUM_MIDI_CHANNELS];
+};
+
 class MidiInputPort :
 public MidiInputCallback,
 public MidiKeyboardStateListener
 {
 public:
-    MidiInputPort(const String name);
+    MidiInputPort(const String name,
+                  int max_sysex_bytes = MIDI_SYSEX_DEFAULT_MAX_BYTES,
+                  int sysex_timeout_ms = MIDI_SYSEX_DEFAULT_TIMEOUT_MS);
     ~MidiInputPort();
 
     void addInstrumentToPort(MidiInstrument* instrument);
@@ -46,9 +57,20 @@ private:
                         int midi_note_number,
                         float velocity) override;
 
+    void publishRoutingTable(ChannelRoutingTable* new_table);
+    void dispatchSysexMessage(const MidiMessage& message);
+    
     MidiKeyboardState keyboard_state;
     
-    Array<MidiInstrument*> channel_routing_table_[NUM_MIDI_CHANNELS];
+    // current snapshot, replaced by addInstrumentToPort()/removeInstrumentFromPort()
+    Atomic<ChannelRoutingTable*> channel_routing_table_;
+    // number of dispatches currently reading a snapshot
+    Atomic<int> active_dispatches_;
+    // serializes writers only, never taken on the MIDI thread
+    CriticalSection routing_write_lock_;
+    
+    // fragments of the sysex message in flight, MIDI thread only
+    MidiSysexAssembler sysex_assembler_;
     
     const String name_;
 
@@ -66,17 +88,37 @@ public:
     void sendNoteOff(int midi_channel,
                      int midi_note_number,
                      float velocity);
-    void sendControllerEvent(int midi_channel,
+    // false if the message was dropped, see sendCoalescedMessage()
+    bool sendControllerEvent(int midi_channel,
                              int controller_type,
                              int value);
     
     void sendMessageNow(const MidiMessage& message);
+    // replaces any pending message with the same key; false if the
+    // message was dropped or the port has no output
+    bool sendCoalescedMessage(uint32 key, const MidiMessage& message);
+    // see MidiOutputScheduler::flushCoalescedMessage()
+    void flushCoalescedMessage(uint32 key);
+    
+    // time_ms is on the Time::getMillisecondCounterHiRes() clock
+    void sendMessageAt(const MidiMessage& message, double time_ms);
+    void sendBlockNow(const MidiBuffer& buffer);
+    void sendBlockOfMessages(const MidiBuffer& buffer,
+                             double start_time_ms,
+                             double samples_per_second);
+    
+    // output pacing, see MidiOutputScheduler
+    void setBandwidthLimit(int bytes_per_second);
+    int getNumCoalescedMessages();
+    int getNumDroppedMessages();
     
     const String name() { return name_; }
     
 private:
     const String name_;
     ScopedPointer<MidiOutput> midi_output_;
+    // declared after midi_output_ so it stops before the device is closed
+    ScopedPointer<MidiOutputScheduler> output_scheduler_;
 };
 
 class MidiInterface
@@ -0,0 +1,361 @@
+//
+//  MidiOutputScheduler.cpp
+//  Midiot
+//
+//  Created by Sean Bratnober on 2/4/18.
+//
+//
+
+#include "MidiOutputScheduler.hpp"
+
+// Below this many milliseconds the thread stops sleeping and yields until
+// the event is due; OS sleeps are only good to about a millisecond.
+const double MIDI_SCHEDULER_SPIN_WINDOW_MS = 1.5;
+
+// How far ahead of the wire the budget lets us burst, in milliseconds.
+// Anything bigger than the burst (a bulk dump) is sent once the budget is
+// full and then paid back before the next message.
+const double MIDI_SCHEDULER_BURST_MS = 20.0;
+
+MidiOutputScheduler::MidiOutputScheduler(const String name, MidiOutput* midi_output)
+: Thread("MidiOutputScheduler: " + name),
+midi_output_(midi_output),
+bytes_per_second_(MIDI_DEFAULT_BYTES_PER_SECOND),
+available_bytes_(0.0),
+last_refill_ms_(Time::getMillisecondCounterHiRes()),
+num_coalesced_(0),
+num_dropped_(0)
+{
+    message_queue_.ensureStorageAllocated(256);
+    coalesced_queue_.ensureStorageAllocated(MIDI_MAX_COALESCED_MESSAGES);
+    due_messages_.ensureStorageAllocated(256);
+    
+    startThread(10);
+}
+
+MidiOutputScheduler::~MidiOutputScheduler()
+{
+    signalThreadShouldExit();
+    notify();
+    stopThread(1000);
+}
+
+bool MidiOutputScheduler::insertScheduledMessage(const MidiMessage& message, double time_ms)
+{
+    ScheduledMidiMessage scheduled_message;
+    scheduled_message.message = message;
+    scheduled_message.time_ms = time_ms;
+    
+    // a value still waiting for this controller goes out first, or it
+    // would land after this one once the budget runs short
+    if (message.isController())
+    {
+        moveCoalescedMessageToQueue(getControllerKey(message.getChannel(), message.getControllerNumber()),
+                                    jmin(time_ms, Time::getMillisecondCounterHiRes()));
+    }
+    
+    // insert after the last message due at or before time_ms, so equal
+    // times go out in the order they were scheduled (addSorted doesn't
+    // promise that, and two values for one CC must not swap)
+    int start = 0;
+    int end = message_queue_.size();
+    
+    while (start < end)
+    {
+        const int middle = start + (end - start) / 2;
+        
+        if (message_queue_.getReference(middle).time_ms <= time_ms)
+        {
+            start = middle + 1;
+        }
+        else
+        {
+            end = middle;
+        }
+    }
+    
+    message_queue_.insert(start, scheduled_message);
+    
+    return start == 0;
+}
+
+void MidiOutputScheduler::moveCoalescedMessageToQueue(uint32 key, double time_ms)
+{
+    for (int i=0; i<coalesced_queue_.size(); i++)
+    {
+        if (coalesced_queue_.getReference(i).key == key)
+        {
+            const MidiMessage message(coalesced_queue_.getReference(i).message);
+            coalesced_queue_.remove(i);
+            insertScheduledMessage(message, time_ms);
+            return;
+        }
+    }
+}
+
+void MidiOutputScheduler::scheduleMessage(const MidiMessage& message, double time_ms)
+{
+    bool is_next_event;
+    
+    {
+        const ScopedLock sl(queue_lock_);
+        is_next_event = insertScheduledMessage(message, time_ms);
+    }
+    
+    if (is_next_event)
+    {
+        notify();
+    }
+}
+
+void MidiOutputScheduler::scheduleMessageNow(const MidiMessage& message)
+{
+    scheduleMessage(message, Time::getMillisecondCounterHiRes());
+}
+
+void MidiOutputScheduler::scheduleBlockOfMessages(const MidiBuffer& buffer,
+                                                  double start_time_ms,
+                                                  double samples_per_second)
+{
+    const double ms_per_sample = 1000.0 / samples_per_second;
+    bool is_next_event = false;
+    
+    {
+        const ScopedLock sl(queue_lock_);
+        
+        MidiBuffer::Iterator buffer_iter(buffer);
+        MidiMessage message;
+        int sample_position;
+        
+        while (buffer_iter.getNextEvent(message, sample_position))
+        {
+            double time_ms = start_time_ms + sample_position * ms_per_sample;
+            message.setTimeStamp(time_ms * 0.001);
+            is_next_event = insertScheduledMessage(message, time_ms) || is_next_event;
+        }
+    }
+    
+    if (is_next_event)
+    {
+        notify();
+    }
+}
+
+void MidiOutputScheduler::sendBlockNow(const MidiBuffer& buffer)
+{
+    // sample positions are treated as milliseconds from now, so a buffer
+    // with every event at 0 goes out back to back in one batch
+    scheduleBlockOfMessages(buffer, Time::getMillisecondCounterHiRes(), 1000.0);
+}
+
+bool MidiOutputScheduler::scheduleCoalescedMessage(uint32 key, const MidiMessage& message)
+{
+    {
+        const ScopedLock sl(queue_lock_);
+        
+        for (int i=0; i<coalesced_queue_.size(); i++)
+        {
+            CoalescedMidiMessage& pending = coalesced_queue_.getReference(i);
+            
+            if (pending.key == key)
+            {
+                pending.message = message;
+                ++num_coalesced_;
+                return true;
+            }
+        }
+        
+        if (coalesced_queue_.size() >= MIDI_MAX_COALESCED_MESSAGES)
+        {
+            ++num_dropped_;
+            return false;
+        }
+        
+        CoalescedMidiMessage pending;
+        pending.key = key;
+        pending.message = message;
+        coalesced_queue_.add(pending);
+    }
+    
+    notify();
+    
+    return true;
+}
+
+void MidiOutputScheduler::flushCoalescedMessage(uint32 key)
+{
+    const ScopedLock sl(queue_lock_);
+    moveCoalescedMessageToQueue(key, Time::getMillisecondCounterHiRes());
+}
+
+uint32 MidiOutputScheduler::getControllerKey(int midi_channel, int controller_type)
+{
+    // status byte and controller number, as they go out on the wire
+    return ((uint32)(0xB0 | ((midi_channel - 1) & 0x0F)) << 8) | (uint32)(controller_type & 0x7F);
+}
+
+uint32 MidiOutputScheduler::getSysexParameterKey(int sysex_address)
+{
+    return 0x80000000 | (uint32)(sysex_address & 0xFFFFFF);
+}
+
+void MidiOutputScheduler::setBandwidthLimit(int bytes_per_second)
+{
+    bytes_per_second_.set(jmax(0, bytes_per_second));
+    notify();
+}
+
+void MidiOutputScheduler::resetStatistics()
+{
+    num_coalesced_.set(0);
+    num_dropped_.set(0);
+}
+
+void MidiOutputScheduler::clearPendingMessages()
+{
+    const ScopedLock sl(queue_lock_);
+    message_queue_.clearQuick();
+    coalesced_queue_.clearQuick();
+}
+
+int MidiOutputScheduler::getNumPendingMessages()
+{
+    const ScopedLock sl(queue_lock_);
+    return message_queue_.size() + coalesced_queue_.size();
+}
+
+void MidiOutputScheduler::refillBandwidth(double now_ms)
+{
+    const int bytes_per_second = bytes_per_second_.get();
+    
+    if (bytes_per_second > 0)
+    {
+        const double burst_bytes = bytes_per_second * MIDI_SCHEDULER_BURST_MS * 0.001;
+        available_bytes_ += (now_ms - last_refill_ms_) * bytes_per_second * 0.001;
+        available_bytes_ = jmin(available_bytes_, burst_bytes);
+    }
+    
+    last_refill_ms_ = now_ms;
+}
+
+bool MidiOutputScheduler::takeBandwidth(int num_bytes)
+{
+    const int bytes_per_second = bytes_per_second_.get();
+    
+    if (bytes_per_second <= 0)
+    {
+        return true;
+    }
+    
+    const double burst_bytes = bytes_per_second * MIDI_SCHEDULER_BURST_MS * 0.001;
+    
+    if (available_bytes_ >= num_bytes || available_bytes_ >= burst_bytes)
+    {
+        available_bytes_ -= num_bytes;
+        return true;
+    }
+    
+    return false;
+}
+
+double MidiOutputScheduler::getBandwidthWaitMs(int num_bytes)
+{
+    const int bytes_per_second = bytes_per_second_.get();
+    
+    if (bytes_per_second <= 0)
+    {
+        return 0.0;
+    }
+    
+    const double burst_bytes = bytes_per_second * MIDI_SCHEDULER_BURST_MS * 0.001;
+    const double needed_bytes = jmin((double)num_bytes, burst_bytes) - available_bytes_;
+    
+    return jmax(0.0, needed_bytes * 1000.0 / bytes_per_second);
+}
+
+void MidiOutputScheduler::run()
+{
+    while (!threadShouldExit())
+    {
+        double wait_ms = -1.0;
+        
+        {
+            const ScopedLock sl(queue_lock_);
+            
+            const double now_ms = Time::getMillisecondCounterHiRes();
+            refillBandwidth(now_ms);
+            
+            // timed messages first, in order, as far as the budget allows
+            int num_due = 0;
+            bool out_of_bandwidth = false;
+            
+            while (num_due < message_queue_.size())
+            {
+                const ScheduledMidiMessage& next = message_queue_.getReference(num_due);
+                
+                if (next.time_ms > now_ms)
+                {
+                    break;
+                }
+                
+                if (!takeBandwidth(next.message.getRawDataSize()))
+                {
+                    out_of_bandwidth = true;
+                    wait_ms = getBandwidthWaitMs(next.message.getRawDataSize());
+                    break;
+                }
+                
+                due_messages_.add(next.message);
+                num_due++;
+            }
+            
+            message_queue_.removeRange(0, num_due);
+            
+            // then whatever is left of the budget goes to coalesced messages
+            int num_coalesced_due = 0;
+            
+            while (!out_of_bandwidth && num_coalesced_due < coalesced_queue_.size())
+            {
+                const CoalescedMidiMessage& next = coalesced_queue_.getReference(num_coalesced_due);
+                
+                if (!takeBandwidth(next.message.getRawDataSize()))
+                {
+                    out_of_bandwidth = true;
+                    wait_ms = getBandwidthWaitMs(next.message.getRawDataSize());
+                    break;
+                }
+                
+                due_messages_.add(next.message);
+                num_coalesced_due++;
+            }
+            
+            coalesced_queue_.removeRange(0, num_coalesced_due);
+            
+            if (!out_of_bandwidth && message_queue_.size() > 0)
+            {
+                wait_ms = message_queue_.getReference(0).time_ms - now_ms;
+            }
+        }
+        
+        for (int i=0; i<due_messages_.size(); i++)
+        {
+            midi_output_->sendMessageNow(due_messages_.getReference(i));
+        }
+        
+        due_messages_.clearQuick();
+        
+        if (wait_ms < 0.0)
+        {
+            // nothing scheduled; scheduleMessage() will wake us
+            wait(-1);
+        }
+        else if (wait_ms > MIDI_SCHEDULER_SPIN_WINDOW_MS)
+        {
+            wait((int)(wait_ms - MIDI_SCHEDULER_SPIN_WINDOW_MS + 0.5));
+        }
+        else
+        {
+            Thread::yield();
+        }
+    }
+}
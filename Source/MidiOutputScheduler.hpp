@@ -0,0 +1,114 @@
+//
+//  MidiOutputScheduler.hpp
+//  Midiot
+//
+//  Created by Sean Bratnober on 2/4/18.
+//
+//
+
+#ifndef MidiOutputScheduler_hpp
+#define MidiOutputScheduler_hpp
+
+#include <stdio.h>
+#include "../JuceLibraryCode/JuceHeader.h"
+
+// 31250 baud at 10 bits per byte on a DIN MIDI cable
+const int MIDI_DEFAULT_BYTES_PER_SECOND = 3125;
+const int MIDI_MAX_COALESCED_MESSAGES = 512;
+
+// Owns the only path to a MidiOutput device. Any thread may schedule
+// messages against Time::getMillisecondCounterHiRes(); a dedicated
+// high-priority thread sends them in time order.
+//
+// Output is paced to a bytes/sec budget. Coalesced messages (CC sweeps,
+// patch sends) are sent as soon as the budget allows, and a newer message
+// with the same key replaces one that has not gone out yet. Timed messages
+// get the budget first, so a coalesced message that must not arrive after
+// a timed one is flushed into the timed queue when that one is scheduled:
+// automatically for controllers, with flushCoalescedMessage() otherwise.
+class MidiOutputScheduler : public Thread
+{
+public:
+    MidiOutputScheduler(const String name, MidiOutput* midi_output);
+    ~MidiOutputScheduler();
+    
+    // time_ms is on the Time::getMillisecondCounterHiRes() clock
+    void scheduleMessage(const MidiMessage& message, double time_ms);
+    void scheduleMessageNow(const MidiMessage& message);
+    
+    // Same contract as MidiOutput::sendBlockOfMessages(): event sample
+    // positions are offsets from start_time_ms at samples_per_second.
+    void scheduleBlockOfMessages(const MidiBuffer& buffer,
+                                 double start_time_ms,
+                                 double samples_per_second);
+    void sendBlockNow(const MidiBuffer& buffer);
+    
+    // Sent as soon as bandwidth allows. If a message with the same key is
+    // still waiting it is replaced in place and counted as coalesced; if
+    // the coalescing table is full the message is dropped and counted, and
+    // false is returned.
+    bool scheduleCoalescedMessage(uint32 key, const MidiMessage& message);
+    // Moves the message waiting with this key, if any, to the timed queue
+    // as due now, ahead of anything scheduled after this call.
+    void flushCoalescedMessage(uint32 key);
+    static uint32 getControllerKey(int midi_channel, int controller_type);
+    // high bit set so sysex keys never collide with controller keys
+    static uint32 getSysexParameterKey(int sysex_address);
+    
+    // 0 disables pacing
+    void setBandwidthLimit(int bytes_per_second);
+    int getBandwidthLimit() { return bytes_per_second_.get(); }
+    
+    int getNumCoalescedMessages() { return num_coalesced_.get(); }
+    int getNumDroppedMessages() { return num_dropped_.get(); }
+    void resetStatistics();
+    
+    void clearPendingMessages();
+    int getNumPendingMessages();
+    
+    void run() override;
+    
+private:
+    struct ScheduledMidiMessage
+    {
+        MidiMessage message;
+        double time_ms;
+    };
+    
+    struct CoalescedMidiMessage
+    {
+        uint32 key;
+        MidiMessage message;
+    };
+    
+    // caller must hold queue_lock_; returns true if it became the next event
+    bool insertScheduledMessage(const MidiMessage& message, double time_ms);
+    // caller must hold queue_lock_
+    void moveCoalescedMessageToQueue(uint32 key, double time_ms);
+    
+    // budget bookkeeping, only touched from run()
+    void refillBandwidth(double now_ms);
+    bool takeBandwidth(int num_bytes);
+    double getBandwidthWaitMs(int num_bytes);
+    
+    MidiOutput* midi_output_;
+    
+    CriticalSection queue_lock_;
+    Array<ScheduledMidiMessage> message_queue_;
+    // oldest request first
+    Array<CoalescedMidiMessage> coalesced_queue_;
+    
+    Atomic<int> bytes_per_second_;
+    double available_bytes_;
+    double last_refill_ms_;
+    
+    Atomic<int> num_coalesced_;
+    Atomic<int> num_dropped_;
+    
+    // messages due now, sent outside queue_lock_
+    Array<MidiMessage> due_messages_;
+    
+    JUCE_DECLARE_NON_COPYABLE(MidiOutputScheduler)
+};
+
+#endif /* MidiOutputScheduler_hpp */
@@ -0,0 +1,306 @@
+//
+//  MidiPatchBank.cpp
+//  Midiot
+//
+//  Created by Sean Bratnober on 2/16/18.
+//
+//
+
+#include "MidiPatchBank.hpp"
+#include "MidiInstrumentModel.hpp"
+#include "MidiotFileUtils.hpp"
+
+static const char MIDI_PATCH_BANK_MAGIC[4] = { 'M', 'D', 'B', 'K' };
+
+MidiPatchBank::MidiPatchBank(const File& bank_file)
+: bank_file_(bank_file),
+data_(NULL),
+definition_hash_(0),
+num_values_(0),
+num_patches_(-1),
+record_bytes_(0),
+records_offset_(0),
+name_index_offset_(0)
+{
+    if (!bank_file_.existsAsFile())
+    {
+        return;
+    }
+    
+    mapped_file_ = new MemoryMappedFile(bank_file_, MemoryMappedFile::readOnly);
+    
+    const uint8* data = static_cast<const uint8*>(mapped_file_->getData());
+    const size_t size = mapped_file_->getSize();
+    
+    if (data == NULL ||
+        size < (size_t)MIDI_PATCH_BANK_HEADER_BYTES ||
+        memcmp(data, MIDI_PATCH_BANK_MAGIC, 4) != 0 ||
+        ByteOrder::littleEndianShort(data + 4) != MIDI_PATCH_BANK_VERSION)
+    {
+        mapped_file_ = nullptr;
+        return;
+    }
+    
+    const int num_values = ByteOrder::littleEndianShort(data + 6);
+    const uint32 num_patches = ByteOrder::littleEndianInt(data + 12);
+    const uint32 record_bytes = ByteOrder::littleEndianInt(data + 16);
+    const uint32 records_offset = ByteOrder::littleEndianInt(data + 20);
+    const uint32 name_index_offset = ByteOrder::littleEndianInt(data + 24);
+    
+    // every offset is checked once here so lookups never have to
+    if (record_bytes != (uint32)(MIDI_PATCH_BANK_NAME_BYTES + num_values * 4) ||
+        num_patches > 0x7FFFFFFF / jmax(1u, record_bytes) ||
+        (uint64)records_offset + (uint64)num_patches * record_bytes > size ||
+        (uint64)name_index_offset + (uint64)num_patches * 4 > size)
+    {
+        mapped_file_ = nullptr;
+        return;
+    }
+    
+    data_ = data;
+    definition_hash_ = ByteOrder::littleEndianInt(data + 8);
+    num_values_ = num_values;
+    num_patches_ = (int)num_patches;
+    record_bytes_ = (int)record_bytes;
+    records_offset_ = (int)records_offset;
+    name_index_offset_ = (int)name_index_offset;
+}
+
+MidiPatchBank::~MidiPatchBank()
+{
+}
+
+const char* MidiPatchBank::getRecordName(int record) const
+{
+    return (const char*)(data_ + records_offset_ + (size_t)record * record_bytes_);
+}
+
+String MidiPatchBank::getPatchName(int record) const
+{
+    if (!isPositiveAndBelow(record, num_patches_))
+    {
+        return String();
+    }
+    
+    const char* name = getRecordName(record);
+    int name_bytes = 0;
+    
+    while (name_bytes < MIDI_PATCH_BANK_NAME_BYTES && name[name_bytes] != 0)
+    {
+        name_bytes++;
+    }
+    
+    return String::fromUTF8(name, name_bytes);
+}
+
+const uint8* MidiPatchBank::getPatchValueData(int record) const
+{
+    if (!isPositiveAndBelow(record, num_patches_))
+    {
+        return NULL;
+    }
+    
+    return (const uint8*)getRecordName(record) + MIDI_PATCH_BANK_NAME_BYTES;
+}
+
+int MidiPatchBank::getRecordForSortedIndex(int sorted_index) const
+{
+    if (!isPositiveAndBelow(sorted_index, num_patches_))
+    {
+        return -1;
+    }
+    
+    int record = (int)ByteOrder::littleEndianInt(data_ + name_index_offset_ + (size_t)sorted_index * 4);
+    
+    return isPositiveAndBelow(record, num_patches_) ? record : -1;
+}
+
+int MidiPatchBank::findPatch(const String& patch_name) const
+{
+    // names are compared as zero-padded UTF-8 bytes, the order writeBank sorts by
+    char key[MIDI_PATCH_BANK_NAME_BYTES] = { 0 };
+    patch_name.copyToUTF8(key, MIDI_PATCH_BANK_NAME_BYTES);
+    
+    int low = 0;
+    int high = num_patches_ - 1;
+    
+    while (low <= high)
+    {
+        const int middle = (low + high) / 2;
+        const int record = getRecordForSortedIndex(middle);
+        
+        if (record < 0)
+        {
+            return -1;
+        }
+        
+        const int comparison = memcmp(getRecordName(record), key, MIDI_PATCH_BANK_NAME_BYTES);
+        
+        if (comparison == 0)
+        {
+            return record;
+        }
+        
+        if (comparison < 0)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle - 1;
+        }
+    }
+    
+    return -1;
+}
+
+bool MidiPatchBank::loadPatch(int record, MidiInstrumentModel& model) const
+{
+    MidiControlStore& control_store = model.getControlStore();
+    const uint8* value_data = getPatchValueData(record);
+    
+    if (value_data == NULL ||
+        num_values_ != control_store.size() ||
+        definition_hash_ != model.getDefinitionHash())
+    {
+        return false;
+    }
+    
+    for (int i=0; i<num_values_; i++)
+    {
+        control_store.set_value(i, (int)ByteOrder::littleEndianInt(value_data + i * 4));
+    }
+    
+    return true;
+}
+
+struct BankNameComparator
+{
+    BankNameComparator(const HeapBlock<char>& names) : names_(names) {}
+    
+    int compareElements(int first, int second) const
+    {
+        return memcmp(names_ + (size_t)first * MIDI_PATCH_BANK_NAME_BYTES,
+                      names_ + (size_t)second * MIDI_PATCH_BANK_NAME_BYTES,
+                      MIDI_PATCH_BANK_NAME_BYTES);
+    }
+    
+    const HeapBlock<char>& names_;
+};
+
+bool MidiPatchBank::writeBank(const File& bank_file,
+                              uint32 definition_hash,
+                              int num_values,
+                              const StringArray& patch_names,
+                              const Array<int>& patch_values)
+{
+    const int num_patches = patch_names.size();
+    
+    if (num_values > 0xFFFF || patch_values.size() != num_patches * num_values)
+    {
+        return false;
+    }
+    
+    const int record_bytes = MIDI_PATCH_BANK_NAME_BYTES + num_values * 4;
+    const int records_offset = MIDI_PATCH_BANK_HEADER_BYTES;
+    const int name_index_offset = records_offset + num_patches * record_bytes;
+    
+    HeapBlock<char> names((size_t)jmax(1, num_patches) * MIDI_PATCH_BANK_NAME_BYTES, true);
+    Array<int> name_index;
+    name_index.ensureStorageAllocated(num_patches);
+    
+    for (int i=0; i<num_patches; i++)
+    {
+        // copyToUTF8 stops on a character boundary and always terminates
+        patch_names[i].copyToUTF8(names + (size_t)i * MIDI_PATCH_BANK_NAME_BYTES, MIDI_PATCH_BANK_NAME_BYTES);
+        name_index.add(i);
+    }
+    
+    BankNameComparator comparator(names);
+    name_index.sort(comparator, true);
+    
+    MemoryBlock bank_data;
+    MemoryOutputStream bank_stream(bank_data, false);
+    bank_stream.preallocate((size_t)name_index_offset + (size_t)num_patches * 4);
+    
+    bank_stream.write(MIDI_PATCH_BANK_MAGIC, 4);
+    bank_stream.writeShort((short)MIDI_PATCH_BANK_VERSION);
+    bank_stream.writeShort((short)num_values);
+    bank_stream.writeInt((int)definition_hash);
+    bank_stream.writeInt(num_patches);
+    bank_stream.writeInt(record_bytes);
+    bank_stream.writeInt(records_offset);
+    bank_stream.writeInt(name_index_offset);
+    bank_stream.writeInt(0);
+    
+    for (int i=0; i<num_patches; i++)
+    {
+        bank_stream.write(names + (size_t)i * MIDI_PATCH_BANK_NAME_BYTES, MIDI_PATCH_BANK_NAME_BYTES);
+        
+        for (int j=0; j<num_values; j++)
+        {
+            bank_stream.writeInt(patch_values.getUnchecked(i * num_values + j));
+        }
+    }
+    
+    for (int i=0; i<num_patches; i++)
+    {
+        bank_stream.writeInt(name_index.getUnchecked(i));
+    }
+    
+    bank_stream.flush();
+    
+    // written beside the old bank and swapped in; on Windows the swap
+    // fails while anything still has the old bank mapped
+    return MidiotFileUtils::replaceFileAtomically(bank_file, bank_data.getData(), bank_data.getSize());
+}
+
+bool MidiPatchBank::mergeIntoBank(const File& bank_file,
+                                  uint32 definition_hash,
+                                  int num_values,
+                                  const StringArray& patch_names,
+                                  const Array<int>& patch_values)
+{
+    if (patch_values.size() != patch_names.size() * num_values)
+    {
+        return false;
+    }
+    
+    StringArray merged_names;
+    Array<int> merged_values;
+    
+    {
+        // unmapped again before the new bank is swapped in
+        MidiPatchBank existing_bank(bank_file);
+        
+        if (existing_bank.isValid() &&
+            existing_bank.getDefinitionHash() == definition_hash &&
+            existing_bank.getNumValues() == num_values)
+        {
+            merged_values.ensureStorageAllocated((existing_bank.getNumPatches() + patch_names.size()) * num_values);
+            
+            for (int i=0; i<existing_bank.getNumPatches(); i++)
+            {
+                const String patch_name(existing_bank.getPatchName(i));
+                
+                if (patch_names.contains(patch_name))
+                {
+                    continue;
+                }
+                
+                const uint8* value_data = existing_bank.getPatchValueData(i);
+                merged_names.add(patch_name);
+                
+                for (int j=0; j<num_values; j++)
+                {
+                    merged_values.add((int)ByteOrder::littleEndianInt(value_data + j * 4));
+                }
+            }
+        }
+    }
+    
+    merged_names.addArray(patch_names);
+    merged_values.addArray(patch_values);
+    
+    return writeBank(bank_file, definition_hash, num_values, merged_names, merged_values);
+}
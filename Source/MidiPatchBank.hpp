@@ -0,0 +1,97 @@
+//
+//  MidiPatchBank.hpp
+//  Midiot
+//
+//  Created by Sean Bratnober on 2/16/18.
+//
+//
+
+#ifndef MidiPatchBank_hpp
+#define MidiPatchBank_hpp
+
+#include <stdio.h>
+#include "../JuceLibraryCode/JuceHeader.h"
+
+class MidiInstrumentModel;
+
+// Bank file (.mdbank) holding every patch for one instrument model, all
+// fields little-endian:
+//
+//   0   char[4]   "MDBK"
+//   4   uint16    format version
+//   6   uint16    values per patch
+//   8   uint32    MidiInstrumentModel::getDefinitionHash()
+//   12  uint32    number of patches
+//   16  uint32    bytes per record
+//   20  uint32    offset of the first record
+//   24  uint32    offset of the name index
+//   28  uint32    reserved
+//
+// Each record is a zero-padded UTF-8 name followed by one int32 per
+// control id. The name index lists record numbers sorted by name.
+const int MIDI_PATCH_BANK_VERSION = 1;
+const int MIDI_PATCH_BANK_HEADER_BYTES = 32;
+const int MIDI_PATCH_BANK_NAME_BYTES = 64;
+
+// Read-only view of a memory-mapped bank file. Every lookup is a pointer
+// offset into the mapping; nothing is parsed or copied up front.
+class MidiPatchBank
+{
+public:
+    MidiPatchBank(const File& bank_file);
+    ~MidiPatchBank();
+    
+    // false if the file is missing, truncated or not a bank
+    bool isValid() const { return num_patches_ >= 0; }
+    
+    const File& getFile() const { return bank_file_; }
+    uint32 getDefinitionHash() const { return definition_hash_; }
+    int getNumValues() const { return num_values_; }
+    int getNumPatches() const { return jmax(0, num_patches_); }
+    
+    // by record number, 0 to getNumPatches()-1
+    String getPatchName(int record) const;
+    const uint8* getPatchValueData(int record) const;
+    
+    // binary search of the name index; -1 if there is no such patch
+    int findPatch(const String& patch_name) const;
+    
+    // record numbers in name order
+    int getRecordForSortedIndex(int sorted_index) const;
+    
+    // false, leaving the model untouched, if the bank is for another model
+    bool loadPatch(int record, MidiInstrumentModel& model) const;
+    
+    // Nothing may have bank_file mapped while it is written (see
+    // MidiPatchLibrary::beginBankWrite()).
+    static bool writeBank(const File& bank_file,
+                          uint32 definition_hash,
+                          int num_values,
+                          const StringArray& patch_names,
+                          const Array<int>& patch_values);
+    // Adds patches to the bank, replacing any with the same name. The
+    // existing bank is dropped if it is for a different model.
+    static bool mergeIntoBank(const File& bank_file,
+                              uint32 definition_hash,
+                              int num_values,
+                              const StringArray& patch_names,
+                              const Array<int>& patch_values);
+    
+private:
+    const char* getRecordName(int record) const;
+    
+    const File bank_file_;
+    ScopedPointer<MemoryMappedFile> mapped_file_;
+    const uint8* data_;
+    
+    uint32 definition_hash_;
+    int num_values_;
+    int num_patches_;
+    int record_bytes_;
+    int records_offset_;
+    int name_index_offset_;
+    
+    JUCE_DECLARE_NON_COPYABLE(MidiPatchBank)
+};
+
+#endif /* MidiPatchBank_hpp */
@@ -0,0 +1,265 @@
+//
+//  MidiPatchFile.cpp
+//  Midiot
+//
+//  Created by Sean Bratnober on 2/14/18.
+//
+//
+
+#include "MidiPatchFile.hpp"
+#include "MidiInstrumentModel.hpp"
+#include "MidiotFileUtils.hpp"
+
+static const char MIDI_BINARY_PATCH_MAGIC[4] = { 'M', 'D', 'P', 'B' };
+
+bool MidiPatchFile::isBinaryPatchFile(const File& patch_file)
+{
+    return patch_file.hasFileExtension(MidiotFileUtils::getBinaryPatchFileExtension());
+}
+
+bool MidiPatchFile::readPatch(const File& patch_file, MidiInstrumentModel& model)
+{
+    MemoryBlock patch_data;
+    
+    if (!patch_file.loadFileAsData(patch_data))
+    {
+        return false;
+    }
+    
+    return decodePatch(patch_data, model);
+}
+
+bool MidiPatchFile::writePatch(const File& patch_file,
+                               const String& patch_name,
+                               MidiInstrumentModel& model)
+{
+    MemoryBlock patch_data;
+    
+    if (!encodePatch(patch_file, patch_name, model, patch_data))
+    {
+        return false;
+    }
+    
+    return MidiotFileUtils::replaceFileAtomically(patch_file, patch_data.getData(), patch_data.getSize());
+}
+
+bool MidiPatchFile::encodePatch(const File& patch_file,
+                                const String& patch_name,
+                                MidiInstrumentModel& model,
+                                MemoryBlock& patch_data)
+{
+    if (isBinaryPatchFile(patch_file))
+    {
+        return writeBinaryPatch(patch_data, patch_name, model);
+    }
+    
+    const String patch_text(JSON::toString(createPatchVar(patch_name, model)));
+    
+    patch_data.setSize(0);
+    patch_data.append(patch_text.toRawUTF8(), patch_text.getNumBytesAsUTF8());
+    
+    return true;
+}
+
+bool MidiPatchFile::decodePatch(const MemoryBlock& patch_data, MidiInstrumentModel& model)
+{
+    if (patch_data.getSize() >= 4 &&
+        memcmp(patch_data.getData(), MIDI_BINARY_PATCH_MAGIC, 4) == 0)
+    {
+        return readBinaryPatch(patch_data.getData(), patch_data.getSize(), model);
+    }
+    
+    return readJSONPatch(JSON::parse(patch_data.toString()), model);
+}
+
+bool MidiPatchFile::readJSONPatch(const File& patch_file, MidiInstrumentModel& model)
+{
+    return readJSONPatch(JSON::parse(patch_file), model);
+}
+
+bool MidiPatchFile::readJSONPatch(const var& patch_json, MidiInstrumentModel& model)
+{
+    DynamicObject* patch_obj = patch_json.getDynamicObject();
+    
+    if (!patch_obj ||
+        patch_obj->getProperty("manufacturer").toString() != model.manufacturer() ||
+        patch_obj->getProperty("model_name").toString() != model.model_name())
+    {
+        return false;
+    }
+    
+    DynamicObject* param_obj = patch_obj->getProperty("params").getDynamicObject();
+    
+    if (!param_obj)
+    {
+        return false;
+    }
+    
+    MidiControlStore& control_store = model.getControlStore();
+    
+    for (auto prop : param_obj->getProperties())
+    {
+        int control_id = model.getMidiControlId(prop.name.toString());
+        
+        if (control_id >= 0)
+        {
+            control_store.set_value(control_id, param_obj->getProperty(prop.name));
+        }
+    }
+    
+    return true;
+}
+
+bool MidiPatchFile::writeJSONPatch(const File& patch_file,
+                                   const String& patch_name,
+                                   MidiInstrumentModel& model)
+{
+    const String patch_text(JSON::toString(createPatchVar(patch_name, model)));
+    
+    return MidiotFileUtils::replaceFileAtomically(patch_file, patch_text.toRawUTF8(), patch_text.getNumBytesAsUTF8());
+}
+
+var MidiPatchFile::createPatchVar(const String& patch_name, MidiInstrumentModel& model)
+{
+    DynamicObject* patch_obj = new DynamicObject();
+    patch_obj->setProperty("manufacturer", model.manufacturer());
+    patch_obj->setProperty("model_name", model.model_name());
+    patch_obj->setProperty("patch_name", patch_name);
+    patch_obj->setProperty("params", createParametersVar(model));
+    
+    var json(patch_obj);
+    return json;
+}
+
+var MidiPatchFile::createParametersVar(MidiInstrumentModel& model)
+{
+    DynamicObject* params_obj = new DynamicObject();
+    
+    const MidiControlStore& control_store = model.getControlStore();
+    const int* values = control_store.values();
+    
+    for (int i=0; i<control_store.size(); i++)
+    {
+        params_obj->setProperty(control_store.name(i), values[i]);
+    }
+    
+    var json(params_obj);
+    return json;
+}
+
+bool MidiPatchFile::writeBinaryPatch(const File& patch_file,
+                                     const String& patch_name,
+                                     MidiInstrumentModel& model)
+{
+    MemoryBlock patch_data;
+    
+    if (!writeBinaryPatch(patch_data, patch_name, model))
+    {
+        return false;
+    }
+    
+    return MidiotFileUtils::replaceFileAtomically(patch_file, patch_data.getData(), patch_data.getSize());
+}
+
+bool MidiPatchFile::writeBinaryPatch(MemoryBlock& patch_data,
+                                     const String& patch_name,
+                                     MidiInstrumentModel& model)
+{
+    const MidiControlStore& control_store = model.getControlStore();
+    
+    return writeBinaryPatch(patch_data,
+                            patch_name,
+                            model.getDefinitionHash(),
+                            control_store.values(),
+                            control_store.size());
+}
+
+bool MidiPatchFile::writeBinaryPatch(MemoryBlock& patch_data,
+                                     const String& patch_name,
+                                     uint32 definition_hash,
+                                     const int* values,
+                                     int num_values)
+{
+    if (num_values > 0xFFFF)
+    {
+        return false;
+    }
+    
+    const int name_bytes = jmin((int)patch_name.getNumBytesAsUTF8(), MIDI_BINARY_PATCH_MAX_NAME_BYTES);
+    
+    patch_data.setSize(0);
+    MemoryOutputStream patch_stream(patch_data, false);
+    patch_stream.preallocate(MIDI_BINARY_PATCH_HEADER_BYTES + name_bytes + num_values * 4);
+    
+    patch_stream.write(MIDI_BINARY_PATCH_MAGIC, 4);
+    patch_stream.writeShort((short)MIDI_BINARY_PATCH_VERSION);
+    patch_stream.writeShort((short)num_values);
+    patch_stream.writeInt((int)definition_hash);
+    patch_stream.writeShort((short)name_bytes);
+    patch_stream.write(patch_name.toRawUTF8(), (size_t)name_bytes);
+    
+    for (int i=0; i<num_values; i++)
+    {
+        patch_stream.writeInt(values[i]);
+    }
+    
+    patch_stream.flush();
+    
+    return true;
+}
+
+bool MidiPatchFile::readBinaryPatch(const File& patch_file,
+                                    MidiInstrumentModel& model,
+                                    String* patch_name)
+{
+    MemoryBlock patch_data;
+    
+    if (!patch_file.loadFileAsData(patch_data))
+    {
+        return false;
+    }
+    
+    return readBinaryPatch(patch_data.getData(), patch_data.getSize(), model, patch_name);
+}
+
+bool MidiPatchFile::readBinaryPatch(const void* patch_data,
+                                    size_t patch_data_size,
+                                    MidiInstrumentModel& model,
+                                    String* patch_name)
+{
+    const uint8* data = static_cast<const uint8*>(patch_data);
+    
+    if (patch_data_size < (size_t)MIDI_BINARY_PATCH_HEADER_BYTES ||
+        memcmp(data, MIDI_BINARY_PATCH_MAGIC, 4) != 0 ||
+        ByteOrder::littleEndianShort(data + 4) != MIDI_BINARY_PATCH_VERSION)
+    {
+        return false;
+    }
+    
+    MidiControlStore& control_store = model.getControlStore();
+    
+    const int num_values = ByteOrder::littleEndianShort(data + 6);
+    const uint32 definition_hash = ByteOrder::littleEndianInt(data + 8);
+    const int name_bytes = ByteOrder::littleEndianShort(data + 12);
+    
+    if (num_values != control_store.size() ||
+        definition_hash != model.getDefinitionHash() ||
+        patch_data_size < (size_t)(MIDI_BINARY_PATCH_HEADER_BYTES + name_bytes + num_values * 4))
+    {
+        return false;
+    }
+    
+    if (patch_name)
+    {
+        *patch_name = String::fromUTF8((const char*)data + MIDI_BINARY_PATCH_HEADER_BYTES, name_bytes);
+    }
+    
+    const uint8* value_data = data + MIDI_BINARY_PATCH_HEADER_BYTES + name_bytes;
+    
+    for (int i=0; i<num_values; i++)
+    {
+        control_store.set_value(i, (int)ByteOrder::littleEndianInt(value_data + i * 4));
+    }
+    
+    return true;
+}
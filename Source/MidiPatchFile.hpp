@@ -0,0 +1,85 @@
+//
+//  MidiPatchFile.hpp
+//  Midiot
+//
+//  Created by Sean Bratnober on 2/14/18.
+//
+//
+
+#ifndef MidiPatchFile_hpp
+#define MidiPatchFile_hpp
+
+#include <stdio.h>
+#include "../JuceLibraryCode/JuceHeader.h"
+
+class MidiInstrumentModel;
+
+// Binary patch format (.mdpb), all fields little-endian:
+//
+//   0   char[4]   "MDPB"
+//   4   uint16    format version
+//   6   uint16    number of values
+//   8   uint32    MidiInstrumentModel::getDefinitionHash()
+//   12  uint16    patch name length in bytes
+//   14  char[]    patch name, UTF-8, not terminated
+//   ..  int32[]   control values, by control id
+//
+// Values are indexed by control id, so a patch only loads into a model
+// whose definition hash matches the one it was saved from.
+const int MIDI_BINARY_PATCH_VERSION = 1;
+const int MIDI_BINARY_PATCH_HEADER_BYTES = 14;
+const int MIDI_BINARY_PATCH_MAX_NAME_BYTES = 255;
+
+class MidiPatchFile
+{
+public:
+    static bool isBinaryPatchFile(const File& patch_file);
+    
+    // .mdpb files use the binary format, anything else is JSON. Reading
+    // sets the model's control values without sending them.
+    static bool readPatch(const File& patch_file, MidiInstrumentModel& model);
+    static bool writePatch(const File& patch_file,
+                           const String& patch_name,
+                           MidiInstrumentModel& model);
+    
+    // The in-memory halves of readPatch()/writePatch(), for callers that
+    // do the file I/O elsewhere. Encoding picks the format from the file's
+    // extension; decoding tells the formats apart by content.
+    static bool encodePatch(const File& patch_file,
+                            const String& patch_name,
+                            MidiInstrumentModel& model,
+                            MemoryBlock& patch_data);
+    static bool decodePatch(const MemoryBlock& patch_data, MidiInstrumentModel& model);
+    
+    static bool readJSONPatch(const File& patch_file, MidiInstrumentModel& model);
+    static bool readJSONPatch(const var& patch_json, MidiInstrumentModel& model);
+    static bool writeJSONPatch(const File& patch_file,
+                               const String& patch_name,
+                               MidiInstrumentModel& model);
+    static var createPatchVar(const String& patch_name, MidiInstrumentModel& model);
+    static var createParametersVar(MidiInstrumentModel& model);
+    
+    static bool writeBinaryPatch(const File& patch_file,
+                                 const String& patch_name,
+                                 MidiInstrumentModel& model);
+    static bool writeBinaryPatch(MemoryBlock& patch_data,
+                                 const String& patch_name,
+                                 MidiInstrumentModel& model);
+    static bool writeBinaryPatch(MemoryBlock& patch_data,
+                                 const String& patch_name,
+                                 uint32 definition_hash,
+                                 const int* values,
+                                 int num_values);
+    
+    // Copies the values straight into the model's control store; returns
+    // false, leaving the model untouched, if the data isn't a patch for it.
+    static bool readBinaryPatch(const File& patch_file,
+                                MidiInstrumentModel& model,
+                                String* patch_name = NULL);
+    static bool readBinaryPatch(const void* patch_data,
+                                size_t patch_data_size,
+                                MidiInstrumentModel& model,
+                                String* patch_name = NULL);
+};
+
+#endif /* MidiPatchFile_hpp */
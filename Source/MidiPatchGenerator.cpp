@@ -0,0 +1,183 @@
+//
+//  MidiPatchGenerator.cpp
+//  Midiot
+//
+//  Created by Sean Bratnober on 2/24/18.
+//
+//
+
+#include "MidiPatchGenerator.hpp"
+#include "MidiInstrumentModel.hpp"
+
+MidiPatchGenerator::MidiPatchGenerator(MidiInstrumentModel& model)
+: num_values_(model.getControlStore().size()),
+definition_hash_(model.getDefinitionHash()),
+range_mins_((size_t)jmax(1, num_values_), true),
+range_maxs_((size_t)jmax(1, num_values_), true),
+stepped_((size_t)jmax(1, num_values_), true),
+value_map_starts_((size_t)jmax(1, num_values_), true),
+value_map_sizes_((size_t)jmax(1, num_values_), true)
+{
+    const MidiControlStore& control_store = model.getControlStore();
+    
+    for (int i=0; i<num_values_; i++)
+    {
+        const Array<int>& value_map = model.getControlValueMap(i);
+        
+        range_mins_[i] = control_store.range_min(i);
+        range_maxs_[i] = jmax(control_store.range_min(i), control_store.range_max(i));
+        stepped_[i] = model.isSteppedControl(i);
+        
+        value_map_starts_[i] = value_maps_.size();
+        value_map_sizes_[i] = value_map.size();
+        value_maps_.addArray(value_map);
+    }
+}
+
+MidiPatchGenerator::~MidiPatchGenerator()
+{
+}
+
+String MidiPatchGenerator::getGenerationModeName(GenerationMode mode)
+{
+    switch (mode)
+    {
+        case RandomPatches:     return "Random";
+        case MutatePatch:       return "Mutate";
+        case CrossoverPatches:  return "Crossover";
+        default:                break;
+    }
+    
+    return String();
+}
+
+int MidiPatchGenerator::getRandomSetting(int control_id)
+{
+    if (value_map_sizes_[control_id] > 0)
+    {
+        return value_maps_.getUnchecked(value_map_starts_[control_id] +
+                                        random_.nextInt(value_map_sizes_[control_id]));
+    }
+    
+    return range_mins_[control_id] + random_.nextInt(range_maxs_[control_id] - range_mins_[control_id] + 1);
+}
+
+int MidiPatchGenerator::constrainValue(int control_id, int value) const
+{
+    value = jlimit(range_mins_[control_id], range_maxs_[control_id], value);
+    
+    const int num_settings = value_map_sizes_[control_id];
+    
+    if (num_settings == 0)
+    {
+        return value;
+    }
+    
+    const int* settings = value_maps_.begin() + value_map_starts_[control_id];
+    int best_setting = settings[0];
+    
+    for (int i=1; i<num_settings; i++)
+    {
+        if (std::abs(settings[i] - value) < std::abs(best_setting - value))
+        {
+            best_setting = settings[i];
+        }
+    }
+    
+    return best_setting;
+}
+
+void MidiPatchGenerator::generateRandomPatch(int* values)
+{
+    for (int i=0; i<num_values_; i++)
+    {
+        values[i] = getRandomSetting(i);
+    }
+}
+
+void MidiPatchGenerator::mutatePatch(const int* source_values, float amount, int* values)
+{
+    amount = jlimit(0.0f, 1.0f, amount);
+    
+    for (int i=0; i<num_values_; i++)
+    {
+        values[i] = constrainValue(i, source_values[i]);
+        
+        if (random_.nextFloat() >= amount)
+        {
+            continue;
+        }
+        
+        if (stepped_[i])
+        {
+            values[i] = getRandomSetting(i);
+        }
+        else
+        {
+            // up to amount of the range either way
+            const float max_offset = amount * (float)(range_maxs_[i] - range_mins_[i]);
+            const float offset = (random_.nextFloat() * 2.0f - 1.0f) * max_offset;
+            
+            values[i] = constrainValue(i, values[i] + roundToInt(offset));
+        }
+    }
+}
+
+void MidiPatchGenerator::crossoverPatches(const int* values_a, const int* values_b, int* values)
+{
+    for (int i=0; i<num_values_; i++)
+    {
+        if (stepped_[i])
+        {
+            values[i] = constrainValue(i, random_.nextBool() ? values_a[i] : values_b[i]);
+        }
+        else
+        {
+            const float position = random_.nextFloat();
+            
+            values[i] = constrainValue(i, values_a[i] + roundToInt(position * (float)(values_b[i] - values_a[i])));
+        }
+    }
+}
+
+bool MidiPatchGenerator::generateBatch(GenerationMode mode,
+                                       int num_patches,
+                                       const String& name_prefix,
+                                       const Array<int>& patch_a,
+                                       const Array<int>& patch_b,
+                                       StringArray& patch_names,
+                                       Array<int>& patch_values)
+{
+    if ((mode != RandomPatches && patch_a.size() != num_values_) ||
+        (mode == CrossoverPatches && patch_b.size() != num_values_))
+    {
+        return false;
+    }
+    
+    const int first_value = patch_values.size();
+    
+    // every patch is generated straight into its place in patch_values
+    patch_values.insertMultiple(first_value, 0, num_patches * num_values_);
+    
+    for (int i=0; i<num_patches; i++)
+    {
+        int* values = patch_values.getRawDataPointer() + first_value + i * num_values_;
+        
+        if (mode == MutatePatch)
+        {
+            mutatePatch(patch_a.begin(), MIDI_DEFAULT_MUTATION_AMOUNT, values);
+        }
+        else if (mode == CrossoverPatches)
+        {
+            crossoverPatches(patch_a.begin(), patch_b.begin(), values);
+        }
+        else
+        {
+            generateRandomPatch(values);
+        }
+        
+        patch_names.add(name_prefix + " " + String(i+1).paddedLeft('0', 3));
+    }
+    
+    return true;
+}
@@ -0,0 +1,84 @@
+//
+//  MidiPatchGenerator.hpp
+//  Midiot
+//
+//  Created by Sean Bratnober on 2/24/18.
+//
+//
+
+#ifndef MidiPatchGenerator_hpp
+#define MidiPatchGenerator_hpp
+
+#include <stdio.h>
+#include "../JuceLibraryCode/JuceHeader.h"
+
+class MidiInstrumentModel;
+
+const int MIDI_GENERATED_PATCHES_PER_BATCH = 128;
+const float MIDI_DEFAULT_MUTATION_AMOUNT = 0.2f;
+
+// Makes new patches for one instrument model. Every value it produces is
+// inside its control's range, and value-mapped controls only ever get one
+// of their mapped values, so any generated patch can be sent as is.
+// The model's layout is copied when the generator is created.
+class MidiPatchGenerator
+{
+public:
+    enum GenerationMode
+    {
+        RandomPatches = 0,
+        MutatePatch,
+        CrossoverPatches
+    };
+    
+    MidiPatchGenerator(MidiInstrumentModel& model);
+    ~MidiPatchGenerator();
+    
+    int getNumValues() const { return num_values_; }
+    uint32 getDefinitionHash() const { return definition_hash_; }
+    
+    static String getGenerationModeName(GenerationMode mode);
+    
+    // values holds getNumValues() ints, by control id
+    void generateRandomPatch(int* values);
+    // amount 0..1: how many controls change, and how far
+    void mutatePatch(const int* source_values, float amount, int* values);
+    // each stepped control comes from one parent, continuous ones land
+    // somewhere between the two
+    void crossoverPatches(const int* values_a, const int* values_b, int* values);
+    
+    // Appends num_patches patches named "<name_prefix> 001" and on to
+    // patch_names and patch_values, laid out for MidiPatchBank::writeBank().
+    // Mutation starts from patch_a; crossover mixes patch_a and patch_b.
+    // False, adding nothing, if a patch the mode needs is missing.
+    bool generateBatch(GenerationMode mode,
+                       int num_patches,
+                       const String& name_prefix,
+                       const Array<int>& patch_a,
+                       const Array<int>& patch_b,
+                       StringArray& patch_names,
+                       Array<int>& patch_values);
+    
+private:
+    int getRandomSetting(int control_id);
+    // clamps to the range, then snaps to the nearest mapped value
+    int constrainValue(int control_id, int value) const;
+    
+    const int num_values_;
+    const uint32 definition_hash_;
+    
+    HeapBlock<int> range_mins_;
+    HeapBlock<int> range_maxs_;
+    HeapBlock<bool> stepped_;
+    
+    // every control's value map back to back; empty maps take no space
+    Array<int> value_maps_;
+    HeapBlock<int> value_map_starts_;
+    HeapBlock<int> value_map_sizes_;
+    
+    Random random_;
+    
+    JUCE_DECLARE_NON_COPYABLE(MidiPatchGenerator)
+};
+
+#endif /* MidiPatchGenerator_hpp */
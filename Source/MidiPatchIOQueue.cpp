@@ -0,0 +1,285 @@
+//
+//  MidiPatchIOQueue.cpp
+//  Midiot
+//
+//  Created by Sean Bratnober on 2/20/18.
+//
+//
+
+#include "MidiPatchIOQueue.hpp"
+#include "MidiPatchLibrary.hpp"
+#include "MidiPatchBank.hpp"
+#include "MidiPatchFile.hpp"
+#include "MidiotFileUtils.hpp"
+
+MidiPatchIOQueue::MidiPatchIOQueue(MidiPatchLibrary& patch_library, Listener* listener)
+: Thread("MidiPatchIOQueue"),
+patch_library_(patch_library),
+listener_(listener)
+{
+    startThread();
+}
+
+MidiPatchIOQueue::~MidiPatchIOQueue()
+{
+    // run() finishes the saves and bank writes still queued before it returns
+    signalThreadShouldExit();
+    notify();
+    stopThread(10000);
+    
+    cancelPendingUpdate();
+}
+
+void MidiPatchIOQueue::loadPatch(const String& patch_name)
+{
+    PatchJob* job = new PatchJob();
+    job->type = LoadJob;
+    job->succeeded = false;
+    job->patch_name = patch_name;
+    
+    addJob(job);
+}
+
+void MidiPatchIOQueue::loadPatchValues(const StringArray& patch_names, MidiInstrumentModel* scratch_model)
+{
+    PatchJob* job = new PatchJob();
+    job->type = ValuesJob;
+    job->succeeded = false;
+    job->patch_names = patch_names;
+    job->scratch_model = scratch_model;
+    
+    addJob(job);
+}
+
+void MidiPatchIOQueue::savePatch(const String& patch_name, const File& patch_file, MemoryBlock& patch_data)
+{
+    PatchJob* job = new PatchJob();
+    job->type = SaveJob;
+    job->succeeded = false;
+    job->patch_name = patch_name;
+    job->patch_file = patch_file;
+    job->patch_data.swapWith(patch_data);
+    
+    addJob(job);
+}
+
+void MidiPatchIOQueue::buildSimilarityIndex(MidiInstrumentModel* scratch_model)
+{
+    PatchJob* job = new PatchJob();
+    job->type = IndexJob;
+    job->succeeded = false;
+    job->scratch_model = scratch_model;
+    
+    {
+        const ScopedLock sl(job_lock_);
+        
+        // the library changed again before the last one started
+        for (int i=pending_jobs_.size(); --i >= 0;)
+        {
+            if (pending_jobs_.getUnchecked(i)->type == IndexJob)
+            {
+                pending_jobs_.remove(i);
+            }
+        }
+    }
+    
+    addJob(job);
+}
+
+void MidiPatchIOQueue::addPatchesToBank(const File& bank_file,
+                                        uint32 definition_hash,
+                                        int num_values,
+                                        StringArray& patch_names,
+                                        Array<int>& patch_values)
+{
+    PatchJob* job = new PatchJob();
+    job->type = BankJob;
+    job->succeeded = false;
+    job->patch_file = bank_file;
+    job->definition_hash = definition_hash;
+    job->num_values = num_values;
+    job->patch_names.swapWith(patch_names);
+    job->patch_values.swapWith(patch_values);
+    
+    addJob(job);
+}
+
+void MidiPatchIOQueue::addJob(PatchJob* job)
+{
+    {
+        const ScopedLock sl(job_lock_);
+        pending_jobs_.add(job);
+    }
+    
+    notify();
+}
+
+void MidiPatchIOQueue::run()
+{
+    for (;;)
+    {
+        ScopedPointer<PatchJob> job;
+        
+        {
+            const ScopedLock sl(job_lock_);
+            job = pending_jobs_.removeAndReturn(0);
+        }
+        
+        if (job == nullptr)
+        {
+            if (threadShouldExit())
+            {
+                return;
+            }
+            
+            wait(-1);
+            continue;
+        }
+        
+        if (job->type == SaveJob)
+        {
+            job->succeeded = MidiotFileUtils::replaceFileAtomically(job->patch_file,
+                                                                    job->patch_data.getData(),
+                                                                    job->patch_data.getSize());
+        }
+        else if (job->type == BankJob)
+        {
+            patch_library_.beginBankWrite();
+            job->succeeded = MidiPatchBank::mergeIntoBank(job->patch_file,
+                                                          job->definition_hash,
+                                                          job->num_values,
+                                                          job->patch_names,
+                                                          job->patch_values);
+            patch_library_.endBankWrite();
+        }
+        else if (threadShouldExit())
+        {
+            // nobody is left to apply it
+            continue;
+        }
+        else if (job->type == LoadJob)
+        {
+            job->succeeded = patch_library_.readPatchData(job->patch_name, job->patch_data);
+        }
+        else if (job->type == ValuesJob)
+        {
+            decodePatchValues(*job);
+        }
+        else
+        {
+            buildIndex(*job);
+        }
+        
+        {
+            const ScopedLock sl(job_lock_);
+            finished_jobs_.add(job.release());
+        }
+        
+        triggerAsyncUpdate();
+    }
+}
+
+void MidiPatchIOQueue::handleAsyncUpdate()
+{
+    OwnedArray<PatchJob> finished_jobs;
+    
+    {
+        const ScopedLock sl(job_lock_);
+        finished_jobs.swapWith(finished_jobs_);
+    }
+    
+    if (!listener_)
+    {
+        return;
+    }
+    
+    for (int i=0; i<finished_jobs.size(); i++)
+    {
+        PatchJob* job = finished_jobs.getUnchecked(i);
+        
+        if (job->type == SaveJob)
+        {
+            listener_->patchSaveFinished(job->patch_name, job->patch_file, job->succeeded);
+        }
+        else if (job->type == LoadJob)
+        {
+            listener_->patchLoadFinished(job->patch_name, job->patch_data, job->succeeded);
+        }
+        else if (job->type == ValuesJob)
+        {
+            listener_->patchValuesFinished(job->patch_names, job->patch_values, job->succeeded);
+        }
+        else if (job->type == BankJob)
+        {
+            listener_->bankWriteFinished(job->patch_file, job->patch_names.size(), job->succeeded);
+        }
+        else if (job->succeeded)
+        {
+            listener_->similarityIndexFinished(job->index.release());
+        }
+    }
+}
+
+void MidiPatchIOQueue::buildIndex(PatchJob& job)
+{
+    MidiControlStore& control_store = job.scratch_model->getControlStore();
+    
+    StringArray patch_names;
+    patch_library_.getPatchNames(patch_names);
+    
+    job.index = new MidiPatchSimilarityIndex(control_store);
+    job.index->ensureStorageAllocated(patch_names.size());
+    
+    // JSON patches may leave controls out; those keep the starting values
+    Array<int> initial_values;
+    control_store.copyValuesTo(initial_values);
+    
+    MemoryBlock patch_data;
+    
+    for (int i=0; i<patch_names.size(); i++)
+    {
+        if (threadShouldExit())
+        {
+            return;
+        }
+        
+        control_store.setValues(initial_values);
+        
+        if (patch_library_.readPatchData(patch_names[i], patch_data) &&
+            MidiPatchFile::decodePatch(patch_data, *job.scratch_model))
+        {
+            job.index->addPatch(patch_names[i], control_store.values());
+        }
+    }
+    
+    job.succeeded = true;
+}
+
+void MidiPatchIOQueue::decodePatchValues(PatchJob& job)
+{
+    MidiControlStore& control_store = job.scratch_model->getControlStore();
+    const int num_values = control_store.size();
+    
+    // JSON patches may leave controls out; those keep the starting values
+    Array<int> initial_values;
+    control_store.copyValuesTo(initial_values);
+    
+    job.patch_values.ensureStorageAllocated(job.patch_names.size() * num_values);
+    
+    MemoryBlock patch_data;
+    
+    for (int i=0; i<job.patch_names.size(); i++)
+    {
+        control_store.setValues(initial_values);
+        
+        if (!patch_library_.readPatchData(job.patch_names[i], patch_data) ||
+            !MidiPatchFile::decodePatch(patch_data, *job.scratch_model))
+        {
+            return;
+        }
+        
+        job.patch_values.addArray(control_store.values(), num_values);
+    }
+    
+    job.succeeded = true;
+}
@@ -0,0 +1,116 @@
+//
+//  MidiPatchIOQueue.hpp
+//  Midiot
+//
+//  Created by Sean Bratnober on 2/20/18.
+//
+//
+
+#ifndef MidiPatchIOQueue_hpp
+#define MidiPatchIOQueue_hpp
+
+#include <stdio.h>
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "MidiInstrumentModel.hpp"
+#include "MidiPatchSimilarityIndex.hpp"
+
+class MidiPatchLibrary;
+
+// Runs patch file reads and writes on a background thread, in the order
+// they were queued, so a slow or network-mounted disk never stalls the
+// UI. The queue never touches a live model: saves take data already
+// encoded with MidiPatchFile::encodePatch(), loads hand back the stored
+// data for MidiPatchFile::decodePatch(), and value loads decode into a
+// scratch model. Results reach the listener on the message thread.
+class MidiPatchIOQueue : private Thread,
+                         private AsyncUpdater
+{
+public:
+    class Listener
+    {
+    public:
+        virtual ~Listener() {}
+        
+        virtual void patchLoadFinished(const String& patch_name,
+                                       const MemoryBlock& patch_data,
+                                       bool succeeded) = 0;
+        virtual void patchValuesFinished(const StringArray& patch_names,
+                                         const Array<int>& patch_values,
+                                         bool succeeded) = 0;
+        virtual void patchSaveFinished(const String& patch_name,
+                                       const File& patch_file,
+                                       bool succeeded) = 0;
+        // the listener takes ownership of index
+        virtual void similarityIndexFinished(MidiPatchSimilarityIndex* index) = 0;
+        virtual void bankWriteFinished(const File& bank_file,
+                                       int num_patches,
+                                       bool succeeded) = 0;
+    };
+    
+    MidiPatchIOQueue(MidiPatchLibrary& patch_library, Listener* listener);
+    // Waits for queued writes to finish; queued reads are dropped.
+    ~MidiPatchIOQueue();
+    
+    void loadPatch(const String& patch_name);
+    // Reads and decodes patches into scratch_model, which the queue takes
+    // ownership of, and hands back their values by control id, one run of
+    // values per patch. Fails if any of the patches can't be loaded.
+    void loadPatchValues(const StringArray& patch_names, MidiInstrumentModel* scratch_model);
+    // takes the contents of patch_data
+    void savePatch(const String& patch_name, const File& patch_file, MemoryBlock& patch_data);
+    // Indexes every patch in the library, decoding each one into
+    // scratch_model (see MidiInstrumentModel::createScratchCopy()), which
+    // the queue takes ownership of. Replaces an index job still waiting.
+    void buildSimilarityIndex(MidiInstrumentModel* scratch_model);
+    // Merges patches into a bank with MidiPatchBank::mergeIntoBank(),
+    // with the library's mapping of the bank released for the write;
+    // takes the contents of patch_names and patch_values.
+    void addPatchesToBank(const File& bank_file,
+                          uint32 definition_hash,
+                          int num_values,
+                          StringArray& patch_names,
+                          Array<int>& patch_values);
+    
+private:
+    enum PatchJobType
+    {
+        LoadJob = 0,
+        ValuesJob,
+        SaveJob,
+        IndexJob,
+        BankJob
+    };
+    
+    struct PatchJob
+    {
+        PatchJobType type;
+        bool succeeded;
+        String patch_name;
+        File patch_file;
+        MemoryBlock patch_data;
+        ScopedPointer<MidiInstrumentModel> scratch_model;
+        ScopedPointer<MidiPatchSimilarityIndex> index;
+        // bank and values jobs
+        uint32 definition_hash;
+        int num_values;
+        StringArray patch_names;
+        Array<int> patch_values;
+    };
+    
+    void run() override;
+    void buildIndex(PatchJob& job);
+    void decodePatchValues(PatchJob& job);
+    void handleAsyncUpdate() override;
+    void addJob(PatchJob* job);
+    
+    MidiPatchLibrary& patch_library_;
+    Listener* listener_;
+    
+    CriticalSection job_lock_;
+    OwnedArray<PatchJob> pending_jobs_;
+    OwnedArray<PatchJob> finished_jobs_;
+    
+    JUCE_DECLARE_NON_COPYABLE(MidiPatchIOQueue)
+};
+
+#endif /* MidiPatchIOQueue_hpp */
@@ -0,0 +1,285 @@
+//
+//  MidiPatchLibrary.cpp
+//  Midiot
+//
+//  Created by Sean Bratnober on 2/12/18.
+//
+//
+
+#include "MidiPatchLibrary.hpp"
+#include "MidiotFileUtils.hpp"
+#include "MidiPatchFile.hpp"
+
+MidiPatchLibrary::MidiPatchLibrary(const String manufacturer, const String model_name)
+: Thread("MidiPatchLibrary"),
+manufacturer_(manufacturer),
+model_name_(model_name),
+patch_folder_(MidiotFileUtils::getInstrumentPatchFolder(manufacturer, model_name)),
+bank_file_(MidiotFileUtils::getInstrumentBankFile(manufacturer, model_name)),
+bank_modification_time_(0)
+{
+    startThread(3);
+}
+
+MidiPatchLibrary::~MidiPatchLibrary()
+{
+    stopThread(4000);
+}
+
+void MidiPatchLibrary::getPatchNames(StringArray& patch_names)
+{
+    const ScopedLock sl(index_lock_);
+    
+    patch_names.clear();
+    patch_names.ensureStorageAllocated(patch_entries_.size());
+    
+    for (int i=0; i<patch_entries_.size(); i++)
+    {
+        patch_names.add(patch_entries_.getReference(i).name);
+    }
+}
+
+int MidiPatchLibrary::getNumPatches()
+{
+    const ScopedLock sl(index_lock_);
+    return patch_entries_.size();
+}
+
+bool MidiPatchLibrary::containsPatch(const String& patch_name)
+{
+    const ScopedLock sl(index_lock_);
+    return patch_name_index_.contains(patch_name);
+}
+
+File MidiPatchLibrary::getPatchFile(const String& patch_name)
+{
+    const ScopedLock sl(index_lock_);
+    
+    if (!patch_name_index_.contains(patch_name))
+    {
+        return File();
+    }
+    
+    return patch_entries_.getReference(patch_name_index_[patch_name]).file;
+}
+
+bool MidiPatchLibrary::readPatchData(const String& patch_name, MemoryBlock& patch_data)
+{
+    File patch_file;
+    
+    {
+        const ScopedLock sl(index_lock_);
+        
+        if (!patch_name_index_.contains(patch_name))
+        {
+            return false;
+        }
+        
+        const PatchEntry& entry = patch_entries_.getReference(patch_name_index_[patch_name]);
+        
+        if (entry.bank_record >= 0)
+        {
+            const uint8* value_data = bank_ ? bank_->getPatchValueData(entry.bank_record) : NULL;
+            
+            if (value_data == NULL)
+            {
+                return false;
+            }
+            
+            const int num_values = bank_->getNumValues();
+            HeapBlock<int> values((size_t)jmax(1, num_values));
+            
+            for (int i=0; i<num_values; i++)
+            {
+                values[i] = (int)ByteOrder::littleEndianInt(value_data + i * 4);
+            }
+            
+            return MidiPatchFile::writeBinaryPatch(patch_data,
+                                                   patch_name,
+                                                   bank_->getDefinitionHash(),
+                                                   values,
+                                                   num_values);
+        }
+        
+        patch_file = entry.file;
+    }
+    
+    // outside the lock, so a slow disk doesn't hold up the patch menu
+    return patch_file.loadFileAsData(patch_data);
+}
+
+void MidiPatchLibrary::addPatchFile(const File& patch_file)
+{
+    PatchEntry entry;
+    entry.name = patch_file.getFileNameWithoutExtension();
+    entry.file = patch_file;
+    entry.modification_time = patch_file.getLastModificationTime().toMilliseconds();
+    entry.bank_record = -1;
+    
+    const ScopedLock sl(index_lock_);
+    
+    if (patch_name_index_.contains(entry.name))
+    {
+        patch_entries_.set(patch_name_index_[entry.name], entry);
+        return;
+    }
+    
+    PatchEntryComparator comparator;
+    patch_entries_.addSorted(comparator, entry);
+    rebuildNameIndex();
+}
+
+void MidiPatchLibrary::beginBankWrite()
+{
+    bank_write_lock_.enter();
+    // remapped on the next scan whether or not the write succeeds
+    bank_modification_time_ = 0;
+    
+    const ScopedLock sl(index_lock_);
+    bank_ = nullptr;
+}
+
+void MidiPatchLibrary::endBankWrite()
+{
+    bank_write_lock_.exit();
+    rescanNow();
+}
+
+void MidiPatchLibrary::run()
+{
+    while (!threadShouldExit())
+    {
+        if (scanPatchFolder())
+        {
+            sendChangeMessage();
+        }
+        
+        wait(MIDI_PATCH_LIBRARY_POLL_MS);
+    }
+}
+
+bool MidiPatchLibrary::scanPatchFolder()
+{
+    Array<PatchEntry> scanned_entries;
+    
+    {
+        const ScopedLock sl(index_lock_);
+        scanned_entries.ensureStorageAllocated(patch_entries_.size());
+    }
+    
+    DirectoryIterator patch_iter(patch_folder_,
+                                 true,
+                                 MidiotFileUtils::getPatchFileWildcard(),
+                                 File::findFiles);
+    
+    while (patch_iter.next())
+    {
+        if (threadShouldExit())
+        {
+            return false;
+        }
+        
+        PatchEntry entry;
+        entry.file = patch_iter.getFile();
+        entry.name = entry.file.getFileNameWithoutExtension();
+        entry.modification_time = entry.file.getLastModificationTime().toMilliseconds();
+        entry.bank_record = -1;
+        scanned_entries.add(entry);
+    }
+    
+    // waits out a bank write rather than mapping a half-replaced file
+    const ScopedLock bank_sl(bank_write_lock_);
+    
+    // the bank is remapped only when the file itself changed
+    ScopedPointer<MidiPatchBank> new_bank;
+    const int64 bank_modification_time = bank_file_.existsAsFile()
+                                       ? bank_file_.getLastModificationTime().toMilliseconds()
+                                       : 0;
+    
+    if (bank_modification_time != bank_modification_time_)
+    {
+        new_bank = new MidiPatchBank(bank_file_);
+        bank_modification_time_ = bank_modification_time;
+    }
+    
+    {
+        const ScopedLock sl(index_lock_);
+        
+        MidiPatchBank* bank = new_bank ? new_bank.get() : bank_.get();
+        
+        if (bank && bank->isValid())
+        {
+            for (int i=0; i<bank->getNumPatches(); i++)
+            {
+                PatchEntry entry;
+                entry.name = bank->getPatchName(i);
+                entry.file = bank_file_;
+                entry.modification_time = bank_modification_time;
+                entry.bank_record = i;
+                scanned_entries.add(entry);
+            }
+        }
+    }
+    
+    PatchEntryComparator comparator;
+    scanned_entries.sort(comparator, true);
+    
+    // a patch saved in several places shows up once, from the best source
+    for (int i=scanned_entries.size()-1; i>0; i--)
+    {
+        const PatchEntry& entry = scanned_entries.getReference(i);
+        const PatchEntry& previous = scanned_entries.getReference(i-1);
+        
+        if (entry.name == previous.name)
+        {
+            scanned_entries.remove(getEntryPriority(entry) > getEntryPriority(previous) ? i-1 : i);
+        }
+    }
+    
+    const ScopedLock sl(index_lock_);
+    
+    if (new_bank)
+    {
+        bank_ = new_bank.release();
+    }
+    
+    bool changed = (scanned_entries.size() != patch_entries_.size());
+    
+    for (int i=0; !changed && i<scanned_entries.size(); i++)
+    {
+        const PatchEntry& scanned = scanned_entries.getReference(i);
+        const PatchEntry& indexed = patch_entries_.getReference(i);
+        
+        changed = (scanned.file != indexed.file ||
+                   scanned.modification_time != indexed.modification_time ||
+                   scanned.bank_record != indexed.bank_record);
+    }
+    
+    if (changed)
+    {
+        patch_entries_.swapWith(scanned_entries);
+        rebuildNameIndex();
+    }
+    
+    return changed;
+}
+
+void MidiPatchLibrary::rebuildNameIndex()
+{
+    patch_name_index_.clear();
+    
+    for (int i=0; i<patch_entries_.size(); i++)
+    {
+        patch_name_index_.set(patch_entries_.getReference(i).name, i);
+    }
+}
+
+int MidiPatchLibrary::getEntryPriority(const PatchEntry& entry)
+{
+    if (entry.bank_record >= 0)
+    {
+        return 0;
+    }
+    
+    return MidiPatchFile::isBinaryPatchFile(entry.file) ? 2 : 1;
+}
@@ -0,0 +1,108 @@
+//
+//  MidiPatchLibrary.hpp
+//  Midiot
+//
+//  Created by Sean Bratnober on 2/12/18.
+//
+//
+
+#ifndef MidiPatchLibrary_hpp
+#define MidiPatchLibrary_hpp
+
+#include <stdio.h>
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "MidiPatchBank.hpp"
+
+const int MIDI_PATCH_LIBRARY_POLL_MS = 2000;
+
+// In-memory index of the patches saved for one instrument model, both
+// loose patch files and the records of the model's bank file. The folder
+// is scanned once on a background thread and then polled for changes;
+// listeners get a change message (on the message thread) only when the
+// set of patches actually changed. A loose file wins over a bank record
+// with the same name.
+class MidiPatchLibrary : public ChangeBroadcaster,
+                         private Thread
+{
+public:
+    MidiPatchLibrary(const String manufacturer, const String model_name);
+    ~MidiPatchLibrary();
+    
+    const String& manufacturer() const { return manufacturer_; }
+    const String& model_name() const { return model_name_; }
+    
+    // patch names without extension, sorted
+    void getPatchNames(StringArray& patch_names);
+    int getNumPatches();
+    
+    bool containsPatch(const String& patch_name);
+    // File() if there is no such patch; the bank file for bank records
+    File getPatchFile(const String& patch_name);
+    
+    // The patch as stored, for MidiPatchFile::decodePatch(); bank records
+    // come back in the binary patch format. Doesn't touch any model, so
+    // it is safe to call from a worker thread.
+    bool readPatchData(const String& patch_name, MemoryBlock& patch_data);
+    
+    // Indexes a patch the app just wrote, without waiting for the next
+    // poll. Listeners aren't notified; the caller refreshes its own view.
+    void addPatchFile(const File& patch_file);
+    
+    void rescanNow() { notify(); }
+    
+    // Windows can't replace a file that is mapped, so whoever rewrites the
+    // bank unmaps the library's view first. The scan thread leaves the
+    // bank alone until endBankWrite(), which maps the new one; bank records
+    // don't load in between.
+    void beginBankWrite();
+    void endBankWrite();
+    
+private:
+    struct PatchEntry
+    {
+        String name;
+        File file;
+        int64 modification_time;
+        // -1 for a loose patch file
+        int bank_record;
+    };
+    
+    struct PatchEntryComparator
+    {
+        static int compareElements(const PatchEntry& first, const PatchEntry& second)
+        {
+            const int result = first.name.compareNatural(second.name);
+            
+            // names differing only in case still sort apart, so the
+            // duplicates the scan removes are always next to each other
+            return (result != 0) ? result : first.name.compare(second.name);
+        }
+    };
+    
+    void run() override;
+    
+    // returns true and swaps in the new index if anything changed
+    bool scanPatchFolder();
+    void rebuildNameIndex();
+    
+    static int getEntryPriority(const PatchEntry& entry);
+    
+    const String manufacturer_;
+    const String model_name_;
+    const File patch_folder_;
+    const File bank_file_;
+    
+    // held by the scan thread while it maps the bank and by a bank writer
+    // from beginBankWrite() to endBankWrite()
+    CriticalSection bank_write_lock_;
+    int64 bank_modification_time_;
+    
+    CriticalSection index_lock_;
+    Array<PatchEntry> patch_entries_;
+    HashMap<String, int> patch_name_index_;
+    ScopedPointer<MidiPatchBank> bank_;
+    
+    JUCE_DECLARE_NON_COPYABLE(MidiPatchLibrary)
+};
+
+#endif /* MidiPatchLibrary_hpp */
@@ -0,0 +1,184 @@
+//
+//  MidiPatchMorpher.cpp
+//  Midiot
+//
+//  Created by Sean Bratnober on 2/18/18.
+//
+//
+
+#include "MidiPatchMorpher.hpp"
+#include "MidiInstrumentModel.hpp"
+#include "MidiInstrumentControllerComponent.hpp"
+
+MidiPatchMorpher::MidiPatchMorpher(MidiInstrumentModel* model,
+                                   MidiInstrumentControllerComponent* controller_component)
+: Thread("MidiPatchMorpher"),
+model_(model),
+controller_component_(controller_component),
+num_values_(model->getNumMidiControls()),
+values_a_((size_t)jmax(1, num_values_), true),
+values_b_((size_t)jmax(1, num_values_), true),
+stepped_((size_t)jmax(1, num_values_), true),
+has_patches_(false),
+position_(0),
+update_interval_ms_(1000 / MIDI_MORPH_DEFAULT_UPDATE_HZ),
+applied_position_(-1),
+target_values_((size_t)jmax(1, num_values_), true),
+pending_values_((size_t)jmax(1, num_values_), true),
+has_pending_values_(false),
+step_values_((size_t)jmax(1, num_values_), true)
+{
+    for (int i=0; i<num_values_; i++)
+    {
+        stepped_[i] = model_->isSteppedControl(i);
+    }
+}
+
+MidiPatchMorpher::~MidiPatchMorpher()
+{
+    stopThread(1000);
+    cancelPendingUpdate();
+}
+
+void MidiPatchMorpher::setPatches(const Array<int>& patch_a, const Array<int>& patch_b)
+{
+    stopMorphing();
+    
+    const MidiControlStore& control_store = model_->getControlStore();
+    
+    for (int i=0; i<num_values_; i++)
+    {
+        values_a_[i] = isPositiveAndBelow(i, patch_a.size()) ? patch_a.getUnchecked(i) : control_store.value(i);
+        values_b_[i] = isPositiveAndBelow(i, patch_b.size()) ? patch_b.getUnchecked(i) : control_store.value(i);
+    }
+    
+    has_patches_ = true;
+}
+
+bool MidiPatchMorpher::getPatches(Array<int>& patch_a, Array<int>& patch_b) const
+{
+    if (!has_patches_)
+    {
+        return false;
+    }
+    
+    // only written by setPatches(), which stops the morph thread first
+    patch_a.clearQuick();
+    patch_a.addArray(values_a_.getData(), num_values_);
+    patch_b.clearQuick();
+    patch_b.addArray(values_b_.getData(), num_values_);
+    
+    return true;
+}
+
+void MidiPatchMorpher::startMorphing()
+{
+    // force the first step to send wherever the position is now
+    applied_position_ = -1;
+    startThread(6);
+}
+
+void MidiPatchMorpher::stopMorphing()
+{
+    stopThread(1000);
+    
+    // the last step still goes out
+    handleUpdateNowIfNeeded();
+}
+
+void MidiPatchMorpher::setMorphPosition(float position)
+{
+    position_.set(roundToInt(jlimit(0.0f, 1.0f, position) * MIDI_MORPH_POSITION_MAX));
+}
+
+void MidiPatchMorpher::setUpdateRate(int updates_per_second)
+{
+    update_interval_ms_.set(1000 / jlimit(1, 1000, updates_per_second));
+}
+
+void MidiPatchMorpher::run()
+{
+    while (!threadShouldExit())
+    {
+        const int position = position_.get();
+        
+        if (position != applied_position_)
+        {
+            computeMorphValues(position);
+            applied_position_ = position;
+        }
+        
+        // fader moves between steps collapse into the next one
+        wait(update_interval_ms_.get());
+    }
+}
+
+void MidiPatchMorpher::computeMorphValues(int position)
+{
+    const bool past_midpoint = (position * 2 >= MIDI_MORPH_POSITION_MAX);
+    
+    for (int i=0; i<num_values_; i++)
+    {
+        const int value_a = values_a_[i];
+        const int value_b = values_b_[i];
+        int target_value = value_a;
+        
+        if (value_a != value_b)
+        {
+            if (stepped_[i])
+            {
+                target_value = past_midpoint ? value_b : value_a;
+            }
+            else
+            {
+                target_value = value_a + (int)(((int64)(value_b - value_a) * position + MIDI_MORPH_POSITION_MAX / 2)
+                                               / MIDI_MORPH_POSITION_MAX);
+            }
+        }
+        
+        target_values_[i] = target_value;
+    }
+    
+    {
+        const ScopedLock sl(pending_lock_);
+        
+        memcpy(pending_values_.getData(), target_values_.getData(), (size_t)num_values_ * sizeof(int));
+        has_pending_values_ = true;
+    }
+    
+    // steps the message thread hasn't got to yet collapse into this one
+    triggerAsyncUpdate();
+}
+
+void MidiPatchMorpher::handleAsyncUpdate()
+{
+    {
+        const ScopedLock sl(pending_lock_);
+        
+        if (!has_pending_values_)
+        {
+            return;
+        }
+        
+        memcpy(step_values_.getData(), pending_values_.getData(), (size_t)num_values_ * sizeof(int));
+        has_pending_values_ = false;
+    }
+    
+    MidiControlStore& control_store = model_->getControlStore();
+    bool controls_changed = false;
+    
+    for (int i=0; i<num_values_; i++)
+    {
+        if (step_values_[i] != control_store.value(i))
+        {
+            control_store.set_value(i, step_values_[i]);
+            model_->getMidiControl(i)->send_value_to_midi();
+            controls_changed = true;
+        }
+    }
+    
+    if (controls_changed && controller_component_)
+    {
+        controller_component_->requestMidiControlResync();
+    }
+}
@@ -0,0 +1,86 @@
+//
+//  MidiPatchMorpher.hpp
+//  Midiot
+//
+//  Created by Sean Bratnober on 2/18/18.
+//
+//
+
+#ifndef MidiPatchMorpher_hpp
+#define MidiPatchMorpher_hpp
+
+#include <stdio.h>
+#include "../JuceLibraryCode/JuceHeader.h"
+
+class MidiInstrumentModel;
+class MidiInstrumentControllerComponent;
+
+const int MIDI_MORPH_POSITION_MAX = 16383;
+const int MIDI_MORPH_DEFAULT_UPDATE_HZ = 50;
+// mod wheel
+const int MIDI_MORPH_DEFAULT_CC = 1;
+
+// Moves an instrument between two patches. Continuous controls are
+// interpolated, stepped ones switch at the midpoint, and only controls
+// whose value actually changes are sent. Steps are worked out on the
+// morpher's own thread at a fixed rate, from buffers allocated when it's
+// created, so a fader can move the position as fast as it likes; the
+// latest step is handed to the message thread, which is the only one that
+// writes it into the control store and sends it.
+class MidiPatchMorpher : private Thread,
+                         private AsyncUpdater
+{
+public:
+    MidiPatchMorpher(MidiInstrumentModel* model,
+                     MidiInstrumentControllerComponent* controller_component);
+    ~MidiPatchMorpher();
+    
+    // Message thread. Stops a running morph; patch_a and patch_b are
+    // values by control id.
+    void setPatches(const Array<int>& patch_a, const Array<int>& patch_b);
+    // Message thread. The values from setPatches(), whether or not a morph
+    // is running; false before the first setPatches().
+    bool getPatches(Array<int>& patch_a, Array<int>& patch_b) const;
+    
+    void startMorphing();
+    void stopMorphing();
+    bool isMorphing() const { return isThreadRunning(); }
+    
+    // any thread, 0 is patch A and 1 is patch B
+    void setMorphPosition(float position);
+    float getMorphPosition() const { return position_.get() / (float)MIDI_MORPH_POSITION_MAX; }
+    
+    void setUpdateRate(int updates_per_second);
+    
+private:
+    void run() override;
+    void computeMorphValues(int position);
+    // message thread, writes and sends the latest computed step
+    void handleAsyncUpdate() override;
+    
+    MidiInstrumentModel* model_;
+    MidiInstrumentControllerComponent* controller_component_;
+    
+    const int num_values_;
+    HeapBlock<int> values_a_;
+    HeapBlock<int> values_b_;
+    HeapBlock<bool> stepped_;
+    bool has_patches_;
+    
+    Atomic<int> position_;
+    Atomic<int> update_interval_ms_;
+    // morph thread only
+    int applied_position_;
+    HeapBlock<int> target_values_;
+    
+    // the latest step, waiting for the message thread
+    CriticalSection pending_lock_;
+    HeapBlock<int> pending_values_;
+    bool has_pending_values_;
+    // message thread only
+    HeapBlock<int> step_values_;
+    
+    JUCE_DECLARE_NON_COPYABLE(MidiPatchMorpher)
+};
+
+#endif /* MidiPatchMorpher_hpp */
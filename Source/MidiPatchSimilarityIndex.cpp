@@ -0,0 +1,169 @@
+//
+//  MidiPatchSimilarityIndex.cpp
+//  Midiot
+//
+//  Created by Sean Bratnober on 2/22/18.
+//
+//
+
+#include "MidiPatchSimilarityIndex.hpp"
+#include "MidiControlStore.hpp"
+
+// a row is given up on once it is already further than the worst kept
+// match; checked every this many values
+const int MIDI_SIMILARITY_EARLY_EXIT_VALUES = 32;
+
+MidiPatchSimilarityIndex::MidiPatchSimilarityIndex(const MidiControlStore& control_store)
+: num_values_(control_store.size()),
+stride_((control_store.size() + 3) & ~3),
+range_mins_((size_t)jmax(4, stride_), true),
+range_scales_((size_t)jmax(4, stride_), true),
+num_allocated_(0)
+{
+    for (int i=0; i<num_values_; i++)
+    {
+        const int range = control_store.range_max(i) - control_store.range_min(i);
+        
+        range_mins_[i] = (float)control_store.range_min(i);
+        range_scales_[i] = (range > 0) ? 1.0f / (float)range : 0.0f;
+    }
+}
+
+MidiPatchSimilarityIndex::~MidiPatchSimilarityIndex()
+{
+}
+
+void MidiPatchSimilarityIndex::ensureStorageAllocated(int num_patches)
+{
+    if (num_patches <= num_allocated_)
+    {
+        return;
+    }
+    
+    vectors_.realloc((size_t)num_patches * (size_t)jmax(4, stride_));
+    num_allocated_ = num_patches;
+}
+
+void MidiPatchSimilarityIndex::normalizeValues(const int* values, float* vector) const
+{
+    for (int i=0; i<num_values_; i++)
+    {
+        vector[i] = ((float)values[i] - range_mins_[i]) * range_scales_[i];
+    }
+    
+    // padding lanes are zero in every row, so they never add distance
+    for (int i=num_values_; i<stride_; i++)
+    {
+        vector[i] = 0.0f;
+    }
+}
+
+void MidiPatchSimilarityIndex::addPatch(const String& patch_name, const int* values)
+{
+    const int patch_index = patch_names_.size();
+    
+    if (patch_index >= num_allocated_)
+    {
+        ensureStorageAllocated(jmax(64, num_allocated_ * 2));
+    }
+    
+    normalizeValues(values, vectors_ + (size_t)patch_index * stride_);
+    patch_names_.add(patch_name);
+}
+
+// Squared L2 distance in four independent lanes, so the compiler can keep
+// them in one SIMD register. Stops early once the row can't make the cut.
+static float squaredDistance(const float* a, const float* b, int stride, float give_up_distance)
+{
+    float sum0 = 0.0f;
+    float sum1 = 0.0f;
+    float sum2 = 0.0f;
+    float sum3 = 0.0f;
+    
+    for (int block_start=0; block_start<stride; block_start+=MIDI_SIMILARITY_EARLY_EXIT_VALUES)
+    {
+        const int block_end = jmin(stride, block_start + MIDI_SIMILARITY_EARLY_EXIT_VALUES);
+        
+        for (int i=block_start; i<block_end; i+=4)
+        {
+            const float d0 = a[i] - b[i];
+            const float d1 = a[i+1] - b[i+1];
+            const float d2 = a[i+2] - b[i+2];
+            const float d3 = a[i+3] - b[i+3];
+            
+            sum0 += d0 * d0;
+            sum1 += d1 * d1;
+            sum2 += d2 * d2;
+            sum3 += d3 * d3;
+        }
+        
+        if ((sum0 + sum1) + (sum2 + sum3) > give_up_distance)
+        {
+            break;
+        }
+    }
+    
+    return (sum0 + sum1) + (sum2 + sum3);
+}
+
+void MidiPatchSimilarityIndex::findNearestPatches(const int* values,
+                                                  int max_results,
+                                                  StringArray& patch_names,
+                                                  const String& exclude_name) const
+{
+    patch_names.clearQuick();
+    max_results = jlimit(0, MIDI_SIMILAR_PATCHES_MAX, max_results);
+    
+    if (max_results == 0 || patch_names_.size() == 0)
+    {
+        return;
+    }
+    
+    HeapBlock<float> query((size_t)jmax(4, stride_));
+    normalizeValues(values, query);
+    
+    // the closest so far, nearest first
+    float best_distances[MIDI_SIMILAR_PATCHES_MAX];
+    int best_patches[MIDI_SIMILAR_PATCHES_MAX];
+    int num_best = 0;
+    
+    for (int patch_index=0; patch_index<patch_names_.size(); patch_index++)
+    {
+        const float give_up_distance = (num_best == max_results)
+                                        ? best_distances[num_best-1]
+                                        : std::numeric_limits<float>::max();
+        
+        const float distance = squaredDistance(query,
+                                               vectors_ + (size_t)patch_index * stride_,
+                                               stride_,
+                                               give_up_distance);
+        
+        if (distance >= give_up_distance)
+        {
+            continue;
+        }
+        
+        if (exclude_name.isNotEmpty() && patch_names_[patch_index] == exclude_name)
+        {
+            continue;
+        }
+        
+        int insert_index = jmin(num_best, max_results - 1);
+        
+        while (insert_index > 0 && best_distances[insert_index-1] > distance)
+        {
+            best_distances[insert_index] = best_distances[insert_index-1];
+            best_patches[insert_index] = best_patches[insert_index-1];
+            insert_index--;
+        }
+        
+        best_distances[insert_index] = distance;
+        best_patches[insert_index] = patch_index;
+        num_best = jmin(num_best + 1, max_results);
+    }
+    
+    for (int i=0; i<num_best; i++)
+    {
+        patch_names.add(patch_names_[best_patches[i]]);
+    }
+}
@@ -0,0 +1,61 @@
+//
+//  MidiPatchSimilarityIndex.hpp
+//  Midiot
+//
+//  Created by Sean Bratnober on 2/22/18.
+//
+//
+
+#ifndef MidiPatchSimilarityIndex_hpp
+#define MidiPatchSimilarityIndex_hpp
+
+#include <stdio.h>
+#include "../JuceLibraryCode/JuceHeader.h"
+
+class MidiControlStore;
+
+const int MIDI_SIMILAR_PATCHES_MAX = 16;
+
+// Nearest-neighbour search over patches as points in control space. Each
+// control is scaled to 0..1 over its range, and every patch is one row of
+// a single float block, padded to a multiple of four values so the
+// distance kernel runs four lanes at a time with no tail.
+//
+// Built once, off the message thread, then only read.
+class MidiPatchSimilarityIndex
+{
+public:
+    // takes the ranges from control_store; patches must match its layout
+    MidiPatchSimilarityIndex(const MidiControlStore& control_store);
+    ~MidiPatchSimilarityIndex();
+    
+    void ensureStorageAllocated(int num_patches);
+    void addPatch(const String& patch_name, const int* values);
+    
+    int getNumPatches() const { return patch_names_.size(); }
+    const String& getPatchName(int patch_index) const { return patch_names_[patch_index]; }
+    
+    // Closest patches first, up to max_results, leaving out exclude_name.
+    // values are raw control values, by control id.
+    void findNearestPatches(const int* values,
+                            int max_results,
+                            StringArray& patch_names,
+                            const String& exclude_name = String()) const;
+    
+private:
+    void normalizeValues(const int* values, float* vector) const;
+    
+    const int num_values_;
+    // num_values_ rounded up to a multiple of 4
+    const int stride_;
+    HeapBlock<float> range_mins_;
+    HeapBlock<float> range_scales_;
+    
+    HeapBlock<float> vectors_;
+    int num_allocated_;
+    StringArray patch_names_;
+    
+    JUCE_DECLARE_NON_COPYABLE(MidiPatchSimilarityIndex)
+};
+
+#endif /* MidiPatchSimilarityIndex_hpp */
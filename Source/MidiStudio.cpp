@@ -26,14 +26,14 @@ MidiStudio* create_test_studio(MidiInstrumentControllerComponent* controller)
     MidiStudio* midi_studio = new MidiStudio();
     MidiInterface* midi_interface = midi_studio->getMidiInterface();
 #if USE_REFACE_CS
-    YamahaRefaceCSModel* yamaha_cs_model = new YamahaRefaceCSModel();
+    MidiInstrumentModel* yamaha_cs_model = createMidiInstrumentModel("Yamaha", "Reface CS");
     MidiInstrument* yamaha_cs_inst = new MidiInstrument(
                                         yamaha_cs_model,
                                         controller,
                                         midi_interface->getMidiInputPort("reface CS"),
                                         midi_interface->getMidiOutputPort("reface CS"));
 #else
-    YamahaRefaceDXModel* yamaha_dx_model = new YamahaRefaceDXModel();
+    MidiInstrumentModel* yamaha_dx_model = createMidiInstrumentModel("Yamaha", "Reface DX");
     MidiInstrument* yamaha_dx_inst = new MidiInstrument(
                                                         yamaha_dx_model,
                                                         controller,
@@ -0,0 +1,140 @@
+//
+//  MidiSysexAssembler.cpp
+//  Midiot
+//
+//  Created by Sean Bratnober on 2/10/18.
+//
+//
+
+#include "MidiSysexAssembler.hpp"
+
+MidiSysexAssembler::MidiSysexAssembler(int max_bytes, int timeout_ms)
+: buffer_((size_t)jmax(2, max_bytes)),
+max_bytes_(jmax(2, max_bytes)),
+timeout_seconds_(timeout_ms * 0.001),
+num_bytes_(0),
+num_bytes_received_(0),
+start_timestamp_(0),
+last_timestamp_(0),
+complete_(false),
+discarding_(false),
+num_dropped_(0)
+{
+}
+
+MidiSysexAssembler::~MidiSysexAssembler()
+{
+}
+
+void MidiSysexAssembler::reset()
+{
+    num_bytes_ = 0;
+    num_bytes_received_ = 0;
+    complete_ = false;
+    discarding_ = false;
+}
+
+bool MidiSysexAssembler::addData(const uint8* data, int num_bytes, double timestamp)
+{
+    if (num_bytes <= 0)
+    {
+        return false;
+    }
+    
+    if (complete_)
+    {
+        reset();
+    }
+    
+    if (isAssembling() && timestamp - last_timestamp_ > timeout_seconds_)
+    {
+        // the rest of the last message is never coming
+        if (!discarding_)
+        {
+            num_dropped_++;
+        }
+        
+        reset();
+    }
+    
+    last_timestamp_ = timestamp;
+    
+    if (data[0] == 0xF0)
+    {
+        if (isAssembling() && num_bytes > num_bytes_received_)
+        {
+            // the callback hands over everything so far; only look at what's new
+            return appendBytes(data + num_bytes_received_, num_bytes - num_bytes_received_);
+        }
+        
+        if (isAssembling() && !discarding_)
+        {
+            num_dropped_++;
+        }
+        
+        reset();
+        start_timestamp_ = timestamp;
+        
+        return appendBytes(data, num_bytes);
+    }
+    
+    if (!isAssembling())
+    {
+        // a continuation without its start
+        return false;
+    }
+    
+    return appendBytes(data, num_bytes);
+}
+
+bool MidiSysexAssembler::appendBytes(const uint8* data, int num_bytes)
+{
+    for (int i=0; i<num_bytes; i++)
+    {
+        const uint8 byte = data[i];
+        num_bytes_received_++;
+        
+        if (discarding_)
+        {
+            if (byte == 0xF7)
+            {
+                reset();
+                return false;
+            }
+            
+            continue;
+        }
+        
+        if (num_bytes_ == max_bytes_)
+        {
+            num_dropped_++;
+            num_bytes_ = 0;
+            
+            if (byte == 0xF7)
+            {
+                reset();
+                return false;
+            }
+            
+            discarding_ = true;
+            continue;
+        }
+        
+        buffer_[num_bytes_++] = byte;
+        
+        if (byte == 0xF7)
+        {
+            complete_ = true;
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+MidiMessage MidiSysexAssembler::getMessage() const
+{
+    jassert(complete_);
+    
+    return MidiMessage(buffer_.getData(), num_bytes_, start_timestamp_);
+}
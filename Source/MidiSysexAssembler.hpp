@@ -0,0 +1,62 @@
+//
+//  MidiSysexAssembler.hpp
+//  Midiot
+//
+//  Created by Sean Bratnober on 2/10/18.
+//
+//
+
+#ifndef MidiSysexAssembler_hpp
+#define MidiSysexAssembler_hpp
+
+#include <stdio.h>
+#include "../JuceLibraryCode/JuceHeader.h"
+
+const int MIDI_SYSEX_DEFAULT_MAX_BYTES = 65536;
+const int MIDI_SYSEX_DEFAULT_TIMEOUT_MS = 500;
+
+// Rebuilds sysex messages that arrive in pieces. The buffer is allocated
+// once, at the size cap; a message that outgrows it is dropped up to its
+// F7, and a partial message is dropped if the next piece takes longer than
+// the timeout. Only ever used from the port's MIDI thread.
+class MidiSysexAssembler
+{
+public:
+    MidiSysexAssembler(int max_bytes = MIDI_SYSEX_DEFAULT_MAX_BYTES,
+                       int timeout_ms = MIDI_SYSEX_DEFAULT_TIMEOUT_MS);
+    ~MidiSysexAssembler();
+    
+    // Takes either the bytes received so far, starting at F0, as
+    // MidiInputCallback::handlePartialSysexMessage() reports them, or a
+    // raw continuation fragment. Returns true once the message is complete
+    // and ready in getMessage().
+    bool addData(const uint8* data, int num_bytes, double timestamp);
+    
+    MidiMessage getMessage() const;
+    
+    bool isAssembling() const { return num_bytes_received_ > 0 && !complete_; }
+    void reset();
+    
+    int getNumDroppedMessages() const { return num_dropped_; }
+    
+private:
+    bool appendBytes(const uint8* data, int num_bytes);
+    
+    HeapBlock<uint8> buffer_;
+    const int max_bytes_;
+    const double timeout_seconds_;
+    
+    int num_bytes_;
+    // including any bytes dropped after an overflow
+    int num_bytes_received_;
+    double start_timestamp_;
+    double last_timestamp_;
+    bool complete_;
+    // set after an overflow, until the dropped message's F7 goes by
+    bool discarding_;
+    int num_dropped_;
+    
+    JUCE_DECLARE_NON_COPYABLE(MidiSysexAssembler)
+};
+
+#endif /* MidiSysexAssembler_hpp */
@@ -51,6 +51,33 @@ File MidiotFileUtils::getInstrumentPatchFolder(const String manufacturer,
     return inst_patch_folder;
 }
 
+const String MidiotFileUtils::getInstrumentDefinitionFolderPath()
+{
+    return  getMidiotDataFolderPath() +
+            String("Instruments") +
+            File::separatorString;
+}
+
+File MidiotFileUtils::getInstrumentDefinitionFolder()
+{
+    File inst_definition_folder(getInstrumentDefinitionFolderPath());
+    
+    if (!inst_definition_folder.exists())
+    {
+        inst_definition_folder.createDirectory();
+    }
+    
+    return inst_definition_folder;
+}
+
+const String MidiotFileUtils::getInstrumentCaptureFolderPath(const String manufacturer,
+                                                            const String model_name)
+{
+    return  getInstrumentPatchFolderPath(manufacturer, model_name) +
+            String("Captures") +
+            File::separatorString;
+}
+
 String MidiotFileUtils::generatePatchFileName(const String manufacturer_name, const String model_name)
 {
     Time current_time = Time::getCurrentTime();
@@ -60,3 +87,29 @@ String MidiotFileUtils::generatePatchFileName(const String manufacturer_name, co
 
     return patch_name;
 }
+
+File MidiotFileUtils::getInstrumentBankFile(const String manufacturer,
+                                            const String model_name)
+{
+    return getInstrumentPatchFolder(manufacturer, model_name).getChildFile(manufacturer +
+                                                                          " " +
+                                                                          model_name +
+                                                                          getPatchBankFileExtension());
+}
+
+bool MidiotFileUtils::replaceFileAtomically(const File& file, const void* data, size_t num_bytes)
+{
+    if (!file.getParentDirectory().createDirectory())
+    {
+        return false;
+    }
+    
+    TemporaryFile temp_file(file);
+    
+    if (!temp_file.getFile().appendData(data, num_bytes))
+    {
+        return false;
+    }
+    
+    return temp_file.overwriteTargetFileWithTemporary();
+}
@@ -22,8 +22,30 @@ public:
     static File getInstrumentPatchFolder(const String manufacturer,
                                   const String model_name);
     
+    static const String getInstrumentDefinitionFolderPath();
+    static File getInstrumentDefinitionFolder();
+    static String getInstrumentDefinitionFileExtension() { return String(".json"); }
+    
     static String getPatchFileExtension() { return String(".mdp"); }
+    static String getBinaryPatchFileExtension() { return String(".mdpb"); }
+    // matches both patch formats
+    static String getPatchFileWildcard() { return String("*.mdpb;*.mdp"); }
     static String generatePatchFileName(const String manufacturer_name, const String model_name);
+    
+    // recorded hardware edits, see MidiControlCapture
+    static String getCaptureFileExtension() { return String(".mid"); }
+    static const String getInstrumentCaptureFolderPath(const String manufacturer,
+                                                       const String model_name);
+    
+    // one bank per instrument model, kept in its patch folder
+    static String getPatchBankFileExtension() { return String(".mdbank"); }
+    static File getInstrumentBankFile(const String manufacturer,
+                                      const String model_name);
+    
+    // Writes beside the target and renames it into place, so a crash
+    // part way through leaves the old file rather than a truncated one.
+    // Creates the parent folder if needed.
+    static bool replaceFileAtomically(const File& file, const void* data, size_t num_bytes);
 };
 
 #endif /* MidiotFileUtils_hpp */
@@ -8,72 +8,36 @@
 
 #include "NoteGridComponent.hpp"
 #include "NoteGridViewport.hpp"
-#include "NoteComponent.hpp"
-#include "NoteComponentSorter.hpp"
 
 NoteGridComponent::NoteGridComponent(NoteGridProperties* properties,
-                                     NoteGridViewport* viewport)
+                                     NoteGridViewport* viewport,
+                                     MidiClipModel* clip_model)
 : GraphicsComponentBase ("NoteGridComponent"),
+clip_model_(clip_model),
 grid_viewport(viewport),
 properties_(properties),
 selected_note_num_(-1),
 selected_note_on_time_(0),
 selected_note_off_time_(0),
-dragged_note_(NULL),
-drag_x_distance_(0),
-drag_y_distance_(0),
-drag_y_compensation_(0),
-note_grid_viewpos_x_(0),
+selected_notes_(*this),
+mouse_down_note_(-1),
+mouse_down_mode_(NormalMouseMode),
+hover_mouse_mode_(NormalMouseMode),
+notes_id_epoch_(0),
+clip_changed_during_edit_(false),
+drag_min_note_on_time_(0),
+drag_min_note_num_(0),
+drag_max_note_num_(0),
+drag_min_note_length_(0),
 draw_mode_(false),
 erase_mode_(false)
 {
     setName(String("NoteGridComponent"));
+    // the background fills every dirty region
+    setOpaque(true);
     
-    note_sorter_ = new NoteComponentSorter();
-    
-    MidiFile inputMidiFile;
-    
-    File midiFile = File::createFileWithoutCheckingPath (String("/Users/seanb/Development/JUCE/Midiot/Resources/basic808.mid"));
-    FileInputStream midiStream (midiFile);
-    inputMidiFile.readFrom (midiStream);
-    
-    String log_message_string;
-    
-    int num_tracks = inputMidiFile.getNumTracks();
-    
-    midi_msg_seq = inputMidiFile.getTrack(0);
-    int num_events = midi_msg_seq->getNumEvents();
-    
-    for (int i=0; i<num_events; i++)
-    {
-        MidiMessageSequence::MidiEventHolder* midi_event_ptr(midi_msg_seq->getEventPointer(i));
-        MidiMessage midi_msg(midi_event_ptr->message);
-        
-        if (midi_msg.isNoteOn() && midi_event_ptr->noteOffObject)
-        {
-            int note_num(midi_msg.getNoteNumber());
-            int note_velocity(midi_msg.getVelocity());
-            int note_on_time(midi_msg_seq->getEventTime(i));
-            int note_off_time(midi_msg_seq->getTimeOfMatchingKeyUp(i));
-            
-            NoteComponent *note_component = new NoteComponent(grid_viewport,
-                                                              note_num,
-                                                              note_velocity,
-                                                              note_on_time,
-                                                              note_off_time,
-                                                              midi_event_ptr,
-                                                              midi_event_ptr->noteOffObject,
-                                                              this);
-            note_component->setColour(NoteComponent::TextButton::ColourIds::buttonColourId, Colours::firebrick);
-            
-            addAndMakeVisible(*note_component);
-            
-            note_components.addSorted(*note_sorter_, note_component);
-            
-        }
-    }
-    
-    component_bounds = new ComponentBoundsConstrainer();
+    clip_model_->addListener(this);
+    loadNotesFromClip();
     
     draw_mode_cursor_image_file_ = File::createFileWithoutCheckingPath (String("/Users/seanb/Development/JUCE/Midiot/Resources/images/icons/Pencil-icon.png"));
     draw_mode_cursor_image_ = ImageCache::getFromFile(draw_mode_cursor_image_file_);
@@ -85,54 +49,96 @@ erase_mode_(false)
     erase_mode_cursor_image_ = ImageCache::getFromFile(erase_mode_cursor_image_file_);
     erase_mode_cursor_image_size_ = erase_mode_cursor_image_file_.getSize();
     erase_mode_mouse_cursor_ = MouseCursor(erase_mode_cursor_image_, 0, 0);
-
+    
 }
 
 NoteGridComponent::~NoteGridComponent()
 {
-    delete component_bounds;
-    delete note_sorter_;
+    clip_model_->removeListener(this);
 }
 
-void NoteGridComponent::clearSelectedNotes()
+void NoteGridComponent::setNoteSelectedFlag(int note_index, bool selected)
 {
-    NoteComponent** selected_note_iter;
-    for (selected_note_iter = selected_notes_.begin();
-         selected_note_iter != selected_notes_.end();
-         selected_note_iter++)
+    if (isPositiveAndBelow(note_index, notes_.size()))
     {
-        NoteComponent* selected_note = *selected_note_iter;
-        selected_note->setColour(NoteComponent::TextButton::ColourIds::buttonColourId, Colours::firebrick);
-        
+        notes_.getReference(note_index).selected = selected;
     }
+}
+
+void NoteGridComponent::clearSelectedNotes()
+{
     selected_notes_.deselectAll();
 }
 
 
 void NoteGridComponent::mouseMove(const MouseEvent& e)
 {
-    repaint();
+    int mouse_mode;
+    getNoteAt(e.x, e.y, mouse_mode);
+    
+    if (mouse_mode != hover_mouse_mode_)
+    {
+        hover_mouse_mode_ = mouse_mode;
+        updateMouseCursor();
+    }
+}
+
+MouseCursor NoteGridComponent::getMouseCursor()
+{
+    const int mouse_mode = (mouse_down_note_ >= 0) ? mouse_down_mode_ : hover_mouse_mode_;
+    
+    switch (mouse_mode)
+    {
+        case LeftEdgeResizeMouseMode:
+            return MouseCursor(MouseCursor::LeftEdgeResizeCursor);
+        case RightEdgeResizeMouseMode:
+            return MouseCursor(MouseCursor::RightEdgeResizeCursor);
+        case NormalMouseMode:
+        default:
+        {
+            if (draw_mode_)
+            {
+                return draw_mode_mouse_cursor_;
+            }
+            else if (erase_mode_)
+            {
+                return erase_mode_mouse_cursor_;
+            }
+            else
+            {
+                return MouseCursor(MouseCursor::NormalCursor);
+            }
+        }
+    };
 }
 
 void NoteGridComponent::mouseUp (const MouseEvent& e)
 {
+    if (mouse_down_note_ >= 0)
+    {
+        updateSelectedNotes();
+        
+        if (erase_mode_)
+        {
+            notes_.getReference(mouse_down_note_).hidden = true;
+        }
+        
+        mouse_down_note_ = -1;
+        commitNoteEdits();
+        updateMouseCursor();
+        
+        repaint();
+        return;
+    }
+    
     note_lasso_.endLasso();
     removeChildComponent(&note_lasso_);
     
     if (! (e.mouseWasDraggedSinceMouseDown() || e.mods.isAnyModifierKeyDown()))
     {
-        NoteComponent** selected_note_iter;
-        for (selected_note_iter = selected_notes_.begin();
-             selected_note_iter != selected_notes_.end();
-             selected_note_iter++)
-        {
-            NoteComponent* selected_note = *selected_note_iter;
-            selected_note->setColour(NoteComponent::TextButton::ColourIds::buttonColourId, Colours::firebrick);
-
-        }
         selected_notes_.deselectAll();
     }
-
+    
     repaint();
 }
 
@@ -142,23 +148,22 @@ void NoteGridComponent::modifierKeysChanged(const ModifierKeys &modifiers)
     {
         if (modifiers.isShiftDown())
         {
-            setMouseCursor(erase_mode_mouse_cursor_);
             setDrawMode(false);
             setEraseMode(true);
         }
         else
         {
-            setMouseCursor(draw_mode_mouse_cursor_);
             setDrawMode(true);
             setEraseMode(false);
         }
     }
     else
     {
-        setMouseCursor(MouseCursor(juce::MouseCursor::NormalCursor));
         setDrawMode(false);
         setEraseMode(false);
     }
+    
+    updateMouseCursor();
 }
 
 
@@ -168,295 +173,332 @@ bool NoteGridComponent::keyStateChanged(bool isKeyDown)
 }
 
 
-void NoteGridComponent::setSelectedNote(NoteComponent *note_component)
+void NoteGridComponent::setSelectedNote(int note_index)
 {
     clearSelectedNotes();
-    note_component->setMouseDownBounds(note_component->getBounds());
-    selected_notes_.addToSelection(note_component);
-    note_component->setColour(NoteComponent::TextButton::ColourIds::buttonColourId, Colours::lightblue);
-
+    selected_notes_.addToSelection(note_index);
+    initSelectedNotes();
 }
 
-void NoteGridComponent::removeNoteComponent(NoteComponent* note_component, bool delete_note)
+void NoteGridComponent::removeNote(int note_index)
 {
-    NoteComponent** selected_note_iter;
-    for (selected_note_iter = selected_notes_.begin();
-         selected_note_iter != selected_notes_.end();
-         selected_note_iter++)
+    if (!isPositiveAndBelow(note_index, notes_.size()))
     {
-        NoteComponent* selected_note = *selected_note_iter;
-        selected_notes_.deselect(selected_note);
+        return;
     }
     
-    int note_index = note_components.indexOf(note_component);
-    note_components.remove(note_index, delete_note);
-    }
+    notes_.getReference(note_index).hidden = true;
+    commitNoteEdits();
+}
 
-void NoteGridComponent::removeSelectedNotes(bool delete_note)
+void NoteGridComponent::removeSelectedNotes()
 {
-    int note_index;
-    NoteComponent** selected_note_iter;
-    for (selected_note_iter = selected_notes_.begin();
+    for (const int* selected_note_iter = selected_notes_.begin();
          selected_note_iter != selected_notes_.end();
          selected_note_iter++)
     {
-        NoteComponent* selected_note = *selected_note_iter;
-        selected_notes_.deselect(selected_note);
-        note_index = note_components.indexOf(selected_note);
-        note_components.remove(note_index);
+        notes_.getReference(*selected_note_iter).hidden = true;
     }
+    
+    commitNoteEdits();
 }
 
 void NoteGridComponent::initSelectedNotes()
 {
-    NoteComponent** selected_note_iter;
-    for (selected_note_iter = selected_notes_.begin();
+    drag_min_note_on_time_ = std::numeric_limits<int>::max();
+    drag_min_note_num_ = num_midi_notes_ - 1;
+    drag_max_note_num_ = 0;
+    drag_min_note_length_ = std::numeric_limits<int>::max();
+    
+    for (const int* selected_note_iter = selected_notes_.begin();
          selected_note_iter != selected_notes_.end();
          selected_note_iter++)
     {
-        NoteComponent* selected_note = *selected_note_iter;
-        selected_note->setMouseDownBounds(selected_note->getBounds());
+        GridNote& selected_note = notes_.getReference(*selected_note_iter);
+        const MIDINote& midi_note = selected_note.midi_note;
+        
+        selected_note.mouse_down_note = midi_note;
+        
+        drag_min_note_on_time_ = jmin(drag_min_note_on_time_, midi_note.note_on_time_);
+        drag_min_note_num_ = jmin(drag_min_note_num_, midi_note.note_num_);
+        drag_max_note_num_ = jmax(drag_max_note_num_, midi_note.note_num_);
+        drag_min_note_length_ = jmin(drag_min_note_length_,
+                                     midi_note.note_off_time_ - midi_note.note_on_time_);
     }
 }
 
-void NoteGridComponent::startDrag()
+void NoteGridComponent::dragSelectedNotes(const MouseEvent& e)
 {
-    note_grid_viewpos_x_ = grid_viewport->getViewPositionX();
-}
-
-void NoteGridComponent::endDrag()
-{
-    dragged_note_ = NULL;
-    drag_x_distance_ = 0;
-    drag_y_distance_ = 0;
-    note_grid_viewpos_x_ = 0;
-}
-
-void NoteGridComponent::dragSelectedNotes(const MouseEvent& e,
-                                          NoteComponent* dragged_note,
-                                          int y_drag_compensation)
-{
-    dragged_note_ = dragged_note;
-    drag_x_distance_ = e.getDistanceFromDragStartX();
-    drag_y_distance_ = e.getDistanceFromDragStartY();
-    drag_y_compensation_ = y_drag_compensation;
+    const float step_height = properties_->step_height_;
     
-    doDragSelectedNotes();
-}
-
-void NoteGridComponent::resizeSelectedNotes(const MouseEvent& e,
-                                          NoteComponent* resized_note,
-                                          int y_resize_compensation)
-{
-    resized_note_ = resized_note;
-    resize_x_distance_ = e.getDistanceFromDragStartX();
-    resize_y_distance_ = e.getDistanceFromDragStartY();
-    resize_y_compensation_ = y_resize_compensation;
+    int tick_delta = roundToInt(e.getDistanceFromDragStartX() / properties_->tick_to_pixel_x_factor_);
+    // whole rows between the mouse down row and the current one
+    int note_num_delta = (int)std::floor(e.getMouseDownY() / step_height) - (int)std::floor(e.y / step_height);
+    
+    // move the selection as a block, stopping at the edges of the grid
+    tick_delta = jmax(-drag_min_note_on_time_, tick_delta);
+    note_num_delta = jlimit(-drag_min_note_num_,
+                            num_midi_notes_ - 1 - drag_max_note_num_,
+                            note_num_delta);
     
-    doResizeSelectedNotes();
+    for (const int* selected_note_iter = selected_notes_.begin();
+         selected_note_iter != selected_notes_.end();
+         selected_note_iter++)
+    {
+        MIDINote dragged_note = notes_.getReference(*selected_note_iter).mouse_down_note;
+        
+        dragged_note.note_num_ += note_num_delta;
+        dragged_note.note_on_time_ += tick_delta;
+        dragged_note.note_off_time_ += tick_delta;
+        
+        moveNote(*selected_note_iter, dragged_note);
+    }
 }
 
-void NoteGridComponent::doResizeSelectedNotes()
+void NoteGridComponent::resizeSelectedNotes(const MouseEvent& e)
 {
-    if (!resized_note_)
+    int tick_delta = roundToInt(e.getDistanceFromDragStartX() / properties_->tick_to_pixel_x_factor_);
+    
+    // every selected note keeps at least one tick of length
+    if (mouse_down_mode_ == LeftEdgeResizeMouseMode)
     {
-        return;
+        tick_delta = jlimit(-drag_min_note_on_time_, drag_min_note_length_ - 1, tick_delta);
+    }
+    else
+    {
+        tick_delta = jmax(1 - drag_min_note_length_, tick_delta);
     }
     
-    int resize_delta = resized_note_->getWidth() - resize_down_width_;
-    int resize_x_delta = resized_note_->getX() - resized_note_->getMouseDownBounds().getX();
-    
-    printf("resize_delta: %d\n", resize_delta);
+    Array<int> overlap_notes;
     
-    NoteComponent** selected_note_iter;
-    for (selected_note_iter = selected_notes_.begin();
+    for (const int* selected_note_iter = selected_notes_.begin();
          selected_note_iter != selected_notes_.end();
          selected_note_iter++)
     {
-        NoteComponent* selected_note_component = *selected_note_iter;
+        MIDINote resized_note = notes_.getReference(*selected_note_iter).mouse_down_note;
         
-        if (resized_note_ == selected_note_component)
+        if (mouse_down_mode_ == LeftEdgeResizeMouseMode)
         {
-            continue;
+            resized_note.note_on_time_ += tick_delta;
+        }
+        else
+        {
+            resized_note.note_off_time_ += tick_delta;
         }
-        
-        Rectangle<int> resize_bounds = selected_note_component->getMouseDownBounds();
-        
-        int note_grid_viewpos_x_delta = grid_viewport->getViewPositionX() - note_grid_viewpos_x_;
-        
-        printf("note_grid_viewpos_x_delta: %d\n", note_grid_viewpos_x_delta);
-        
-        resize_bounds.setWidth(resize_bounds.getWidth() + resize_delta);
-        resize_bounds.setX(resize_bounds.getX() + resize_x_delta);
-        
-        MIDINote selected_note = selected_note_component->getMidiNote();
-        
-        Rectangle<int> selected_note_bounds = selected_note_component->getBoundsInParent();
-        selected_note_num_ = getNoteNum(selected_note_bounds.getY());
-        selected_note_on_time_ = getNoteOnTime(selected_note_bounds.getX());
-        selected_note_off_time_ = getNoteOffTime(selected_note_on_time_,
-                                                 selected_note_bounds.getWidth());
-        
-        
-        printf("selected_note_num_: %d selected_note_on_time_: %d selected_note_off_time_: %d\n", selected_note_num_, selected_note_on_time_, selected_note_off_time_);
-        selected_note.note_num_ = getNoteNum(resize_bounds.getY());
-        selected_note.note_on_time_ = getNoteOnTime(resize_bounds.getX());
-        selected_note.note_off_time_ = getNoteOffTime(selected_note.note_on_time_,
-                                                      resize_bounds.getWidth());
-        
         
         bool found_overlap = false;
         
-        for (int overlap_note_index=0;
-             overlap_note_index<note_components.size();
-             overlap_note_index++)
+        // the other selected notes are not pushed aside, so stop short of them
+        if (*selected_note_iter != mouse_down_note_)
         {
+            overlap_notes.clearQuick();
+            row_index_.findNotes(resized_note.note_num_,
+                                 resized_note.note_on_time_,
+                                 resized_note.note_off_time_,
+                                 overlap_notes);
             
-            NoteComponent* overlap_note_component = note_components[overlap_note_index];
-            
-            if (selected_note_component == overlap_note_component)
+            for (int i=0; i<overlap_notes.size() && !found_overlap; i++)
             {
-                continue;
-            }
-            
-            MIDINote overlap_note = overlap_note_component->getMidiNote();
-            
-            if (doesNoteOverlap(selected_note, overlap_note) &&
-                isNoteSelected(overlap_note_component))
-            {
-                found_overlap = true;
-                printf("found resize OVERLAP!\n");
+                const int overlap_note_index = overlap_notes.getUnchecked(i);
+                const GridNote& overlap_note = notes_.getReference(overlap_note_index);
+                
+                if (overlap_note_index != *selected_note_iter &&
+                    overlap_note.selected &&
+                    doesNoteOverlap(resized_note, overlap_note.midi_note))
+                {
+                    found_overlap = true;
+                }
             }
         }
         
         if (!found_overlap)
         {
-            selected_note_component->setBounds(resize_bounds);
+            moveNote(*selected_note_iter, resized_note);
         }
     }
 }
 
-void NoteGridComponent::doDragSelectedNotes()
+bool NoteGridComponent::isNoteSelected(int note_index)
 {
-    if (!dragged_note_)
+    return isPositiveAndBelow(note_index, notes_.size()) && notes_.getReference(note_index).selected;
+}
+
+void NoteGridComponent::mouseDown (const MouseEvent& e)
+{
+    int mouse_mode;
+    const int note_index = getNoteAt(e.x, e.y, mouse_mode);
+    
+    if (note_index < 0)
     {
+        mouse_down_note_ = -1;
+        clearSelectedNotes();
+        
+        addChildComponent(note_lasso_);
+        note_lasso_.setAlpha(0.5);
+        note_lasso_.beginLasso(e, this);
         return;
     }
     
-    NoteComponent** selected_note_iter;
-    for (selected_note_iter = selected_notes_.begin();
-         selected_note_iter != selected_notes_.end();
-         selected_note_iter++)
+    mouse_down_note_ = note_index;
+    mouse_down_mode_ = mouse_mode;
+    
+    if (!isNoteSelected(note_index))
     {
-        NoteComponent* selected_note = *selected_note_iter;
-        
-        if (dragged_note_ == selected_note)
-        {
-            continue;
-        }
-        
-        Rectangle<int> drag_bounds = selected_note->getMouseDownBounds();
-        
-        int note_grid_viewpos_x_delta = grid_viewport->getViewPositionX() - note_grid_viewpos_x_;
-        
-        printf("note_grid_viewpos_x_delta: %d\n", note_grid_viewpos_x_delta);
-        drag_bounds.setX(drag_bounds.getX() + drag_x_distance_ + note_grid_viewpos_x_delta);
-        
-        int y_distance = drag_y_distance_;
-        int y_direction = y_distance >= 0 ? 1 : -1;
-        
-        int move_y_steps;
-        
-        if (y_direction == 1)
-        {
-            move_y_steps =
-            abs(y_distance + drag_y_compensation_ - 1) / properties_->step_height_;
-        }
-        else
-        {
-            if ((drag_y_compensation_ + y_distance) < 0)
-            {
-                move_y_steps =
-                (abs(y_distance + drag_y_compensation_) + properties_->step_height_) / properties_->step_height_;
-            }
-            else
-            {
-                move_y_steps = 0;
-            }
-        }
-        
-        printf("\ndrag_y_distance_: %d\tdrag_y_compensation_: %d\n", drag_y_distance_, drag_y_compensation_);
-        
-        int move_y_amount = 0;
-        
-        for (int i=0; i<move_y_steps; i++)
-        {
-            move_y_amount += (y_direction * properties_->step_height_);
-        }
-        
-        printf("move_y_steps: %d\ty_direction: %d\tmove_y_amount: %d\n",
-               move_y_steps, y_direction, move_y_amount);
-        
-        drag_bounds.setY(drag_bounds.getY() + move_y_amount);
-        
-        selected_note->setBounds(drag_bounds);
+        setSelectedNote(note_index);
     }
+    else
+    {
+        initSelectedNotes();
+    }
+    
+    updateSelectedNotes();
 }
 
-bool NoteGridComponent::isNoteSelected(NoteComponent* note_component)
+void NoteGridComponent::mouseDrag (const MouseEvent& e)
 {
-    NoteComponent** selected_note_iter;
-    for (selected_note_iter = selected_notes_.begin();
-         selected_note_iter != selected_notes_.end();
-         selected_note_iter++)
+    if (mouse_down_note_ < 0)
     {
-        NoteComponent* selected_note = *selected_note_iter;
-        
-        if (selected_note == note_component)
-        {
-            return true;
-        }
+        note_lasso_.toFront(false);
+        note_lasso_.dragLasso(e);
+        return;
     }
     
-    return false;
+    if (mouse_down_mode_ == NormalMouseMode)
+    {
+        dragSelectedNotes(e);
+    }
+    else
+    {
+        resizeSelectedNotes(e);
+    }
+    
+    updateSelectedNotes();
+    
+    grid_viewport->autoScroll(e.x - grid_viewport->getViewPositionX(),
+                              e.y - grid_viewport->getViewPositionY(),
+                              1, 2);
+    
+    beginDragAutoRepeat(10);
 }
 
-void NoteGridComponent::mouseDown (const MouseEvent& e)
+void NoteGridComponent::changeListenerCallback(ChangeBroadcaster*)
 {
-    clearSelectedNotes();
+    repaint();
+}
+
+void NoteGridComponent::moveNote(int note_index, const MIDINote& midi_note)
+{
+    GridNote& note = notes_.getReference(note_index);
     
-    addChildComponent(note_lasso_);
-    note_lasso_.setAlpha(0.5);
-    note_lasso_.beginLasso(e, this);
+    row_index_.removeNote(note_index, note.midi_note);
+    note.midi_note = midi_note;
+    row_index_.addNote(note_index, note.midi_note);
 }
 
-void NoteGridComponent::mouseDrag (const MouseEvent& e)
+void NoteGridComponent::rebuildRowIndex()
 {
-    note_lasso_.toFront(false);
-    note_lasso_.dragLasso(e);
+    row_index_.clear();
+    
+    for (int i=0; i<notes_.size(); i++)
+    {
+        row_index_.addNote(i, notes_.getReference(i).midi_note);
+    }
 }
 
-void NoteGridComponent::changeListenerCallback(ChangeBroadcaster*)
+void NoteGridComponent::findNotesInArea(const Rectangle<int>& area, Array<int>& results)
 {
-    repaint();
+    const float step_height = properties_->step_height_;
+    
+    const int first_row = jmax(0, (int)(area.getY() / step_height));
+    const int last_row = jmin(num_midi_notes_ - 1, (int)((area.getBottom() - 1) / step_height));
+    
+    // a tick either way covers the rounding between pixels and ticks
+    const int start_time = getNoteOnTime(area.getX()) - 1;
+    const int end_time = getNoteOnTime(area.getRight()) + 1;
+    
+    for (int row = first_row; row <= last_row; row++)
+    {
+        row_index_.findNotes(num_midi_notes_ - 1 - row, start_time, end_time, results);
+    }
+}
+
+Rectangle<int> NoteGridComponent::getNoteBounds(const MIDINote& note) const
+{
+    int note_height = properties_->step_height_;
+    int note_width = (note.note_off_time_ - note.note_on_time_) * properties_->tick_to_pixel_x_factor_;
+    int note_pos_x = note.note_on_time_ * properties_->tick_to_pixel_x_factor_;
+    int note_pos_y = (properties_->step_height_)*(num_midi_notes_ - note.note_num_ - 1);
+    
+    return Rectangle<int>(note_pos_x, note_pos_y, jmax(1, note_width), note_height);
+}
+
+int NoteGridComponent::getNoteAt(int x, int y, int& mouse_mode)
+{
+    mouse_mode = NormalMouseMode;
+    
+    if (x < 0 || y < 0)
+    {
+        return -1;
+    }
+    
+    Array<int> hit_notes;
+    findNotesInArea(Rectangle<int>(x, y, 1, 1), hit_notes);
+    
+    int found_note = -1;
+    
+    for (int i=0; i<hit_notes.size(); i++)
+    {
+        const int note_index = hit_notes.getUnchecked(i);
+        const GridNote& note = notes_.getReference(note_index);
+        
+        // later notes are painted on top, so the last hit wins
+        if (!note.hidden && getNoteBounds(note.midi_note).contains(x, y))
+        {
+            found_note = note_index;
+        }
+    }
+    
+    if (found_note >= 0)
+    {
+        Rectangle<int> note_bounds = getNoteBounds(notes_.getReference(found_note).midi_note);
+        
+        if (note_bounds.getWidth() > 2 * NOTE_RESIZE_EDGE_WIDTH)
+        {
+            if (x < note_bounds.getX() + NOTE_RESIZE_EDGE_WIDTH)
+            {
+                mouse_mode = LeftEdgeResizeMouseMode;
+            }
+            else if (x >= note_bounds.getRight() - NOTE_RESIZE_EDGE_WIDTH)
+            {
+                mouse_mode = RightEdgeResizeMouseMode;
+            }
+        }
+    }
+    
+    return found_note;
 }
 
-void NoteGridComponent::findLassoItemsInArea (Array <NoteComponent*>& results, const Rectangle<int>& area)
+void NoteGridComponent::findLassoItemsInArea (Array <int>& results, const Rectangle<int>& area)
 {
     const Rectangle<int> lasso (area);// - subCompHolder->getPosition());
     
-    for (int i=0; i<note_components.size(); i++)
+    Array<int> lasso_notes;
+    
+    findNotesInArea(lasso, lasso_notes);
+    
+    for (int i=0; i<lasso_notes.size(); i++)
     {
-        NoteComponent* note = note_components[i];
+        const int note_index = lasso_notes.getUnchecked(i);
+        const GridNote& note = notes_.getReference(note_index);
         
-        if (note->getBounds().intersects(lasso))
+        if (!note.hidden && getNoteBounds(note.midi_note).intersects(lasso))
         {
-            results.add(note);
+            results.add(note_index);
         }
     }
 }
 
-SelectedItemSet<NoteComponent*>& NoteGridComponent::getLassoSelection()
+SelectedItemSet<int>& NoteGridComponent::getLassoSelection()
 {
     return selected_notes_;
 }
@@ -488,8 +530,8 @@ int NoteGridComponent::getNoteOffTime(int note_on_time, int width)
     return round(width / properties_->tick_to_pixel_x_factor_) + note_on_time;
 }
 
-bool NoteGridComponent::doesNoteOverlap(MIDINote& selected_note,
-                                        MIDINote& check_note,
+bool NoteGridComponent::doesNoteOverlap(const MIDINote& selected_note,
+                                        const MIDINote& check_note,
                                         bool debug_print)
 {
     if (false)//debug_print)
@@ -532,74 +574,60 @@ bool NoteGridComponent::doesNoteOverlap(MIDINote& selected_note,
 
 void NoteGridComponent::updateSelectedNotes()
 {
-    NoteComponent* selected_note_component;
-
-    NoteComponent** selected_note_iter;
-    for (selected_note_iter=selected_notes_.begin();
-         selected_note_iter!=selected_notes_.end();
+    Array<int> overlap_notes;
+    
+    // hide the notes the selection now covers
+    for (const int* selected_note_iter = selected_notes_.begin();
+         selected_note_iter != selected_notes_.end();
          selected_note_iter++)
     {
-        selected_note_component = *selected_note_iter;
-
-        MIDINote selected_note = selected_note_component->getMidiNote();
-        Rectangle<int> selected_note_bounds = selected_note_component->getBoundsInParent();
-        selected_note_num_ = getNoteNum(selected_note_bounds.getY());
-        selected_note_on_time_ = getNoteOnTime(selected_note_bounds.getX());
-        selected_note_off_time_ = getNoteOffTime(selected_note_on_time_,
-                                                 selected_note_bounds.getWidth());
-
-        printf("selected_note_num_: %d selected_note_on_time_: %d selected_note_off_time_: %d\n", selected_note_num_, selected_note_on_time_, selected_note_off_time_);
-        selected_note.note_num_ = getNoteNum(selected_note_bounds.getY());
-        selected_note.note_on_time_ = getNoteOnTime(selected_note_bounds.getX());
-        selected_note.note_off_time_ = getNoteOffTime(selected_note_on_time_,
-                                                 selected_note_bounds.getWidth());
+        const MIDINote& selected_note = notes_.getReference(*selected_note_iter).midi_note;
         
-        selected_note_component->setMidiNote(selected_note);
+        overlap_notes.clearQuick();
+        row_index_.findNotes(selected_note.note_num_,
+                             selected_note.note_on_time_,
+                             selected_note.note_off_time_,
+                             overlap_notes);
         
-        for (int overlap_note_index=0;
-             overlap_note_index<note_components.size();
-             overlap_note_index++)
+        for (int i=0; i<overlap_notes.size(); i++)
         {
- 
-            NoteComponent* overlap_note_component = note_components[overlap_note_index];
-
-            if (selected_note_component == overlap_note_component)
+            const int overlap_note_index = overlap_notes.getUnchecked(i);
+            GridNote& overlap_note = notes_.getReference(overlap_note_index);
+            
+            if (overlap_note.selected || overlap_note.hidden)
             {
                 continue;
             }
-
-            MIDINote overlap_note = overlap_note_component->getMidiNote();
             
-            if (doesNoteOverlap(selected_note, overlap_note))
+            if (doesNoteOverlap(selected_note, overlap_note.midi_note))
             {
-                printf("found OVERLAP!\n");
-                overlap_note_component->setVisible(false);
-                note_components.remove(overlap_note_index, false);
-                note_remove_pool.addSorted(*note_sorter_, overlap_note_component);
+                overlap_note.hidden = true;
+                hidden_notes_.add(overlap_note_index);
             }
         }
     }
     
-    for (int restore_index=0;
-         restore_index<note_remove_pool.size();
-         restore_index++)
+    // and bring back the ones it has moved off again
+    for (int restore_index=hidden_notes_.size()-1;
+         restore_index>=0;
+         restore_index--)
     {
-        NoteComponent* restore_note_component = note_remove_pool[restore_index];
-        MIDINote restore_note = restore_note_component->getMidiNote();
+        GridNote& restore_note = notes_.getReference(hidden_notes_.getUnchecked(restore_index));
         
         bool should_restore_note = true;
         
-
-        NoteComponent** selected_note_iter;
-        for (selected_note_iter=selected_notes_.begin();
-             selected_note_iter!=selected_notes_.end();
-             selected_note_iter++)
+        overlap_notes.clearQuick();
+        row_index_.findNotes(restore_note.midi_note.note_num_,
+                             restore_note.midi_note.note_on_time_,
+                             restore_note.midi_note.note_off_time_,
+                             overlap_notes);
+        
+        for (int i=0; i<overlap_notes.size() && should_restore_note; i++)
         {
-            NoteComponent* check_note_component = *selected_note_iter;
-
-            MIDINote check_note = check_note_component->getMidiNote();
+            const GridNote& check_note = notes_.getReference(overlap_notes.getUnchecked(i));
             
-            if (doesNoteOverlap(restore_note, check_note, false))
+            if (check_note.selected &&
+                doesNoteOverlap(restore_note.midi_note, check_note.midi_note))
             {
                 should_restore_note = false;
             }
@@ -607,123 +635,256 @@ void NoteGridComponent::updateSelectedNotes()
         
         if (should_restore_note)
         {
-            restore_note_component->setVisible(true);
-            note_remove_pool.remove(restore_index, false);
-            note_components.addSorted(*note_sorter_,
-                                      restore_note_component);
+            restore_note.hidden = false;
+            hidden_notes_.remove(restore_index);
         }
     }
     
+    if (isPositiveAndBelow(mouse_down_note_, notes_.size()))
+    {
+        const MIDINote& selected_note = notes_.getReference(mouse_down_note_).midi_note;
+        
+        selected_note_num_ = selected_note.note_num_;
+        selected_note_on_time_ = selected_note.note_on_time_;
+        selected_note_off_time_ = selected_note.note_off_time_;
+    }
+    
     repaint();
 }
 
-void NoteGridComponent::flushNoteRemovePool()
+void NoteGridComponent::commitNoteEdits()
 {
-    note_remove_pool.clear();
+    clip_model_->beginTransaction();
+    
+    // the clip may have changed during a drag, so find each note by id;
+    // if it was emptied meanwhile, the ids no longer name these notes
+    if (notes_id_epoch_ == clip_model_->getNoteIdEpoch())
+    {
+        for (int i=0; i<notes_.size(); i++)
+        {
+            const GridNote& note = notes_.getReference(i);
+            const int clip_index = clip_model_->indexOfNoteId(note.note_id);
+            
+            if (clip_index < 0)
+            {
+                continue;
+            }
+            
+            if (note.hidden)
+            {
+                clip_model_->removeNote(note.note_id);
+            }
+            else if (note.midi_note != clip_model_->getNote(clip_index))
+            {
+                clip_model_->moveNote(note.note_id, note.midi_note);
+            }
+        }
+    }
+    
+    hidden_notes_.clearQuick();
+    mouse_down_note_ = -1;
+    
+    clip_model_->endTransaction();
+    
+    // nothing to commit, but the clip still changed under the drag
+    if (clip_changed_during_edit_)
+    {
+        loadNotesFromClip();
+    }
 }
 
-void NoteGridComponent::updateNoteComponentBounds(NoteComponent* note_component)
+void NoteGridComponent::clipNotesChanged(MidiClipModel* clip_model)
 {
-    if (!note_component)
+    // reloading now would throw away the drag or resize in progress
+    if (mouse_down_note_ >= 0)
     {
+        clip_changed_during_edit_ = true;
         return;
     }
     
-    MIDINote note = note_component->getMidiNote();
-    int num_notes = 128;
-    int note_height = properties_->step_height_;
-    int note_width = (note.note_off_time_ - note.note_on_time_) * properties_->tick_to_pixel_x_factor_;
-    int note_pos_x = note.note_on_time_ * properties_->tick_to_pixel_x_factor_;
-    int note_pos_y = (properties_->step_height_)*(num_notes - note.note_num_ - 1);
-    
-    note_component->setBounds(note_pos_x, note_pos_y, note_width, note_height);
-
+    loadNotesFromClip();
 }
 
-void NoteGridComponent::drawComponent (Graphics& g)
+void NoteGridComponent::loadNotesFromClip()
 {
-    int fill_x = getWidth() / 2;
-    int fill_y = getHeight() / 2;
-    
-    float step_width = properties_->step_width_;
-    float step_height = properties_->step_height_;
+    Array<int> selected_note_ids;
     
-    g.addTransform (getTransform());
+    for (const int* selected_note_iter = selected_notes_.begin();
+         selected_note_iter != selected_notes_.end();
+         selected_note_iter++)
+    {
+        selected_note_ids.add(notes_.getReference(*selected_note_iter).note_id);
+    }
     
-    g.setColour (Colours::grey);
-    g.fillRect (-fill_x, -fill_y, getWidth(), getHeight());
+    // indices change below, so reselect by id afterwards
+    selected_notes_.deselectAll();
     
-    int grid_width = getWidth();
-    int grid_height = getHeight();
+    notes_.clearQuick();
+    notes_.ensureStorageAllocated(clip_model_->getNumNotes());
+    hidden_notes_.clearQuick();
+    mouse_down_note_ = -1;
+    notes_id_epoch_ = clip_model_->getNoteIdEpoch();
+    clip_changed_during_edit_ = false;
     
-    int grid_step_x = -(getWidth() / 2);
-    int grid_step_y = -(getHeight() / 2);
+    for (int i=0; i<clip_model_->getNumNotes(); i++)
+    {
+        GridNote note;
+        note.note_id = clip_model_->getNoteId(i);
+        note.midi_note = clip_model_->getNote(i);
+        note.mouse_down_note = note.midi_note;
+        note.selected = false;
+        note.hidden = false;
+        
+        notes_.add(note);
+    }
     
-    int num_grid_steps = 16 * 8;
-    int num_notes = 128;
+    rebuildRowIndex();
     
-    int border_x = -(getWidth() / 2);
-    int border_y = -(getHeight() / 2);
-    int border_width = 16 * 8 * 24 * properties_->tick_to_pixel_x_factor_;
-    int border_height = step_height * num_notes;
+    for (int i=0; i<selected_note_ids.size(); i++)
+    {
+        const int note_index = clip_model_->indexOfNoteId(selected_note_ids.getUnchecked(i));
+        
+        if (note_index >= 0)
+        {
+            selected_notes_.addToSelection(note_index);
+        }
+    }
     
-    g.setColour (Colours::darkgrey);
+    repaint();
+}
+
+void NoteGridComponent::drawNotes(Graphics& g)
+{
+    const Rectangle<int> clip_bounds = g.getClipBounds();
     
-    g.drawRect((float)border_x,
-               (float)border_y,
-               (float)border_width,
-               (float)border_height,
-               2.0);
+    Array<int> visible_notes;
     
-    g.setColour (Colours::darkgrey);
+    findNotesInArea(clip_bounds, visible_notes);
     
-    for (int note_row = 0; note_row < num_notes; note_row++)
+    for (int i=0; i<visible_notes.size(); i++)
     {
-        grid_step_x = -(getWidth() / 2);
+        const GridNote& note = notes_.getReference(visible_notes.getUnchecked(i));
         
-        for (int step = 0; step < num_grid_steps; step++)
+        if (note.hidden)
         {
-            g.drawRect((float)grid_step_x,
-                       (float)grid_step_y,
-                       step_width,
-                       step_height,
-                       0.5);
-            
-            grid_step_x += step_width;
+            continue;
+        }
+        
+        Rectangle<int> note_bounds = getNoteBounds(note.midi_note);
+        
+        if (!note_bounds.intersects(clip_bounds))
+        {
+            continue;
         }
         
-        grid_step_y += step_height;
+        g.setColour (note.selected ? Colours::lightblue : Colours::firebrick);
+        g.fillRect (note_bounds);
+        
+        g.setColour (Colours::black.withAlpha(0.4f));
+        g.drawRect (note_bounds);
     }
+}
+
+void NoteGridComponent::createGridTileImage()
+{
+    const float step_width = properties_->step_width_;
+    const float step_height = properties_->step_height_;
+    
+    const int num_tile_steps = jmax(1, (int)std::ceil(NOTE_GRID_TILE_SIZE / step_width));
+    const int num_tile_rows = jmax(1, (int)std::ceil(NOTE_GRID_TILE_SIZE / step_height));
+    
+    grid_tile_width_ = num_tile_steps * step_width;
+    grid_tile_height_ = num_tile_rows * step_height;
     
-    g.setColour (Colours::firebrick);
+    // a pixel of overlap at most; the next tile covers it at its own offset
+    grid_tile_image_ = Image(Image::RGB,
+                             jmax(1, (int)std::ceil(grid_tile_width_)),
+                             jmax(1, (int)std::ceil(grid_tile_height_)),
+                             false);
+    
+    Graphics g (grid_tile_image_);
+    
+    g.fillAll (Colours::grey);
+    g.setColour (Colours::darkgrey);
     
-    if (properties_->init_grid_)
+    for (int note_row = 0; note_row < num_tile_rows; note_row++)
     {
-        for (int note_index=0; note_index<note_components.size(); note_index++)
+        for (int step = 0; step < num_tile_steps; step++)
         {
-            updateNoteComponentBounds(note_components[note_index]);
-        }
-        /*
-        for (int note_index=0; note_index<selected_note_components_.size(); note_index++)
-        {
-            printf("updateNoteComponentBounds!*(!(!(!!!!*!*!*!\n");
-            updateNoteComponentBounds(selected_note_components_[note_index]);
+            g.drawRect(step * step_width,
+                       note_row * step_height,
+                       step_width,
+                       step_height,
+                       0.5);
         }
-        */
+    }
+}
+
+void NoteGridComponent::drawGridBackground(Graphics& g)
+{
+    if (properties_->init_grid_ || !grid_tile_image_.isValid())
+    {
+        createGridTileImage();
         properties_->init_grid_ = false;
     }
     
-    NoteComponent** selected_note_iter;
-    for (selected_note_iter = selected_notes_.begin();
-         selected_note_iter != selected_notes_.end();
-         selected_note_iter++)
+    const Rectangle<int> clip_bounds = g.getClipBounds();
+    
+    int num_grid_steps = 16 * 8;
+    
+    const Rectangle<int> grid_bounds (0,
+                                      0,
+                                      roundToInt(num_grid_steps * properties_->step_width_),
+                                      roundToInt(num_midi_notes_ * properties_->step_height_));
+    const Rectangle<int> dirty_grid_bounds = grid_bounds.getIntersection(clip_bounds);
+    
+    g.setColour (Colours::grey);
+    g.fillRect (clip_bounds);
+    
+    if (!dirty_grid_bounds.isEmpty())
     {
-        NoteComponent* selected_note = *selected_note_iter;
-        selected_note->setColour(NoteComponent::TextButton::ColourIds::buttonColourId, Colours::lightblue);
+        const Graphics::ScopedSaveState state (g);
+        
+        g.reduceClipRegion (dirty_grid_bounds);
+        
+        // blit just the tiles under the dirty region. Tiles rarely span a
+        // whole number of pixels, so each goes at its own rounded offset
+        // rather than a running sum that would drift off the notes.
+        const int first_tile_row = (int)(dirty_grid_bounds.getY() / grid_tile_height_);
+        const int first_tile_column = (int)(dirty_grid_bounds.getX() / grid_tile_width_);
+        
+        for (int tile_row = first_tile_row;
+             roundToInt(tile_row * grid_tile_height_) < dirty_grid_bounds.getBottom();
+             tile_row++)
+        {
+            for (int tile_column = first_tile_column;
+                 roundToInt(tile_column * grid_tile_width_) < dirty_grid_bounds.getRight();
+                 tile_column++)
+            {
+                g.drawImageAt (grid_tile_image_,
+                               roundToInt(tile_column * grid_tile_width_),
+                               roundToInt(tile_row * grid_tile_height_));
+            }
+        }
     }
     
-    grid_step_x = -(getWidth() / 2) + 2;
-    grid_step_y = -(getHeight() / 2) + 336;
+    int border_width = 16 * 8 * 24 * properties_->tick_to_pixel_x_factor_;
+    int border_height = properties_->step_height_ * num_midi_notes_;
+    
+    g.setColour (Colours::darkgrey);
+    
+    g.drawRect(0.0f,
+               0.0f,
+               (float)border_width,
+               (float)border_height,
+               2.0);
+}
+
+void NoteGridComponent::drawComponent (Graphics& g)
+{
+    drawGridBackground(g);
+    
+    drawNotes(g);
     
     g.setColour (Colours::white);
     
@@ -734,8 +895,8 @@ void NoteGridComponent::drawComponent (Graphics& g)
                       "Selected Note: " + String(selected_note_num_)
                       + "\nNote On Time: " + String(selected_note_on_time_)
                       + "\nNote Off Time: " + String(selected_note_off_time_),
-                      (float)grid_step_x,
-                      (float)grid_step_y,
+                      2.0f,
+                      336.0f,
                       128, 128, Justification::topLeft, 3);
     
     ga.draw (g);
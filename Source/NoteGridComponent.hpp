@@ -16,19 +16,32 @@
 #include "../JuceLibraryCode/JuceHeader.h"
 
 #include "NoteGridProperties.hpp"
+#include "NoteGridRowIndex.hpp"
+#include "MidiClipModel.hpp"
 
 #include "MidiClockUtilities.hpp"
 
 using std::vector;
 
 class NoteGridViewport;
-class NoteComponent;
-class NoteComponentSorter;
+
+// pixels at either end of a note that grab its edge for resizing
+const int NOTE_RESIZE_EDGE_WIDTH = 2;
+// smallest side of a cached grid background tile, in pixels
+const int NOTE_GRID_TILE_SIZE = 256;
 
 //==============================================================================
+// Shows and edits the notes of a MidiClipModel. The grid keeps a plain copy
+// of the clip's notes, in the clip's order, and paints the visible ones
+// itself; mouse handling hit-tests against that copy through a per row
+// interval index. A drag or resize edits the copy and is committed to the
+// clip as one transaction at mouse up; clip changes that arrive meanwhile
+// (a file still loading) are picked up after that. Notes are identified by their index,
+// which the lasso selection uses.
 class NoteGridComponent  :  public GraphicsComponentBase,
                             public ChangeListener,
-                            public LassoSource<NoteComponent*>
+                            public LassoSource<int>,
+                            public MidiClipModel::Listener
 {
 public:
     enum GridResolution {
@@ -44,13 +57,16 @@ public:
         EightBar
     };
     
-    NoteGridComponent(NoteGridProperties* properties, NoteGridViewport* viewport);
+    NoteGridComponent(NoteGridProperties* properties,
+                      NoteGridViewport* viewport,
+                      MidiClipModel* clip_model);
     ~NoteGridComponent();
     
     void mouseMove(const MouseEvent& e) override;
     void mouseUp (const MouseEvent& e) override;
     void mouseDown (const MouseEvent& e) override;
     void mouseDrag (const MouseEvent& e) override;
+    MouseCursor getMouseCursor() override;
     bool mouseGridStepPosition(int &x, int &y);
     void setParentNoteGridViewport(NoteGridViewport* viewport);
     void drawComponent (Graphics& g) override;
@@ -58,46 +74,42 @@ public:
     bool keyStateChanged(bool isKeyDown) override;
     void modifierKeysChanged(const ModifierKeys &modifiers) override;
     
-    bool isNoteSelected(NoteComponent* note_component);
-    void setSelectedNote(NoteComponent* note_component);
+    int getNumNotes() const { return notes_.size(); }
+    const MIDINote& getMidiNote(int note_index) const { return notes_.getReference(note_index).midi_note; }
+    
+    // the topmost note under x, y (or -1), and which part of it was hit
+    int getNoteAt(int x, int y, int& mouse_mode);
+    Rectangle<int> getNoteBounds(const MIDINote& note) const;
+    
+    bool isNoteSelected(int note_index);
+    void setSelectedNote(int note_index);
     void initSelectedNotes();
     void clearSelectedNotes();
     
-    void removeNoteComponent(NoteComponent* note_component, bool delete_note = true);
-    void removeSelectedNotes(bool delete_note = true);
-    
-    void dragSelectedNotes(const MouseEvent& e,
-                           NoteComponent* dragged_note,
-                           int y_drag_compensation);
-    void doDragSelectedNotes();
-
-    void resizeSelectedNotes(const MouseEvent& e,
-                           NoteComponent* resize_note,
-                           int y_resize_compensation);
-    void doResizeSelectedNotes();
-
-    void startDrag();
-    void endDrag();
+    void removeNote(int note_index);
+    void removeSelectedNotes();
     
-    void setResizeDownWidth(int width) { resize_down_width_ = width; };
+    void dragSelectedNotes(const MouseEvent& e);
+    void resizeSelectedNotes(const MouseEvent& e);
     
     void updateSelectedNotes();
-    void updateNoteComponentBounds(NoteComponent* note_component);
     
-    void flushNoteRemovePool();
+    // writes moved, resized and removed notes back to the clip
+    void commitNoteEdits();
     
     int getNoteNum(int y);
     int getNoteOnTime(int x);
     int getNoteOffTime(int note_on_time, int width);
-
-    bool doesNoteOverlap(MIDINote& selected_note,
-                         MIDINote& check_note,
+    
+    bool doesNoteOverlap(const MIDINote& selected_note,
+                         const MIDINote& check_note,
                          bool debug_print = false);
     
-    void findLassoItemsInArea (Array <NoteComponent*>& results, const Rectangle<int>& area) override;
-    SelectedItemSet<NoteComponent*>& getLassoSelection() override;
+    void findLassoItemsInArea (Array <int>& results, const Rectangle<int>& area) override;
+    SelectedItemSet<int>& getLassoSelection() override;
     void changeListenerCallback(ChangeBroadcaster*) override;
-
+    void clipNotesChanged(MidiClipModel* clip_model) override;
+    
     MouseCursor& getDrawModeCursor() { return draw_mode_mouse_cursor_; };
     MouseCursor& getEraseModeCursor() { return erase_mode_mouse_cursor_; };
     
@@ -108,46 +120,89 @@ public:
     bool getEraseMode() { return erase_mode_; };
     
 private:
-    const MidiMessageSequence* midi_msg_seq;
+    struct GridNote
+    {
+        int note_id;
+        MIDINote midi_note;
+        // where the note was when the current drag or resize started
+        MIDINote mouse_down_note;
+        bool selected;
+        // covered by a dragged note: removed at mouse up unless uncovered
+        bool hidden;
+    };
+    
+    // keeps GridNote::selected in step with the lasso selection
+    class NoteSelection : public SelectedItemSet<int>
+    {
+    public:
+        NoteSelection(NoteGridComponent& note_grid) : note_grid_(note_grid) {};
+        
+        void itemSelected(int note_index) override { note_grid_.setNoteSelectedFlag(note_index, true); };
+        void itemDeselected(int note_index) override { note_grid_.setNoteSelectedFlag(note_index, false); };
+        
+    private:
+        NoteGridComponent& note_grid_;
+    };
+    
+    void setNoteSelectedFlag(int note_index, bool selected);
+    // every note whose row and time range can reach area, hidden ones too
+    void findNotesInArea(const Rectangle<int>& area, Array<int>& results);
+    // all note changes go through here to keep the row index current
+    void moveNote(int note_index, const MIDINote& midi_note);
+    void rebuildRowIndex();
+    // replaces the grid's notes with the clip's, keeping the selection
+    void loadNotesFromClip();
+    void drawNotes(Graphics& g);
+    void createGridTileImage();
+    void drawGridBackground(Graphics& g);
+    
+    MidiClipModel* clip_model_;
     
     // row major format
     vector<vector<int>> grid_values;
     
-    OwnedArray<NoteComponent> note_components;
-    OwnedArray<NoteComponent> note_remove_pool;
-    OwnedArray<NoteComponent> selected_note_components_;
+    Array<GridNote> notes_;
+    NoteGridRowIndex row_index_;
+    // notes covered by the selection during a drag
+    Array<int> hidden_notes_;
+    
+    // whole grid cells at the current step size, tiled to paint the grid;
+    // the tile's exact size, which the image rounds up
+    Image grid_tile_image_;
+    float grid_tile_width_;
+    float grid_tile_height_;
     
     // MIDI File properties
     BarBeatTime clip_length;
     
-    ComponentBoundsConstrainer* component_bounds;
-    
     NoteGridViewport* grid_viewport;
     NoteGridProperties* properties_;
     
-    NoteComponentSorter* note_sorter_;
-
     int selected_note_num_;
     int selected_note_on_time_;
     int selected_note_off_time_;
-  
-    MIDINote selected_note_;
     
-    LassoComponent<NoteComponent*> note_lasso_;
-    SelectedItemSet<NoteComponent*> selected_notes_;
+    MIDINote selected_note_;
     
-    NoteComponent* dragged_note_;
-    int drag_x_distance_;
-    int drag_y_distance_;
-    int drag_y_compensation_;
-    int note_grid_viewpos_x_;
-
-    NoteComponent* resized_note_;
-    int resize_x_distance_;
-    int resize_y_distance_;
-    int resize_y_compensation_;
-    int resize_grid_viewpos_x_;
-    int resize_down_width_;
+    LassoComponent<int> note_lasso_;
+    NoteSelection selected_notes_;
+    
+    // the note being dragged or resized, -1 while lassoing
+    int mouse_down_note_;
+    int mouse_down_mode_;
+    int hover_mouse_mode_;
+    
+    // the clip's id epoch when notes_ was copied from it
+    int notes_id_epoch_;
+    // set when the clip changes while mouse_down_note_ is being edited;
+    // the copy is reloaded once the edit is committed
+    bool clip_changed_during_edit_;
+    
+    // how far the selection can move before a note leaves the grid
+    int drag_min_note_on_time_;
+    int drag_min_note_num_;
+    int drag_max_note_num_;
+    int drag_min_note_length_;
     
     bool draw_mode_;
     bool erase_mode_;
@@ -21,10 +21,10 @@ properties_(NoteGridProperties())
     grid_viewport = new NoteGridViewport();
     addAndMakeVisible(grid_viewport);
     
-    note_grid = new NoteGridComponent(&properties_, grid_viewport);
+    note_grid = new NoteGridComponent(&properties_, grid_viewport, &clip_model_);
     grid_viewport->setNoteGrid(note_grid);
     addAndMakeVisible(note_grid);
-
+    
     grid_viewport->setViewedComponent(note_grid);
     grid_viewport->setScrollBarsShown(false, false, true, true);
     
@@ -43,16 +43,25 @@ properties_(NoteGridProperties())
     properties_.note_grid_ruler_component_ = grid_ruler;
     properties_.note_grid_editor_component_ = this;
     
+    clip_loader_ = new MidiClipLoader(clip_model_);
 }
 
 NoteGridEditorComponent::~NoteGridEditorComponent()
 {
+    clip_loader_ = nullptr;
+    
     delete note_grid;
     
     delete grid_viewport;
     delete ruler_viewport;
 }
 
+void NoteGridEditorComponent::loadMidiFile(const File& midi_file)
+{
+    // the notes fill in as the loader reads them
+    clip_loader_->loadFile(midi_file);
+}
+
 void NoteGridEditorComponent::resized()
 {
     grid_ruler->setBounds(0, 0, 10000, 48);
@@ -19,6 +19,8 @@
 #include "../JuceLibraryCode/JuceHeader.h"
 
 #include "NoteGridProperties.hpp"
+#include "MidiClipModel.hpp"
+#include "MidiClipLoader.hpp"
 #include "MidiClockUtilities.hpp"
 
 using std::vector;
@@ -48,6 +50,9 @@ public:
     NoteGridEditorComponent ();
     ~NoteGridEditorComponent();
     
+    // replaces the clip with the file's notes, read in the background
+    void loadMidiFile(const File& midi_file);
+    
     void resized() override;
     void mouseDrag(const MouseEvent& e) override;
     void mouseMove(const MouseEvent& e) override;
@@ -63,6 +68,8 @@ private:
     ComponentBoundsConstrainer* component_bounds;
     
     NoteGridProperties properties_;
+    MidiClipModel clip_model_;
+    ScopedPointer<MidiClipLoader> clip_loader_;
     
     NoteGridComponent* note_grid;
     NoteGridRulerComponent* grid_ruler;
@@ -31,6 +31,17 @@ public:
     {
     }
     
+    bool operator==(const MIDINote& other) const
+    {
+        return note_num_ == other.note_num_
+            && velocity_ == other.velocity_
+            && note_on_time_ == other.note_on_time_
+            && note_off_time_ == other.note_off_time_
+            && channel_ == other.channel_;
+    }
+    
+    bool operator!=(const MIDINote& other) const { return !operator==(other); }
+    
     int note_num_;
     int velocity_;
     int note_on_time_;
@@ -61,20 +72,32 @@ public:
     : num_steps_(num_steps),
     num_rows_(num_rows),
     grid_thickness_(grid_thickness),
+    step_width_(0.0f),
+    step_height_(0.0f),
     grid_resolution_(grid_resolution),
     tick_to_pixel_x_factor_(tick_to_pixel_x_factor),
     tick_to_pixel_y_factor_(tick_to_pixel_y_factor),
     division_ppq_(division_ppq),
-    init_grid_(init_grid)
+    init_grid_(init_grid),
+    note_grid_component_(NULL),
+    note_grid_ruler_component_(NULL),
+    note_grid_editor_component_(NULL)
     {
         updateGridProperties();
     }
     
     void updateGridProperties()
     {
-        step_width_ = division_ppq_ * tick_to_pixel_x_factor_;
-        step_height_ = division_ppq_ * tick_to_pixel_y_factor_;
-        init_grid_ = true;
+        const float step_width = division_ppq_ * tick_to_pixel_x_factor_;
+        const float step_height = division_ppq_ * tick_to_pixel_y_factor_;
+        
+        // the grid's cached background is only redrawn for a new step size
+        if (step_width != step_width_ || step_height != step_height_)
+        {
+            step_width_ = step_width;
+            step_height_ = step_height;
+            init_grid_ = true;
+        }
         
         if (note_grid_component_)
         {
@@ -0,0 +1,139 @@
+//
+//  NoteGridRowIndex.cpp
+//  Midiot
+//
+//  Created by Sean Bratnober on 3/2/18.
+//
+//
+
+#include "NoteGridRowIndex.hpp"
+
+NoteGridRowIndex::NoteGridRowIndex()
+{
+    clear();
+}
+
+NoteGridRowIndex::~NoteGridRowIndex()
+{
+}
+
+void NoteGridRowIndex::clear()
+{
+    for (int i=0; i<num_midi_notes_; i++)
+    {
+        rows_[i].clearQuick();
+        max_note_lengths_[i] = 0;
+    }
+}
+
+int NoteGridRowIndex::findFirstEntry(const Array<RowEntry>& row, int note_on_time) const
+{
+    int start = 0;
+    int end = row.size();
+    
+    while (start < end)
+    {
+        const int middle = (start + end) / 2;
+        
+        if (row.getReference(middle).note_on_time < note_on_time)
+        {
+            start = middle + 1;
+        }
+        else
+        {
+            end = middle;
+        }
+    }
+    
+    return start;
+}
+
+void NoteGridRowIndex::addNote(int note_index, const MIDINote& note)
+{
+    if (!isPositiveAndBelow(note.note_num_, num_midi_notes_))
+    {
+        return;
+    }
+    
+    Array<RowEntry>& row = rows_[note.note_num_];
+    
+    RowEntry entry;
+    entry.note_on_time = note.note_on_time_;
+    entry.note_off_time = note.note_off_time_;
+    entry.note_index = note_index;
+    
+    // after any notes starting at the same time, so they keep their order
+    row.insert(findFirstEntry(row, note.note_on_time_ + 1), entry);
+    
+    max_note_lengths_[note.note_num_] = jmax(max_note_lengths_[note.note_num_],
+                                             note.note_off_time_ - note.note_on_time_);
+}
+
+void NoteGridRowIndex::removeNote(int note_index, const MIDINote& note)
+{
+    if (!isPositiveAndBelow(note.note_num_, num_midi_notes_))
+    {
+        return;
+    }
+    
+    Array<RowEntry>& row = rows_[note.note_num_];
+    
+    for (int i = findFirstEntry(row, note.note_on_time_);
+         i < row.size() && row.getReference(i).note_on_time == note.note_on_time_;
+         i++)
+    {
+        if (row.getReference(i).note_index == note_index)
+        {
+            const RowEntry& entry = row.getReference(i);
+            const bool was_longest = (entry.note_off_time - entry.note_on_time >= max_note_lengths_[note.note_num_]);
+            
+            row.remove(i);
+            
+            if (was_longest)
+            {
+                // otherwise every later query still walks back past it
+                int max_note_length = 0;
+                
+                for (int j=0; j<row.size(); j++)
+                {
+                    max_note_length = jmax(max_note_length,
+                                           row.getReference(j).note_off_time - row.getReference(j).note_on_time);
+                }
+                
+                max_note_lengths_[note.note_num_] = max_note_length;
+            }
+            
+            return;
+        }
+    }
+    
+    jassertfalse; // the note wasn't added at this position
+}
+
+void NoteGridRowIndex::findNotes(int note_num, int start_time, int end_time, Array<int>& results) const
+{
+    if (!isPositiveAndBelow(note_num, num_midi_notes_))
+    {
+        return;
+    }
+    
+    const Array<RowEntry>& row = rows_[note_num];
+    
+    // nothing starting earlier than this can reach start_time
+    for (int i = findFirstEntry(row, start_time - max_note_lengths_[note_num]);
+         i < row.size();
+         i++)
+    {
+        const RowEntry& entry = row.getReference(i);
+        
+        if (entry.note_on_time > end_time)
+        {
+            break;
+        }
+        
+        if (entry.note_off_time >= start_time)
+        {
+            results.add(entry.note_index);
+        }
+    }
+}
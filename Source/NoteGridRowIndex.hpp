@@ -0,0 +1,57 @@
+//
+//  NoteGridRowIndex.hpp
+//  Midiot
+//
+//  Created by Sean Bratnober on 3/2/18.
+//
+//
+
+#ifndef NoteGridRowIndex_hpp
+#define NoteGridRowIndex_hpp
+
+#include <stdio.h>
+#include "../JuceLibraryCode/JuceHeader.h"
+
+#include "NoteGridProperties.hpp"
+
+// Per note number interval index over the note grid's notes: each row
+// keeps its notes sorted by note on time, along with the length of its
+// longest note, so a time range query is a binary search plus a walk
+// over the notes that can reach it. Notes are identified by the index
+// the grid gives them, and must be removed with the position they were
+// added at before they move.
+class NoteGridRowIndex
+{
+public:
+    NoteGridRowIndex();
+    ~NoteGridRowIndex();
+    
+    void clear();
+    
+    void addNote(int note_index, const MIDINote& note);
+    void removeNote(int note_index, const MIDINote& note);
+    
+    // Adds the notes of one row that touch [start_time, end_time], ends
+    // included, in note on order. Callers wanting exact overlap rules
+    // test the results themselves.
+    void findNotes(int note_num, int start_time, int end_time, Array<int>& results) const;
+    
+private:
+    struct RowEntry
+    {
+        int note_on_time;
+        int note_off_time;
+        int note_index;
+    };
+    
+    // the first entry in the row with a note on at or after note_on_time
+    int findFirstEntry(const Array<RowEntry>& row, int note_on_time) const;
+    
+    Array<RowEntry> rows_[num_midi_notes_];
+    // rescanned when a row loses its longest note
+    int max_note_lengths_[num_midi_notes_];
+    
+    JUCE_DECLARE_NON_COPYABLE(NoteGridRowIndex)
+};
+
+#endif /* NoteGridRowIndex_hpp */
@@ -192,9 +192,18 @@ void NoteGridTabComponent::buttonClicked (Button* button)
 {
     if (button == &readMidiFileButton)
     {
+        FileChooser midi_file_chooser("Read MIDI File", File(), "*.mid;*.midi");
+        
+        if (!midi_file_chooser.browseForFileToOpen())
+        {
+            return;
+        }
+        
         //postMessageToList()
         logMessage(String("Reading MIDI File..."));
-        File midiFile = File::createFileWithoutCheckingPath (String("/Users/seanb/Development/JUCE/Midiot/Resources/basic808.mid"));
+        File midiFile = midi_file_chooser.getResult();
+        note_grid_editor.loadMidiFile(midiFile);
+        
         FileInputStream midiStream (midiFile);
         inputMidiFile.readFrom (midiStream);
         